@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <variant>
 
 namespace lualike::ast {
 
@@ -17,6 +18,84 @@ void AppendIndent(std::ostream* out, int indent) {
   }
 }
 
+void ShiftSpan(token::SourceSpan& span, size_t shift) {
+  span.begin += shift;
+  span.end += shift;
+}
+
+void ShiftSpans(Expression& expr, size_t shift);
+void ShiftSpans(Block& block, size_t shift);
+
+void ShiftSpans(LiteralExpression& /*expr*/, size_t /*shift*/) {}
+void ShiftSpans(VariableExpression& /*expr*/, size_t /*shift*/) {}
+
+void ShiftSpans(UnaryExpression& expr, size_t shift) {
+  ShiftSpans(*expr.rhs, shift);
+}
+
+void ShiftSpans(BinaryExpression& expr, size_t shift) {
+  ShiftSpans(*expr.lhs, shift);
+  ShiftSpans(*expr.rhs, shift);
+}
+
+void ShiftSpans(FunctionCallExpression& expr, size_t shift) {
+  ShiftSpans(*expr.callee, shift);
+  for (auto& arg : expr.arguments) {
+    ShiftSpans(arg, shift);
+  }
+}
+
+void ShiftSpans(Expression& expr, size_t shift) {
+  ShiftSpan(expr.span, shift);
+  std::visit([shift](auto& node) { ShiftSpans(node, shift); }, expr.node);
+}
+
+void ShiftSpans(ExpressionStatement& stmt, size_t shift) {
+  ShiftSpans(stmt.expression, shift);
+}
+
+void ShiftSpans(ReturnStatement& stmt, size_t shift) {
+  if (stmt.expression) {
+    ShiftSpans(*stmt.expression, shift);
+  }
+}
+
+void ShiftSpans(VariableDeclaration& stmt, size_t shift) {
+  if (stmt.initializer) {
+    ShiftSpans(*stmt.initializer, shift);
+  }
+}
+
+void ShiftSpans(Assignment& stmt, size_t shift) {
+  ShiftSpans(stmt.value, shift);
+}
+
+void ShiftSpans(IfStatement& stmt, size_t shift) {
+  ShiftSpans(stmt.condition, shift);
+  ShiftSpans(*stmt.then_branch, shift);
+  if (stmt.else_branch) {
+    ShiftSpans(*stmt.else_branch, shift);
+  }
+}
+
+void ShiftSpans(FunctionDeclaration& stmt, size_t shift) {
+  ShiftSpans(*stmt.body, shift);
+}
+
+void ShiftSpans(Block& block, size_t shift) {
+  ShiftSpan(block.span, shift);
+  for (auto& stmt : block.statements) {
+    ast::ShiftSpans(stmt, shift);
+  }
+}
+
+}  // namespace
+
+void ShiftSpans(Statement& stmt, size_t shift) {
+  ShiftSpan(stmt.span, shift);
+  std::visit([shift](auto& node) { ShiftSpans(node, shift); }, stmt.node);
+}
+
 std::string_view UnaryOperatorToString(UnaryOperator oper) {
   switch (oper) {
     case UnaryOperator::kNegate:
@@ -67,8 +146,6 @@ std::string_view BinaryOperatorToString(BinaryOperator oper) {
   }
 }
 
-}  // namespace
-
 void PrintTo(const LiteralExpression& expr, std::ostream* out, int indent) {
   AppendIndent(out, indent);
   std::println(*out, "LiteralExpression: {}", expr.value.ToString());
@@ -3,12 +3,17 @@
 
 #include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <optional>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include "lualike/interned_string.h"
 #include "lualike/token.h"
 #include "lualike/value.h"
 
@@ -18,6 +23,46 @@ struct Expression;
 struct Statement;
 struct Block;
 
+// Monotonic storage that a whole Program can be allocated in, see
+// parser::ParseOptions::use_arena.
+using Arena = std::pmr::monotonic_buffer_resource;
+
+// Deleter of the owning node pointers of the tree. Nodes allocated in an Arena
+// are only destroyed, their memory is released together with the arena.
+struct NodeDeleter {
+  bool in_arena = false;
+
+  NodeDeleter() noexcept = default;
+  explicit NodeDeleter(bool in_arena) noexcept : in_arena(in_arena) {}
+  // Allows adopting nodes created with std::make_unique.
+  template <typename T>
+  NodeDeleter(std::default_delete<T> /*unused*/) noexcept {}  // NOLINT
+
+  template <typename T>
+  void operator()(T* node) const noexcept {
+    if (in_arena) {
+      node->~T();
+    } else {
+      delete node;
+    }
+  }
+};
+
+template <typename T>
+using NodePtr = std::unique_ptr<T, NodeDeleter>;
+
+// Creates a node in `arena`, or on the heap if there is none.
+template <typename T, typename... ArgsT>
+NodePtr<T> MakeNode(Arena* arena, ArgsT&&... args) {
+  if (arena == nullptr) {
+    return NodePtr<T>(new T(std::forward<ArgsT>(args)...));
+  }
+
+  void* const memory = arena->allocate(sizeof(T), alignof(T));
+  return NodePtr<T>(new (memory) T(std::forward<ArgsT>(args)...),
+                    NodeDeleter(true));
+}
+
 enum class UnaryOperator : uint8_t { kNegate, kNot };
 enum class BinaryOperator : uint8_t {
   kOr,
@@ -37,27 +82,39 @@ enum class BinaryOperator : uint8_t {
   kPower,
 };
 
+// Location of a block-local variable, computed by resolver::Resolve: the
+// number of enclosing blocks to walk up from the block the access happens in,
+// and the index of the variable within that block's slots.
+struct LocalSlot {
+  uint32_t depth{};
+  uint32_t index{};
+
+  bool operator==(const LocalSlot& rhs) const = default;
+};
+
 struct LiteralExpression {
   value::LualikeValue value;
 };
 
 struct VariableExpression {
-  std::string name;
+  value::InternedString name;
+  // Unset for globals, which are looked up by name at runtime.
+  std::optional<LocalSlot> slot;
 };
 
 struct UnaryExpression {
   UnaryOperator op;
-  std::unique_ptr<Expression> rhs;
+  NodePtr<Expression> rhs;
 };
 
 struct BinaryExpression {
   BinaryOperator op;
-  std::unique_ptr<Expression> lhs;
-  std::unique_ptr<Expression> rhs;
+  NodePtr<Expression> lhs;
+  NodePtr<Expression> rhs;
 };
 
 struct FunctionCallExpression {
-  std::unique_ptr<Expression> callee;
+  NodePtr<Expression> callee;
   std::vector<Expression> arguments;
 };
 
@@ -77,8 +134,13 @@ struct ReturnStatement {
 };
 
 struct VariableDeclaration {
-  std::string name;
+  value::InternedString name;
   std::optional<Expression> initializer;
+  // Whether the declaration starts with `local`. Only those introduce a new
+  // variable in a nested block; the others assign the visible one.
+  bool is_local = false;
+  // Unset when the declaration binds a global.
+  std::optional<LocalSlot> slot;
 };
 
 struct Assignment {
@@ -88,14 +150,17 @@ struct Assignment {
 
 struct IfStatement {
   Expression condition;
-  std::unique_ptr<Block> then_branch;
-  std::unique_ptr<Block> else_branch;
+  NodePtr<Block> then_branch;
+  NodePtr<Block> else_branch;
 };
 
 struct FunctionDeclaration {
-  std::string name;
-  std::vector<std::string> params;
-  std::unique_ptr<Block> body;
+  value::InternedString name;
+  // Bound to the first slots of the body, in order.
+  std::vector<value::InternedString> params;
+  NodePtr<Block> body;
+  // Unset when the declaration binds a global.
+  std::optional<LocalSlot> slot;
 };
 
 struct Statement {
@@ -108,9 +173,27 @@ struct Statement {
 struct Block {
   std::vector<Statement> statements;
   token::SourceSpan span;
+  // Number of local slots declared directly in this block.
+  uint32_t slot_count{};
+};
+
+struct ProgramArena {
+  // Owns the nodes of a program parsed in arena mode. Kept in a base class of
+  // Program so that it is destroyed after the nodes of the Block.
+  std::unique_ptr<Arena> arena;
+  // The arenas of the parts of a program that was parsed in parallel.
+  std::vector<std::unique_ptr<Arena>> part_arenas;
 };
 
-using Program = Block;
+// Nodes moved out of an arena-allocated program must not outlive it.
+struct Program : ProgramArena, Block {};
+
+std::string_view UnaryOperatorToString(UnaryOperator oper);
+std::string_view BinaryOperatorToString(BinaryOperator oper);
+
+// Moves every span in the statement by `shift` bytes, which wraps around to
+// move them backwards.
+void ShiftSpans(Statement& stmt, size_t shift);
 
 std::string ToString(const Expression& expr);
 std::string ToString(const Statement& stmt);
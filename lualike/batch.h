@@ -0,0 +1,106 @@
+#ifndef LUALIKE_BATCH_H_
+#define LUALIKE_BATCH_H_
+
+#include <cstddef>
+#include <expected>
+#include <format>
+#include <optional>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "lualike/error.h"
+#include "lualike/interpreter.h"
+#include "lualike/runtime.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+// The values of one global for every row of a batch, viewed in the caller's
+// memory.
+struct InputColumn {
+  value::InternedString name;
+  std::variant<std::span<const value::LualikeValue::IntT>,
+               std::span<const value::LualikeValue::FloatT>,
+               std::span<const value::LualikeValue::StringT>>
+      values;
+
+  size_t Size() const noexcept {
+    return std::visit([](const auto& column) { return column.size(); },
+                      values);
+  }
+
+  value::LualikeValue operator[](size_t row) const {
+    return std::visit(
+        [row](const auto& column) { return value::LualikeValue{column[row]}; },
+        values);
+  }
+};
+
+// Runs `program` once for every row of `columns`, which all have to have the
+// same number of rows, with the global named by each column set to its value
+// in the row. Returns what each row returned, or the error of the first row
+// that failed.
+//
+// Every row starts out with `globals`, which the batch doesn't modify: the
+// rows run in one fork of them, with the inputs bound once and assigned in
+// place for each row, and only the globals a row sets are reset after it.
+inline std::expected<std::vector<std::optional<value::LualikeValue>>,
+                     error::Error>
+RunBatch(const CompiledProgram& program, std::span<const InputColumn> columns,
+         const Scope& globals) noexcept {
+  const size_t row_count = columns.empty() ? 0 : columns.front().Size();
+  for (const auto& column : columns) {
+    if (column.Size() != row_count) {
+      return std::unexpected(error::Error::Message(
+          std::format("Input column '{}' has {} rows instead of {}",
+                      column.name, column.Size(), row_count)));
+    }
+  }
+
+  try {
+    std::vector<std::optional<value::LualikeValue>> results;
+    results.reserve(row_count);
+
+    // The inputs are bound before the snapshot, so that restoring it only
+    // touches the globals the rows set themselves.
+    const auto row_globals = globals.Fork();
+    std::vector<value::LualikeValue*> inputs;
+    inputs.reserve(columns.size());
+    for (const auto& column : columns) {
+      inputs.push_back(&row_globals->Bind(column.name, {}));
+    }
+    row_globals->TakeSnapshot();
+
+    for (size_t row = 0; row < row_count; ++row) {
+      for (size_t column = 0; column < columns.size(); ++column) {
+        *inputs[column] = columns[column][row];
+      }
+
+      auto result = program.Run(row_globals);
+      if (!result) {
+        return std::unexpected(std::move(result).error().Wrap(
+            std::format("Failed to evaluate row {}", row)));
+      }
+      results.push_back(std::move(result).value());
+      row_globals->RestoreSnapshot();
+    }
+
+    return results;
+  } catch (const std::exception&) {
+    return std::unexpected(
+        error::Error::FromCurrentException("Failed to run batch"));
+  }
+}
+
+inline std::expected<std::vector<std::optional<value::LualikeValue>>,
+                     error::Error>
+RunBatch(const CompiledProgram& program,
+         std::span<const InputColumn> columns) noexcept {
+  return RunBatch(program, columns, Scope{});
+}
+
+}  // namespace lualike::interpreter
+
+#endif  // LUALIKE_BATCH_H_
@@ -0,0 +1,40 @@
+#include "lualike/benchmarks/allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> allocation_count{0};
+
+}  // namespace
+
+// Counts every heap allocation of the benchmark binary.
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* const memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+
+  throw std::bad_alloc();
+}
+
+// Not inlined, so that the compiler does not pair inlined frees with
+// new-expressions and warn about mismatched deallocation.
+[[gnu::noinline]] void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+[[gnu::noinline]] void operator delete(void* memory,
+                                       size_t /*unused*/) noexcept {
+  std::free(memory);
+}
+
+namespace lualike::benchmarks {
+
+size_t AllocationCount() noexcept {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+}  // namespace lualike::benchmarks
@@ -0,0 +1,13 @@
+#ifndef LUALIKE_BENCHMARKS_ALLOCATION_COUNTER_H_
+#define LUALIKE_BENCHMARKS_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace lualike::benchmarks {
+
+// Number of heap allocations made by the benchmark binary so far.
+size_t AllocationCount() noexcept;
+
+}  // namespace lualike::benchmarks
+
+#endif  // LUALIKE_BENCHMARKS_ALLOCATION_COUNTER_H_
@@ -0,0 +1,103 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lualike/batch.h"
+#include "lualike/benchmarks/allocation_counter.h"
+#include "lualike/interpreter.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+namespace {
+
+constexpr size_t kRows = 10'000;
+
+constexpr std::string_view kRule =
+    "local total = price * quantity\n"
+    "if country == 'DE' then total = total * 1.19 end\n"
+    "if total > 1000 then total = 1000 end\n"
+    "return total";
+
+struct Orders {
+  std::vector<value::LualikeValue::FloatT> prices;
+  std::vector<value::LualikeValue::IntT> quantities;
+  std::vector<value::LualikeValue::StringT> countries;
+
+  Orders() {
+    constexpr std::array<std::string_view, 3> kCountries = {"DE", "FR", "US"};
+    for (size_t row = 0; row < kRows; ++row) {
+      prices.push_back(static_cast<double>(row % 100) + 0.5);
+      quantities.push_back(static_cast<int64_t>(row % 7) + 1);
+      countries.emplace_back(kCountries[row % kCountries.size()]);
+    }
+  }
+};
+
+// Evaluates the rule for every order either by interpreting a script that
+// sets the inputs first (mode 0), by running the rule compiled for the given
+// engine against fresh globals per row (mode 1), or with RunBatch (mode 2).
+void BM_EvaluateRows(benchmark::State& state) {
+  const Orders orders;
+  const auto program = Compile(kRule, static_cast<Engine>(state.range(1)));
+  if (!program) {
+    state.SkipWithError("failed to compile");
+    return;
+  }
+  const std::array<InputColumn, 3> columns = {
+      InputColumn{"price", orders.prices},
+      InputColumn{"quantity", orders.quantities},
+      InputColumn{"country", orders.countries}};
+
+  const auto mode = state.range(0);
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const auto before = benchmarks::AllocationCount();
+    if (mode == 0) {
+      for (size_t row = 0; row < kRows; ++row) {
+        auto result = Interpret(std::format(
+            "price = {}\nquantity = {}\ncountry = '{}'\n{}",
+            orders.prices[row], orders.quantities[row], orders.countries[row],
+            kRule));
+        benchmark::DoNotOptimize(result);
+      }
+    } else if (mode == 1) {
+      for (size_t row = 0; row < kRows; ++row) {
+        const auto globals = std::make_shared<Scope>();
+        for (const auto& column : columns) {
+          globals->Set(column.name, column[row]);
+        }
+        auto result = program->Run(globals);
+        benchmark::DoNotOptimize(result);
+      }
+    } else {
+      auto results = RunBatch(*program, columns);
+      benchmark::DoNotOptimize(results);
+    }
+    allocations += benchmarks::AllocationCount() - before;
+  }
+
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kRows));
+  state.counters["allocs_per_row"] = benchmark::Counter(
+      static_cast<double>(allocations) / kRows,
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_EvaluateRows)
+    ->ArgNames({"mode", "engine"})
+    ->Args({0, static_cast<int64_t>(Engine::kTreeWalker)})
+    ->ArgsProduct({{1, 2},
+                   {static_cast<int64_t>(Engine::kTreeWalker),
+                    static_cast<int64_t>(Engine::kBytecode),
+                    static_cast<int64_t>(Engine::kFlatTreeWalker)}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+}  // namespace lualike::interpreter
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+
+#include "lualike/error.h"
+#include "lualike/interpreter.h"
+#include "lualike/source.h"
+
+namespace lualike::interpreter {
+
+namespace {
+
+// About 1 MB of source that fails to parse on its first line, so that the
+// benchmarks measure the error path rather than parsing.
+std::string MakeFailingScript() {
+  std::string script = "return 2 whatever\n";
+  while (script.size() < (1U << 20U)) {
+    script += "local generated_variable = 1234 * 5678\n";
+  }
+
+  return script;
+}
+
+void BM_InterpretFailingScriptCopied(benchmark::State& state) {
+  const auto script = MakeFailingScript();
+
+  for (auto _ : state) {
+    auto result = Interpret(std::string_view{script});
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_InterpretFailingScriptCopied);
+
+void BM_InterpretFailingScriptShared(benchmark::State& state) {
+  const auto script = MakeFailingScript();
+  const auto source = source::SourceBuffer::Borrow(script);
+
+  for (auto _ : state) {
+    auto result = Interpret(source);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_InterpretFailingScriptShared);
+
+void BM_CopyError(benchmark::State& state) {
+  const auto script = MakeFailingScript();
+  const auto result = Interpret(std::string_view{script});
+  if (result) {
+    state.SkipWithError("The script did not fail");
+    return;
+  }
+
+  for (auto _ : state) {
+    error::Error copy = result.error();
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_CopyError);
+
+void BM_RenderErrorRepeatedly(benchmark::State& state) {
+  auto script = MakeFailingScript();
+  script.replace(0, script.find('\n'), "-- error at the end");
+  script += "return 2 whatever\n";
+  const auto result = Interpret(source::SourceBuffer::Borrow(script));
+  if (result) {
+    state.SkipWithError("The script did not fail");
+    return;
+  }
+
+  for (auto _ : state) {
+    auto pretty = result.error().RenderPretty();
+    benchmark::DoNotOptimize(pretty);
+  }
+}
+BENCHMARK(BM_RenderErrorRepeatedly);
+
+}  // namespace
+
+}  // namespace lualike::interpreter
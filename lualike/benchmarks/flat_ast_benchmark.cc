@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <format>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "lualike/ast.h"
+#include "lualike/flat_ast.h"
+#include "lualike/interpreter.h"
+#include "lualike/parser.h"
+
+namespace lualike::ast {
+
+namespace {
+
+constexpr int kStatementGroups = 2850;
+
+// About 100k nodes: each group declares a global from a long arithmetic
+// expression and updates it in a nested block.
+std::string MakeLargeScript() {
+  std::string script = "a = 1\nb = 2.5\nc = 3\nd = 4\n";
+  for (int group = 0; group < kStatementGroups; ++group) {
+    script += std::format(
+        "v{0} = (a + {0}) * b - c / 2 + -d * (a - b) // 3\n"
+        "if v{0} > 10 and not (v{0} == 12) or d then v{0} = v{0} - a end\n",
+        group);
+  }
+
+  return script;
+}
+
+size_t CountNodes(const FlatProgram& program) {
+  return program.expressions.kinds.size() + program.statements.kinds.size() +
+         program.blocks.statements.size();
+}
+
+class NullBuffer : public std::streambuf {
+ protected:
+  int_type overflow(int_type ch) override { return ch; }
+  std::streamsize xsputn(const char* /*unused*/,
+                         std::streamsize count) override {
+    return count;
+  }
+};
+
+void RunLargeScript(benchmark::State& state, interpreter::Engine engine) {
+  const auto program = interpreter::Compile(MakeLargeScript(), engine);
+  if (!program) {
+    state.SkipWithError(program.error().what());
+    return;
+  }
+
+  for (auto _ : state) {
+    auto result = program->Run();
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.counters["nodes"] =
+      static_cast<double>(CountNodes(Flatten(program->Program())));
+}
+
+void BM_RunTree(benchmark::State& state) {
+  RunLargeScript(state, interpreter::Engine::kTreeWalker);
+}
+BENCHMARK(BM_RunTree)->Unit(benchmark::kMillisecond);
+
+void BM_RunFlat(benchmark::State& state) {
+  RunLargeScript(state, interpreter::Engine::kFlatTreeWalker);
+}
+BENCHMARK(BM_RunFlat)->Unit(benchmark::kMillisecond);
+
+void BM_PrintTree(benchmark::State& state) {
+  const auto program = parser::Parse(MakeLargeScript());
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+
+  for (auto _ : state) {
+    PrintTo(program.value(), &out);
+  }
+}
+BENCHMARK(BM_PrintTree)->Unit(benchmark::kMillisecond);
+
+void BM_PrintFlat(benchmark::State& state) {
+  const auto flat = Flatten(parser::Parse(MakeLargeScript()).value());
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+
+  for (auto _ : state) {
+    PrintTo(flat, &out);
+  }
+}
+BENCHMARK(BM_PrintFlat)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+}  // namespace lualike::ast
@@ -0,0 +1,231 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "lualike/benchmarks/allocation_counter.h"
+#include "lualike/interpreter.h"
+#include "lualike/state.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+namespace {
+
+// Mirrors the programs exercised by interpreter_test.cc.
+constexpr std::array<std::string_view, 9> kScripts = {
+    "return 1",
+    "return 3.14 * 2",
+    "return 2 + 2 * 2 + -4.0",
+    "return (2 + 2) * 2 + -4.0",
+    "local pi = 3.14",
+    ";;;",
+    "local pi_num = 3.14\n"
+    "return pi_num",
+    "local pi_num = 3.14\n"
+    "if false then pi_num = 1.81 end\n",
+    "cond = true\n"
+    "if cond then\n"
+    "  return 3.14\n"
+    "else\n"
+    "  return -1\n"
+    "end\n",
+};
+
+void BM_Interpret(benchmark::State& state) {
+  const auto script = kScripts[static_cast<size_t>(state.range(0))];
+
+  for (auto _ : state) {
+    auto result = Interpret(script);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Interpret)->DenseRange(0, kScripts.size() - 1);
+
+void BM_CompiledProgramRun(benchmark::State& state) {
+  const auto script = kScripts[static_cast<size_t>(state.range(0))];
+  const auto program = Compile(script);
+  if (!program) {
+    state.SkipWithError(program.error().what());
+    return;
+  }
+
+  for (auto _ : state) {
+    auto result = program->Run();
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_CompiledProgramRun)->DenseRange(0, kScripts.size() - 1);
+
+// A validation rule that probes the type of its input by doing arithmetic on
+// it, run over inputs of which the given percentage are strings and fail.
+void BM_ValidationRuleErrorRate(benchmark::State& state) {
+  const auto program = Compile("return input * 2 + 1");
+  if (!program) {
+    state.SkipWithError(program.error().what());
+    return;
+  }
+
+  const auto error_percent = state.range(0);
+  const auto globals = std::make_shared<Scope>();
+  int64_t run = 0;
+  for (auto _ : state) {
+    if (run % 100 < error_percent) {
+      globals->Set("input", value::LualikeValue{"not a number"});
+    } else {
+      globals->Set("input", value::LualikeValue{run});
+    }
+    ++run;
+
+    auto result = program->Run(globals);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_ValidationRuleErrorRate)->Arg(0)->Arg(10)->Arg(50)->Arg(90);
+
+// Recursive call throughput: fib(30) makes about 2.7 million calls.
+void BM_Fib(benchmark::State& state) {
+  const auto program = Compile(
+      "function fib(n)\n"
+      "  if n < 2 then return n end\n"
+      "  return fib(n - 1) + fib(n - 2)\n"
+      "end\n"
+      "return fib(30)",
+      static_cast<Engine>(state.range(0)));
+  if (!program) {
+    state.SkipWithError(program.error().what());
+    return;
+  }
+
+  for (auto _ : state) {
+    auto result = program->Run();
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Fib)
+    ->ArgName("engine")
+    ->Arg(static_cast<int64_t>(Engine::kTreeWalker))
+    ->Arg(static_cast<int64_t>(Engine::kBytecode))
+    ->Arg(static_cast<int64_t>(Engine::kFlatTreeWalker))
+    ->Unit(benchmark::kMillisecond);
+
+// Enters `depth` nested if blocks, each declaring a local, and reads all of
+// them in the innermost one, so that entering blocks and looking up locals
+// dominate the run.
+std::string MakeNestedIfScript(int64_t depth) {
+  std::string script = "if true then\n  local v0 = 1\n";
+  std::string sum = "v0";
+  for (int64_t level = 1; level < depth; ++level) {
+    script += std::format("if v{} then\n  local v{} = {}\n", level - 1,
+                          level, level + 1);
+    sum += std::format(" + v{}", level);
+  }
+  script += std::format("return {}\n", sum);
+  for (int64_t level = 0; level < depth; ++level) {
+    script += "end\n";
+  }
+
+  return script;
+}
+
+void BM_NestedIfBlocks(benchmark::State& state) {
+  const auto program = Compile(MakeNestedIfScript(state.range(0)),
+                               static_cast<Engine>(state.range(1)));
+  if (!program) {
+    state.SkipWithError(program.error().what());
+    return;
+  }
+
+  const auto globals = std::make_shared<Scope>();
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const auto before = benchmarks::AllocationCount();
+    auto result = program->Run(globals);
+    allocations += benchmarks::AllocationCount() - before;
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.counters["allocs_per_run"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_NestedIfBlocks)
+    ->ArgNames({"depth", "engine"})
+    ->ArgsProduct({{8, 64},
+                   {static_cast<int64_t>(Engine::kTreeWalker),
+                    static_cast<int64_t>(Engine::kFlatTreeWalker)}});
+
+// A prelude of constants and helper functions, and a request handler that
+// uses a few of them.
+std::string MakePrelude() {
+  std::string prelude;
+  for (int index = 0; index < 200; ++index) {
+    prelude += std::format("limit_{0} = {0} * 10\n", index);
+  }
+  for (int index = 0; index < 20; ++index) {
+    prelude += std::format(
+        "function clamp_{0}(x)\n"
+        "  if x > limit_{0} then return limit_{0} end\n"
+        "  return x\n"
+        "end\n",
+        index);
+  }
+
+  return prelude;
+}
+
+constexpr std::string_view kHandler =
+    "local total = clamp_3(request) + clamp_7(request * 2)\n"
+    "result = total\n"
+    "return total";
+
+// Handles requests either by running the prelude against fresh globals every
+// time (reuse 0), by running it once and resetting a State to its snapshot
+// after every request (reuse 1), or by running each request in a fork of the
+// State (reuse 2).
+void BM_RequestWithPrelude(benchmark::State& state) {
+  const auto prelude = Compile(MakePrelude());
+  const auto handler = Compile(kHandler);
+  if (!prelude || !handler) {
+    state.SkipWithError("failed to compile");
+    return;
+  }
+
+  const auto reuse = state.range(0);
+  State lualike_state;
+  if (reuse != 0) {
+    lualike_state.Run(*prelude);
+    lualike_state.Snapshot();
+  }
+
+  int64_t request = 0;
+  for (auto _ : state) {
+    if (reuse == 1) {
+      lualike_state.Globals().Set("request", value::LualikeValue{request});
+      auto result = lualike_state.Run(*handler);
+      benchmark::DoNotOptimize(result);
+      lualike_state.Reset();
+    } else if (reuse == 2) {
+      auto fork = lualike_state.Fork();
+      fork.Globals().Set("request", value::LualikeValue{request});
+      auto result = fork.Run(*handler);
+      benchmark::DoNotOptimize(result);
+    } else {
+      const auto globals = std::make_shared<Scope>();
+      prelude->Run(globals);
+      globals->Set("request", value::LualikeValue{request});
+      auto result = handler->Run(globals);
+      benchmark::DoNotOptimize(result);
+    }
+    ++request;
+  }
+}
+BENCHMARK(BM_RequestWithPrelude)->ArgName("reuse")->DenseRange(0, 2);
+
+}  // namespace
+
+}  // namespace lualike::interpreter
@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "lualike/interpreter.h"
+#include "lualike/isolate.h"
+#include "lualike/state.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+namespace {
+
+constexpr std::string_view kPrelude =
+    "limit = 1000\n"
+    "function fib(n)\n"
+    "  if n < 2 then return n end\n"
+    "  return fib(n - 1) + fib(n - 2)\n"
+    "end\n";
+
+constexpr std::string_view kRule =
+    "local score = fib(request % 12) * 3\n"
+    "if score > limit then score = limit end\n"
+    "return score";
+
+// The prelude and rule every thread of a benchmark shares, one pair per
+// engine.
+struct SharedProgram {
+  State prelude;
+  std::shared_ptr<const CompiledProgram> rule;
+
+  explicit SharedProgram(Engine engine)
+      : prelude(engine),
+        rule(std::make_shared<const CompiledProgram>(
+            Compile(kRule, engine).value())) {
+    prelude.Run(kPrelude);
+  }
+};
+
+const SharedProgram& GetSharedProgram(Engine engine) {
+  static const std::array<SharedProgram, 3> programs = {
+      SharedProgram(Engine::kTreeWalker), SharedProgram(Engine::kBytecode),
+      SharedProgram(Engine::kFlatTreeWalker)};
+  return programs[static_cast<size_t>(engine)];
+}
+
+// Every thread runs the rule against its own isolate of the shared program.
+// items_per_second sums up the requests of all threads, so it grows linearly
+// with the thread count as long as the isolates don't contend.
+void BM_IsolatesInParallel(benchmark::State& state) {
+  const auto& shared =
+      GetSharedProgram(static_cast<Engine>(state.range(0)));
+  Isolate isolate(shared.rule, shared.prelude);
+
+  int64_t request = state.thread_index();
+  for (auto _ : state) {
+    isolate.Globals().Set("request", value::LualikeValue{request});
+    auto result = isolate.Run();
+    benchmark::DoNotOptimize(result);
+    isolate.Reset();
+    ++request;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IsolatesInParallel)
+    ->ArgName("engine")
+    ->Arg(static_cast<int64_t>(Engine::kTreeWalker))
+    ->Arg(static_cast<int64_t>(Engine::kBytecode))
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+}  // namespace
+
+}  // namespace lualike::interpreter
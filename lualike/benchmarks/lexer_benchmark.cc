@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+
+#include "lualike/lexer.h"
+#include "lualike/scanner.h"
+
+namespace lualike::lexer {
+
+namespace {
+
+// A generated script of about 4 MB with indentation, comments, long names,
+// numbers and strings, like the ones produced by our code generators.
+std::string MakeGeneratedScript() {
+  std::string script;
+  for (size_t i = 0; script.size() < (4U << 20U); ++i) {
+    script += std::format(
+        "-- Generated rule {} for the validation of incoming records\n"
+        "if record_field_value_{} >= {}.25 then\n"
+        "        local normalized_value_{} = record_field_value_{} * 1000\n"
+        "        return 'record {} exceeds the configured threshold'\n"
+        "end\n",
+        i, i, i, i, i, i);
+  }
+
+  return script;
+}
+
+void BM_LexGeneratedScript(benchmark::State& state) {
+  const auto isa = static_cast<scanner::Isa>(state.range(0));
+  if (scanner::SetIsa(isa) != isa) {
+    state.SkipWithError("Instruction set is not supported by this CPU");
+    return;
+  }
+
+  const auto script = MakeGeneratedScript();
+  for (auto _ : state) {
+    Lexer lexer(script);
+    size_t tokens = 0;
+    while (lexer.NextToken()) {
+      ++tokens;
+    }
+    benchmark::DoNotOptimize(tokens);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+  scanner::SetIsa(scanner::DetectIsa());
+}
+BENCHMARK(BM_LexGeneratedScript)
+    ->ArgName("isa")
+    ->Arg(static_cast<int64_t>(scanner::Isa::kScalar))
+    ->Arg(static_cast<int64_t>(scanner::Isa::kSse2))
+    ->Arg(static_cast<int64_t>(scanner::Isa::kAvx2));
+
+// Mostly keywords, short names and operators, which leaves little for the
+// scanners to skip and makes token classification dominate.
+std::string MakeKeywordDenseScript() {
+  std::string script;
+  for (size_t i = 0; script.size() < (4U << 20U); ++i) {
+    script += std::format(
+        "if a and not b or c then local x = y elseif d <= e then "
+        "return true else if f ~= nil then return false end end "
+        "local z{} = (x // 2) >= (y % 3) == (w ^ 2)\n",
+        i % 10);
+  }
+
+  return script;
+}
+
+void BM_LexKeywordDenseScript(benchmark::State& state) {
+  const auto script = MakeKeywordDenseScript();
+  size_t tokens = 0;
+  for (auto _ : state) {
+    Lexer lexer(script);
+    tokens = 0;
+    while (lexer.NextToken()) {
+      ++tokens;
+    }
+    benchmark::DoNotOptimize(tokens);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tokens));
+}
+BENCHMARK(BM_LexKeywordDenseScript);
+
+}  // namespace
+
+}  // namespace lualike::lexer
@@ -0,0 +1,253 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "lualike/benchmarks/allocation_counter.h"
+#include "lualike/parser.h"
+#include "lualike/source_file.h"
+
+namespace lualike::parser {
+
+namespace {
+
+constexpr int kStatementGroups = 500;
+
+// Resembles generated scripts: long arithmetic expressions and nested ifs.
+std::string MakeGeneratedScript(int statement_groups = kStatementGroups) {
+  std::string script;
+  for (int group = 0; group < statement_groups; ++group) {
+    script += std::format(
+        "local v{0} = (a + {0}) * b - c / 2 + -d ^ 2 // 3 % 4\n"
+        "if v{0} > 10 and not (v{0} == 12) or flag then\n"
+        "  v{0} = v{0} - 1\n"
+        "else\n"
+        "  if v{0} < 0 then v{0} = 0 end\n"
+        "end\n",
+        group);
+  }
+
+  return script;
+}
+
+void BM_ParseGeneratedScript(benchmark::State& state) {
+  const auto script = MakeGeneratedScript();
+  const ParseOptions options{.use_arena = state.range(0) != 0};
+
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const auto before = benchmarks::AllocationCount();
+    auto program = Parse(script, options);
+    benchmark::DoNotOptimize(program);
+    allocations += benchmarks::AllocationCount() - before;
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+  state.counters["allocs_per_parse"] =
+      benchmark::Counter(static_cast<double>(allocations),
+                         benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ParseGeneratedScript)->ArgName("arena")->Arg(0)->Arg(1);
+
+// Long chains of binary operators of every precedence level, so that looking
+// up operators dominates over building statements.
+std::string MakeExpressionHeavyScript() {
+  std::string script;
+  for (int group = 0; group < kStatementGroups; ++group) {
+    script += std::format(
+        "local e{0} = a + b * c - d / e // f % g ^ h ^ i < j and k >= l or "
+        "m ~= n and o <= p == q or r > s + t * u - v / w + {0} * x - y\n",
+        group);
+  }
+
+  return script;
+}
+
+void BM_ParseExpressionHeavyScript(benchmark::State& state) {
+  const auto script = MakeExpressionHeavyScript();
+  const ParseOptions options{.use_arena = true};
+
+  for (auto _ : state) {
+    auto program = Parse(script, options);
+    benchmark::DoNotOptimize(program);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+}
+BENCHMARK(BM_ParseExpressionHeavyScript);
+
+// About 3 MB of independent top-level statements, like the bundles that are
+// loaded at startup.
+void BM_ParseBundleInParallel(benchmark::State& state) {
+  const auto script = MakeGeneratedScript(20'000);
+  const ParseOptions options{
+      .use_arena = true,
+      .parse_threads = static_cast<unsigned>(state.range(0)),
+  };
+
+  for (auto _ : state) {
+    auto program = Parse(script, options);
+    benchmark::DoNotOptimize(program);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+}
+BENCHMARK(BM_ParseBundleInParallel)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Latency of one edit to a 10k line script, as in an editor: a literal in the
+// middle statement is changed back and forth, and the program is either
+// reparsed from the edit or parsed again in full.
+void BM_ReparseEdit(benchmark::State& state) {
+  const bool reparse = state.range(0) != 0;
+  constexpr int kGroups = 10'000 / 6;
+  std::string scripts[2] = {MakeGeneratedScript(kGroups), {}};
+  const auto literal = std::format("(a + {})", kGroups / 2);
+  const size_t begin = scripts[0].find(literal) + 4;
+  const size_t size = literal.size() - 5;
+  const std::string replacements[2] = {std::string(size, '9'),
+                                       scripts[0].substr(begin, size)};
+  scripts[1] = scripts[0];
+  scripts[1].replace(begin, size, replacements[0]);
+
+  auto program = Parse(scripts[0]);
+  size_t current = 0;
+  for (auto _ : state) {
+    const size_t next = 1 - current;
+    if (reparse) {
+      const TextEdit edit{.range = {begin, begin + size},
+                          .replacement = replacements[current]};
+      program = *Reparse(std::move(*program), scripts[next], edit);
+    } else {
+      program = Parse(scripts[next]);
+    }
+    benchmark::DoNotOptimize(program);
+    current = next;
+  }
+}
+BENCHMARK(BM_ReparseEdit)
+    ->ArgName("reparse")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+enum class LoadMode : uint8_t {
+  kIstream,
+  kRead,
+  kMmap,
+};
+
+// A generated script of about 8 MB in a temporary file, which is removed when
+// the benchmark ends.
+class ScriptFile {
+  std::filesystem::path path_;
+
+ public:
+  ScriptFile()
+      : path_(std::filesystem::temp_directory_path() /
+              "lualike_parser_benchmark.lua") {
+    std::ofstream(path_, std::ios::binary) << MakeGeneratedScript(50'000);
+  }
+  ScriptFile(const ScriptFile&) = delete;
+  ScriptFile& operator=(const ScriptFile&) = delete;
+  ~ScriptFile() { std::filesystem::remove(path_); }
+
+  const std::filesystem::path& Path() const noexcept { return path_; }
+  size_t Size() const { return std::filesystem::file_size(path_); }
+};
+
+void BM_LoadAndParseFile(benchmark::State& state) {
+  const ScriptFile file;
+  const auto mode = static_cast<LoadMode>(state.range(0));
+
+  for (auto _ : state) {
+    if (mode == LoadMode::kIstream) {
+      std::ifstream input(file.Path(), std::ios::binary);
+      auto program = Parse(input);
+      benchmark::DoNotOptimize(program);
+    } else {
+      auto source = source::ReadFile(
+          file.Path(), {.use_mmap = mode == LoadMode::kMmap});
+      auto program = Parse(std::move(source).value());
+      benchmark::DoNotOptimize(program);
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(file.Size()));
+}
+BENCHMARK(BM_LoadAndParseFile)
+    ->ArgName("mode")
+    ->Arg(static_cast<int64_t>(LoadMode::kIstream))
+    ->Arg(static_cast<int64_t>(LoadMode::kRead))
+    ->Arg(static_cast<int64_t>(LoadMode::kMmap))
+    ->Unit(benchmark::kMillisecond);
+
+// Parses a script from a stream, either read whole first (chunk 0) or lexed in
+// chunks of the given size while it is read.
+void BM_ParseInputStream(benchmark::State& state) {
+  const auto script = MakeGeneratedScript(5'000);
+  const auto chunk_size = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::istringstream input(script);
+    state.ResumeTiming();
+
+    auto program = chunk_size == 0 ? Parse(input)
+                                   : ParseStream(input, chunk_size);
+    benchmark::DoNotOptimize(program);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+}
+BENCHMARK(BM_ParseInputStream)
+    ->ArgName("chunk")
+    ->Arg(0)
+    ->Arg(4 << 10)
+    ->Arg(64 << 10)
+    ->Unit(benchmark::kMillisecond);
+
+// Only the loading part of BM_LoadAndParseFile.
+void BM_LoadFile(benchmark::State& state) {
+  const ScriptFile file;
+  const auto mode = static_cast<LoadMode>(state.range(0));
+
+  for (auto _ : state) {
+    if (mode == LoadMode::kIstream) {
+      std::ifstream input(file.Path(), std::ios::binary);
+      auto source = detail::ReadStreamToString(input);
+      benchmark::DoNotOptimize(source);
+    } else {
+      auto source = source::ReadFile(
+          file.Path(), {.use_mmap = mode == LoadMode::kMmap});
+      benchmark::DoNotOptimize(source);
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(file.Size()));
+}
+BENCHMARK(BM_LoadFile)
+    ->ArgName("mode")
+    ->Arg(static_cast<int64_t>(LoadMode::kIstream))
+    ->Arg(static_cast<int64_t>(LoadMode::kRead))
+    ->Arg(static_cast<int64_t>(LoadMode::kMmap));
+
+}  // namespace
+
+}  // namespace lualike::parser
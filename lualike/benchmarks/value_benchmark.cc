@@ -0,0 +1,193 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "lualike/compact_value.h"
+#include "lualike/interned_string.h"
+#include "lualike/value.h"
+
+namespace lualike::value {
+
+namespace {
+
+constexpr size_t kValueCount = 1024;
+
+// Alternates integers and floats, so both the integer-preserving and the
+// promoting paths are taken.
+template <typename ValueT>
+std::vector<ValueT> MakeNumbers() {
+  std::vector<ValueT> values;
+  values.reserve(kValueCount);
+  for (size_t i = 0; i < kValueCount; ++i) {
+    if (i % 2 == 0) {
+      values.emplace_back(static_cast<LualikeValue::IntT>(i));
+    } else {
+      values.emplace_back(static_cast<LualikeValue::FloatT>(i) / 4);
+    }
+  }
+
+  return values;
+}
+
+template <typename ValueT>
+void BM_Arithmetic(benchmark::State& state) {
+  const auto values = MakeNumbers<ValueT>();
+
+  for (auto _ : state) {
+    ValueT accumulator{LualikeValue::IntT{0}};
+    for (const auto& value : values) {
+      accumulator = accumulator + value * value - value;
+    }
+    benchmark::DoNotOptimize(accumulator);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_Arithmetic<LualikeValue>);
+BENCHMARK(BM_Arithmetic<CompactValue>);
+
+template <typename ValueT>
+void BM_Comparison(benchmark::State& state) {
+  const auto values = MakeNumbers<ValueT>();
+
+  for (auto _ : state) {
+    size_t less = 0;
+    for (size_t i = 1; i < values.size(); ++i) {
+      less += static_cast<size_t>(values[i - 1] < values[i]);
+    }
+    benchmark::DoNotOptimize(less);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_Comparison<LualikeValue>);
+BENCHMARK(BM_Comparison<CompactValue>);
+
+// Copies values the way the interpreter copies literals and variables.
+template <typename ValueT>
+void BM_Copy(benchmark::State& state) {
+  auto values = MakeNumbers<ValueT>();
+  values[0] = ValueT{std::string("a string that does not fit inline")};
+
+  for (auto _ : state) {
+    auto copy = values;
+    benchmark::DoNotOptimize(copy.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_Copy<LualikeValue>);
+BENCHMARK(BM_Copy<CompactValue>);
+
+// Longer than the small string buffer of std::string, so that copying one
+// allocates.
+template <typename StringT>
+std::vector<StringT> MakeStrings() {
+  std::vector<StringT> strings;
+  strings.reserve(kValueCount);
+  for (size_t i = 0; i < kValueCount; ++i) {
+    strings.emplace_back(std::format("a_rather_long_variable_name_{}", i % 64));
+  }
+
+  return strings;
+}
+
+template <typename StringT>
+void BM_StringCopy(benchmark::State& state) {
+  const auto strings = MakeStrings<StringT>();
+
+  for (auto _ : state) {
+    auto copy = strings;
+    benchmark::DoNotOptimize(copy.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_StringCopy<std::string>);
+BENCHMARK(BM_StringCopy<InternedString>);
+
+template <typename StringT>
+void BM_StringEquality(benchmark::State& state) {
+  const auto strings = MakeStrings<StringT>();
+
+  for (auto _ : state) {
+    size_t equal = 0;
+    for (size_t i = 64; i < strings.size(); ++i) {
+      equal += static_cast<size_t>(strings[i - 64] == strings[i]);
+    }
+    benchmark::DoNotOptimize(equal);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_StringEquality<std::string>);
+BENCHMARK(BM_StringEquality<InternedString>);
+
+// Makes every `100 / error_percent`-th value a string, so that adding it to a
+// number fails at the given rate.
+std::vector<LualikeValue> MakeMixedValues(int64_t error_percent) {
+  std::vector<LualikeValue> values;
+  values.reserve(kValueCount);
+  for (size_t i = 0; i < kValueCount; ++i) {
+    if (static_cast<int64_t>(i % 100) < error_percent) {
+      values.push_back(LualikeValue{"not a number"});
+    } else {
+      values.push_back(LualikeValue{static_cast<LualikeValue::IntT>(i)});
+    }
+  }
+
+  return values;
+}
+
+void BM_MixedTypeAddThrowing(benchmark::State& state) {
+  const auto values = MakeMixedValues(state.range(0));
+  const LualikeValue one{LualikeValue::IntT{1}};
+
+  for (auto _ : state) {
+    size_t errors = 0;
+    for (const auto& value : values) {
+      try {
+        benchmark::DoNotOptimize(value + one);
+      } catch (const LualikeValueOpErr&) {
+        ++errors;
+      }
+    }
+    benchmark::DoNotOptimize(errors);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_MixedTypeAddThrowing)->Arg(0)->Arg(10)->Arg(50)->Arg(90);
+
+void BM_MixedTypeAddExpected(benchmark::State& state) {
+  const auto values = MakeMixedValues(state.range(0));
+  const LualikeValue one{LualikeValue::IntT{1}};
+
+  for (auto _ : state) {
+    size_t errors = 0;
+    for (const auto& value : values) {
+      auto result = TryAdd(value, one);
+      errors += static_cast<size_t>(!result.has_value());
+      benchmark::DoNotOptimize(result);
+    }
+    benchmark::DoNotOptimize(errors);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kValueCount));
+}
+BENCHMARK(BM_MixedTypeAddExpected)->Arg(0)->Arg(10)->Arg(50)->Arg(90);
+
+}  // namespace
+
+}  // namespace lualike::value
@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <format>
+#include <string>
+
+#include "lualike/interpreter.h"
+
+namespace lualike::vm {
+
+namespace {
+
+using interpreter::Engine;
+
+constexpr int kArithmeticTerms = 64;
+constexpr int kBranchDepth = 32;
+constexpr int kNestedLocalsDepth = 16;
+
+std::string MakeArithmeticScript() {
+  std::string script =
+      "local a = 3\n"
+      "local b = 4.5\n"
+      "local c = 7\n"
+      "return 0";
+  for (int term = 0; term < kArithmeticTerms; ++term) {
+    script += " + ((a + b) * c - a / b + c % a) // 2";
+  }
+
+  return script;
+}
+
+std::string MakeBranchScript() {
+  std::string script = "local x = 0\n";
+  for (int depth = 0; depth < kBranchDepth; ++depth) {
+    script +=
+        "if x < 1000 and not (x == 7) or nil then\n"
+        "  x = x + 1\n"
+        "else\n"
+        "  x = x - 1\n"
+        "end\n";
+  }
+  for (int depth = 0; depth < kBranchDepth; ++depth) {
+    script += "if x >= 0 then\n";
+  }
+  script += "return x\n";
+  for (int depth = 0; depth < kBranchDepth; ++depth) {
+    script += "end\n";
+  }
+
+  return script;
+}
+
+// Declares a local in every nested block and reads all of them from the
+// innermost one, so lookups have to cross many scopes.
+std::string MakeNestedLocalsScript() {
+  std::string script;
+  for (int depth = 0; depth < kNestedLocalsDepth; ++depth) {
+    script += std::format("if true then\nlocal v{} = {}\n", depth, depth);
+  }
+  script += "local sum = 0\n";
+  for (int round = 0; round < 4; ++round) {
+    for (int depth = 0; depth < kNestedLocalsDepth; ++depth) {
+      script += std::format("sum = sum + v{}\n", depth);
+    }
+  }
+  script += "return sum\n";
+  for (int depth = 0; depth < kNestedLocalsDepth; ++depth) {
+    script += "end\n";
+  }
+
+  return script;
+}
+
+void RunScript(benchmark::State& state, const std::string& script,
+               Engine engine) {
+  const auto program = interpreter::Compile(script, engine);
+  if (!program) {
+    state.SkipWithError(program.error().what());
+    return;
+  }
+
+  for (auto _ : state) {
+    auto result = program->Run();
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+void BM_ArithmeticTreeWalker(benchmark::State& state) {
+  RunScript(state, MakeArithmeticScript(), Engine::kTreeWalker);
+}
+BENCHMARK(BM_ArithmeticTreeWalker);
+
+void BM_ArithmeticBytecode(benchmark::State& state) {
+  RunScript(state, MakeArithmeticScript(), Engine::kBytecode);
+}
+BENCHMARK(BM_ArithmeticBytecode);
+
+void BM_BranchTreeWalker(benchmark::State& state) {
+  RunScript(state, MakeBranchScript(), Engine::kTreeWalker);
+}
+BENCHMARK(BM_BranchTreeWalker);
+
+void BM_BranchBytecode(benchmark::State& state) {
+  RunScript(state, MakeBranchScript(), Engine::kBytecode);
+}
+BENCHMARK(BM_BranchBytecode);
+
+void BM_NestedLocalsTreeWalker(benchmark::State& state) {
+  RunScript(state, MakeNestedLocalsScript(), Engine::kTreeWalker);
+}
+BENCHMARK(BM_NestedLocalsTreeWalker);
+
+void BM_NestedLocalsBytecode(benchmark::State& state) {
+  RunScript(state, MakeNestedLocalsScript(), Engine::kBytecode);
+}
+BENCHMARK(BM_NestedLocalsBytecode);
+
+}  // namespace
+
+}  // namespace lualike::vm
@@ -0,0 +1,427 @@
+#include "lualike/bytecode.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <print>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace lualike::bytecode {
+
+namespace {
+
+std::string_view OpCodeToString(OpCode op) {
+  switch (op) {
+    case OpCode::kConstant:
+      return "Constant";
+    case OpCode::kGetLocal:
+      return "GetLocal";
+    case OpCode::kSetLocal:
+      return "SetLocal";
+    case OpCode::kGetGlobal:
+      return "GetGlobal";
+    case OpCode::kSetGlobal:
+      return "SetGlobal";
+    case OpCode::kAssignGlobal:
+      return "AssignGlobal";
+    case OpCode::kPop:
+      return "Pop";
+    case OpCode::kNegate:
+      return "Negate";
+    case OpCode::kNot:
+      return "Not";
+    case OpCode::kAdd:
+      return "Add";
+    case OpCode::kSubtract:
+      return "Subtract";
+    case OpCode::kMultiply:
+      return "Multiply";
+    case OpCode::kDivide:
+      return "Divide";
+    case OpCode::kFloorDivide:
+      return "FloorDivide";
+    case OpCode::kModulo:
+      return "Modulo";
+    case OpCode::kPower:
+      return "Power";
+    case OpCode::kEqual:
+      return "Equal";
+    case OpCode::kNotEqual:
+      return "NotEqual";
+    case OpCode::kLessThan:
+      return "LessThan";
+    case OpCode::kLessThanEqual:
+      return "LessThanEqual";
+    case OpCode::kGreaterThan:
+      return "GreaterThan";
+    case OpCode::kGreaterThanEqual:
+      return "GreaterThanEqual";
+    case OpCode::kJump:
+      return "Jump";
+    case OpCode::kJumpIfFalse:
+      return "JumpIfFalse";
+    case OpCode::kJumpIfFalseOrPop:
+      return "JumpIfFalseOrPop";
+    case OpCode::kJumpIfTrueOrPop:
+      return "JumpIfTrueOrPop";
+    case OpCode::kFunction:
+      return "Function";
+    case OpCode::kCall:
+      return "Call";
+    case OpCode::kReturn:
+      return "Return";
+    case OpCode::kUnimplemented:
+      return "Unimplemented";
+    case OpCode::kHalt:
+      return "Halt";
+
+    default:
+      throw std::runtime_error("Unknown OpCode");
+  }
+}
+
+OpCode BinaryOperatorToOpCode(ast::BinaryOperator op) {
+  switch (op) {
+    case ast::BinaryOperator::kAdd:
+      return OpCode::kAdd;
+    case ast::BinaryOperator::kSubtract:
+      return OpCode::kSubtract;
+    case ast::BinaryOperator::kMultiply:
+      return OpCode::kMultiply;
+    case ast::BinaryOperator::kDivide:
+      return OpCode::kDivide;
+    case ast::BinaryOperator::kFloorDivide:
+      return OpCode::kFloorDivide;
+    case ast::BinaryOperator::kModulo:
+      return OpCode::kModulo;
+    case ast::BinaryOperator::kPower:
+      return OpCode::kPower;
+    case ast::BinaryOperator::kEqual:
+      return OpCode::kEqual;
+    case ast::BinaryOperator::kNotEqual:
+      return OpCode::kNotEqual;
+    case ast::BinaryOperator::kLessThan:
+      return OpCode::kLessThan;
+    case ast::BinaryOperator::kLessThanEqual:
+      return OpCode::kLessThanEqual;
+    case ast::BinaryOperator::kGreaterThan:
+      return OpCode::kGreaterThan;
+    case ast::BinaryOperator::kGreaterThanEqual:
+      return OpCode::kGreaterThanEqual;
+
+    default:
+      throw std::runtime_error("Binary operator has no direct opcode");
+  }
+}
+
+class Compiler {
+  struct BlockFrame {
+    uint32_t base;
+    uint32_t slot_count;
+  };
+
+  Chunk chunk_;
+  std::unordered_map<value::InternedString, uint32_t> name_indices_;
+  // Frame ranges of the nested blocks currently being compiled.
+  std::vector<BlockFrame> blocks_;
+
+  size_t Emit(OpCode op, uint32_t operand, token::SourceSpan span);
+  size_t EmitJump(OpCode op, token::SourceSpan span);
+  void PatchJump(size_t jump_index);
+  uint32_t AddConstant(const value::LualikeValue& constant);
+  uint32_t AddName(const value::InternedString& name);
+  uint32_t FrameIndex(ast::LocalSlot slot) const;
+
+  void CompileNestedBlock(const ast::Block& block);
+  uint32_t AddFunction(const ast::FunctionDeclaration& function);
+  void CompileStatement(const ast::Statement& statement);
+  void CompileExpression(const ast::Expression& expression);
+
+  template <typename StmtT>
+  void CompileStatementNode(const StmtT& stmt, token::SourceSpan span);
+  template <typename ExprT>
+  void CompileExpressionNode(const ExprT& expr, token::SourceSpan span);
+
+ public:
+  Chunk Compile(const ast::Program& program) &&;
+  Chunk CompileFunction(const ast::FunctionDeclaration& function) &&;
+};
+
+size_t Compiler::Emit(OpCode op, uint32_t operand, token::SourceSpan span) {
+  chunk_.code.push_back({op, operand});
+  chunk_.spans.push_back(span);
+  return chunk_.code.size() - 1;
+}
+
+size_t Compiler::EmitJump(OpCode op, token::SourceSpan span) {
+  return Emit(op, std::numeric_limits<uint32_t>::max(), span);
+}
+
+void Compiler::PatchJump(size_t jump_index) {
+  chunk_.code[jump_index].operand = static_cast<uint32_t>(chunk_.code.size());
+}
+
+uint32_t Compiler::AddConstant(const value::LualikeValue& constant) {
+  chunk_.constants.push_back(constant);
+  return static_cast<uint32_t>(chunk_.constants.size() - 1);
+}
+
+uint32_t Compiler::AddName(const value::InternedString& name) {
+  const auto [it, inserted] = name_indices_.try_emplace(
+      name, static_cast<uint32_t>(chunk_.names.size()));
+  if (inserted) {
+    chunk_.names.push_back(name);
+  }
+
+  return it->second;
+}
+
+uint32_t Compiler::FrameIndex(ast::LocalSlot slot) const {
+  return blocks_[blocks_.size() - 1 - slot.depth].base + slot.index;
+}
+
+Chunk Compiler::Compile(const ast::Program& program) && {
+  for (const auto& statement : program.statements) {
+    CompileStatement(statement);
+  }
+
+  Emit(OpCode::kHalt, 0, {program.span.end, program.span.end});
+  return std::move(chunk_);
+}
+
+// A function body gets a chunk of its own, whose frame starts with the
+// parameters.
+Chunk Compiler::CompileFunction(const ast::FunctionDeclaration& function) && {
+  const auto& body = *function.body;
+  chunk_.param_count = static_cast<uint32_t>(function.params.size());
+  chunk_.frame_size = body.slot_count;
+  blocks_.push_back({0, body.slot_count});
+  for (const auto& statement : body.statements) {
+    CompileStatement(statement);
+  }
+  blocks_.pop_back();
+
+  Emit(OpCode::kHalt, 0, {body.span.end, body.span.end});
+  return std::move(chunk_);
+}
+
+uint32_t Compiler::AddFunction(const ast::FunctionDeclaration& function) {
+  chunk_.functions.push_back(Compiler{}.CompileFunction(function));
+  return static_cast<uint32_t>(chunk_.functions.size() - 1);
+}
+
+void Compiler::CompileNestedBlock(const ast::Block& block) {
+  const uint32_t base =
+      blocks_.empty() ? 0 : blocks_.back().base + blocks_.back().slot_count;
+  blocks_.push_back({base, block.slot_count});
+  chunk_.frame_size = std::max(chunk_.frame_size, base + block.slot_count);
+
+  for (const auto& statement : block.statements) {
+    CompileStatement(statement);
+  }
+
+  blocks_.pop_back();
+}
+
+void Compiler::CompileStatement(const ast::Statement& statement) {
+  std::visit(
+      [this, &statement](const auto& stmt) {
+        CompileStatementNode(stmt, statement.span);
+      },
+      statement.node);
+}
+
+void Compiler::CompileExpression(const ast::Expression& expression) {
+  std::visit(
+      [this, &expression](const auto& expr) {
+        CompileExpressionNode(expr, expression.span);
+      },
+      expression.node);
+}
+
+template <typename StmtT>
+void Compiler::CompileStatementNode(const StmtT& stmt, token::SourceSpan span) {
+  using T = std::decay_t<decltype(stmt)>;
+
+  if constexpr (std::is_same_v<T, ast::VariableDeclaration>) {
+    if (stmt.initializer) {
+      CompileExpression(stmt.initializer.value());
+    } else {
+      Emit(OpCode::kConstant, AddConstant({}), span);
+    }
+
+    if (stmt.slot) {
+      Emit(OpCode::kSetLocal, FrameIndex(*stmt.slot), span);
+    } else {
+      Emit(OpCode::kSetGlobal, AddName(stmt.name), span);
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, ast::Assignment>) {
+    CompileExpression(stmt.value);
+    if (stmt.variable.slot) {
+      Emit(OpCode::kSetLocal, FrameIndex(*stmt.variable.slot), span);
+    } else {
+      Emit(OpCode::kAssignGlobal, AddName(stmt.variable.name), span);
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, ast::IfStatement>) {
+    CompileExpression(stmt.condition);
+    const size_t else_jump = EmitJump(OpCode::kJumpIfFalse, span);
+    CompileNestedBlock(*stmt.then_branch);
+
+    if (stmt.else_branch) {
+      const size_t end_jump = EmitJump(OpCode::kJump, span);
+      PatchJump(else_jump);
+      CompileNestedBlock(*stmt.else_branch);
+      PatchJump(end_jump);
+    } else {
+      PatchJump(else_jump);
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, ast::ReturnStatement>) {
+    // A bare `return` returns nil, like the tree walker.
+    if (stmt.expression.has_value()) {
+      CompileExpression(stmt.expression.value());
+    } else {
+      Emit(OpCode::kConstant, AddConstant({}), span);
+    }
+    Emit(OpCode::kReturn, 0, span);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::ExpressionStatement>) {
+    CompileExpression(stmt.expression);
+    Emit(OpCode::kPop, 0, span);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::FunctionDeclaration>) {
+    Emit(OpCode::kFunction, AddFunction(stmt), span);
+    if (stmt.slot) {
+      Emit(OpCode::kSetLocal, FrameIndex(*stmt.slot), span);
+    } else {
+      Emit(OpCode::kSetGlobal, AddName(stmt.name), span);
+    }
+  }
+}
+
+template <typename ExprT>
+void Compiler::CompileExpressionNode(const ExprT& expr,
+                                     token::SourceSpan span) {
+  using T = std::decay_t<decltype(expr)>;
+
+  if constexpr (std::is_same_v<T, ast::LiteralExpression>) {
+    Emit(OpCode::kConstant, AddConstant(expr.value), span);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::VariableExpression>) {
+    if (expr.slot) {
+      Emit(OpCode::kGetLocal, FrameIndex(*expr.slot), span);
+    } else {
+      Emit(OpCode::kGetGlobal, AddName(expr.name), span);
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, ast::UnaryExpression>) {
+    CompileExpression(*expr.rhs);
+    Emit(expr.op == ast::UnaryOperator::kNegate ? OpCode::kNegate
+                                                : OpCode::kNot,
+         0, span);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::BinaryExpression>) {
+    CompileExpression(*expr.lhs);
+
+    if (expr.op == ast::BinaryOperator::kAnd ||
+        expr.op == ast::BinaryOperator::kOr) {
+      const size_t end_jump = EmitJump(expr.op == ast::BinaryOperator::kAnd
+                                           ? OpCode::kJumpIfFalseOrPop
+                                           : OpCode::kJumpIfTrueOrPop,
+                                       span);
+      CompileExpression(*expr.rhs);
+      PatchJump(end_jump);
+      return;
+    }
+
+    CompileExpression(*expr.rhs);
+    Emit(BinaryOperatorToOpCode(expr.op), 0, span);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::FunctionCallExpression>) {
+    // The arguments end up right above the callee, where the VM turns them
+    // into the frame of a called script function.
+    CompileExpression(*expr.callee);
+    for (const auto& argument : expr.arguments) {
+      CompileExpression(argument);
+    }
+    Emit(OpCode::kCall, static_cast<uint32_t>(expr.arguments.size()), span);
+  }
+
+  else {
+    Emit(OpCode::kUnimplemented, 0, span);
+  }
+}
+
+}  // namespace
+
+Chunk Compile(const ast::Program& program) {
+  return Compiler{}.Compile(program);
+}
+
+void PrintTo(const Chunk& chunk, std::ostream* out) {
+  for (size_t index = 0; index < chunk.code.size(); ++index) {
+    const auto& instruction = chunk.code[index];
+    std::print(*out, "{:04} {}", index, OpCodeToString(instruction.op));
+
+    switch (instruction.op) {
+      case OpCode::kConstant:
+        std::print(*out, " {}",
+                   chunk.constants[instruction.operand].ToString());
+        break;
+      case OpCode::kGetLocal:
+      case OpCode::kSetLocal:
+      case OpCode::kFunction:
+      case OpCode::kCall:
+        std::print(*out, " {}", instruction.operand);
+        break;
+      case OpCode::kGetGlobal:
+      case OpCode::kSetGlobal:
+      case OpCode::kAssignGlobal:
+        std::print(*out, " {}", chunk.names[instruction.operand]);
+        break;
+      case OpCode::kJump:
+      case OpCode::kJumpIfFalse:
+      case OpCode::kJumpIfFalseOrPop:
+      case OpCode::kJumpIfTrueOrPop:
+        std::print(*out, " -> {:04}", instruction.operand);
+        break;
+      default:
+        break;
+    }
+
+    *out << '\n';
+  }
+
+  for (size_t index = 0; index < chunk.functions.size(); ++index) {
+    std::println(*out, "Function {}:", index);
+    PrintTo(chunk.functions[index], out);
+  }
+}
+
+std::string ToString(const Chunk& chunk) {
+  std::stringstream ss;
+  PrintTo(chunk, &ss);
+  return ss.str();
+}
+
+}  // namespace lualike::bytecode
@@ -0,0 +1,89 @@
+#ifndef LUALIKE_BYTECODE_H_
+#define LUALIKE_BYTECODE_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "lualike/ast.h"
+#include "lualike/interned_string.h"
+#include "lualike/token.h"
+#include "lualike/value.h"
+
+namespace lualike::bytecode {
+
+enum class OpCode : uint8_t {
+  kConstant,
+  kGetLocal,
+  kSetLocal,
+  kGetGlobal,
+  kSetGlobal,
+  kAssignGlobal,
+  kPop,
+
+  kNegate,
+  kNot,
+
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kDivide,
+  kFloorDivide,
+  kModulo,
+  kPower,
+  kEqual,
+  kNotEqual,
+  kLessThan,
+  kLessThanEqual,
+  kGreaterThan,
+  kGreaterThanEqual,
+
+  kJump,
+  kJumpIfFalse,
+  kJumpIfFalseOrPop,
+  kJumpIfTrueOrPop,
+
+  kFunction,
+  kCall,
+
+  kReturn,
+  kUnimplemented,
+  kHalt,
+};
+
+// The meaning of `operand` depends on the opcode: an index into
+// `Chunk::constants`, `Chunk::names`, `Chunk::functions` or the local frame,
+// an absolute jump target, or the number of arguments of a call.
+struct Instruction {
+  OpCode op;
+  uint32_t operand{};
+
+  bool operator==(const Instruction& rhs) const = default;
+};
+
+struct Chunk {
+  std::vector<Instruction> code;
+  // Source span of every instruction, used only when reporting errors.
+  std::vector<token::SourceSpan> spans;
+  std::vector<value::LualikeValue> constants;
+  std::vector<value::InternedString> names;
+  // Number of local slots needed to run the chunk. Sibling blocks share the
+  // same range of the frame.
+  uint32_t frame_size{};
+  // Bodies of the functions declared directly in the chunk.
+  std::vector<Chunk> functions;
+  // For a function body, the number of parameters, which occupy the first
+  // slots of the frame.
+  uint32_t param_count{};
+};
+
+// Expects a program that went through resolver::Resolve.
+Chunk Compile(const ast::Program& program);
+
+std::string ToString(const Chunk& chunk);
+void PrintTo(const Chunk& chunk, std::ostream* out);
+
+}  // namespace lualike::bytecode
+
+#endif  // LUALIKE_BYTECODE_H_
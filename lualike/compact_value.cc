@@ -0,0 +1,247 @@
+#include "lualike/compact_value.h"
+
+#include <cmath>
+#include <optional>
+
+namespace lualike::value {
+
+struct CompactValue::StringCell : HeapCell {
+  LualikeValue::StringT value;
+
+  explicit StringCell(LualikeValue::StringT value) : value(std::move(value)) {}
+};
+
+struct CompactValue::FunctionCell : HeapCell {
+  LualikeValue::FuncT value;
+
+  explicit FunctionCell(LualikeValue::FuncT value) : value(std::move(value)) {}
+};
+
+namespace {
+
+using Kind = CompactValue::Kind;
+
+std::optional<LualikeValue::FloatT> CastToFloat(const CompactValue& value) {
+  switch (value.GetKind()) {
+    case Kind::kInt:
+      return static_cast<LualikeValue::FloatT>(value.AsInt());
+    case Kind::kFloat:
+      return value.AsFloat();
+    default:
+      return std::nullopt;
+  }
+}
+
+LualikeValue::BoolT TryAsBool(const CompactValue& value,
+                              LualikeValueOpErrKind error_kind) {
+  if (value.GetKind() != Kind::kBool) {
+    throw LualikeValueOpErr(error_kind);
+  }
+
+  return value.AsBool();
+}
+
+template <typename OperatorT>
+CompactValue PerformArithmeticBinOp(const CompactValue& lhs,
+                                    const CompactValue& rhs,
+                                    const OperatorT& operator_lambda) {
+  switch (lhs.GetKind()) {
+    case Kind::kInt: {
+      if (rhs.GetKind() == Kind::kInt) {
+        return CompactValue{operator_lambda(lhs.AsInt(), rhs.AsInt())};
+      }
+
+      const auto rhs_as_float = CastToFloat(rhs);
+      if (!rhs_as_float) {
+        throw LualikeValueOpErr(LualikeValueOpErrKind::kRhsNotNumeric);
+      }
+
+      return CompactValue{operator_lambda(
+          static_cast<LualikeValue::FloatT>(lhs.AsInt()), *rhs_as_float)};
+    }
+
+    case Kind::kFloat: {
+      const auto rhs_as_float = CastToFloat(rhs);
+      if (!rhs_as_float) {
+        throw LualikeValueOpErr(LualikeValueOpErrKind::kRhsNotNumeric);
+      }
+
+      return CompactValue{operator_lambda(lhs.AsFloat(), *rhs_as_float)};
+    }
+
+    default:
+      throw LualikeValueOpErr(LualikeValueOpErrKind::kLhsNotNumeric);
+  }
+}
+
+template <typename OperatorT>
+CompactValue PerformFloatBinOp(const CompactValue& lhs, const CompactValue& rhs,
+                               const OperatorT& operator_lambda) {
+  const auto lhs_as_float = CastToFloat(lhs);
+  if (!lhs_as_float) {
+    throw LualikeValueOpErr(LualikeValueOpErrKind::kLhsNotNumeric);
+  }
+
+  const auto rhs_as_float = CastToFloat(rhs);
+  if (!rhs_as_float) {
+    throw LualikeValueOpErr(LualikeValueOpErrKind::kRhsNotNumeric);
+  }
+
+  return CompactValue{operator_lambda(*lhs_as_float, *rhs_as_float)};
+}
+
+}  // namespace
+
+CompactValue::CompactValue(LualikeValue::StringT value) : kind_(Kind::kString) {
+  payload_.cell = new StringCell(std::move(value));
+}
+
+CompactValue::CompactValue(LualikeValue::FuncT value) : kind_(Kind::kFunction) {
+  payload_.cell = new FunctionCell(std::move(value));
+}
+
+CompactValue CompactValue::FromValue(const LualikeValue& value) {
+  return std::visit([](const auto& inner) { return CompactValue{inner}; },
+                    value.inner_value);
+}
+
+LualikeValue CompactValue::ToValue() const {
+  switch (kind_) {
+    case Kind::kNil:
+      return {};
+    case Kind::kBool:
+      return {AsBool()};
+    case Kind::kInt:
+      return {AsInt()};
+    case Kind::kFloat:
+      return {AsFloat()};
+    case Kind::kString:
+      return {AsString()};
+    case Kind::kFunction:
+      return {AsFunction()};
+  }
+
+  throw LualikeValueOpErr(LualikeValueOpErrKind::kNormallyImpossibleErr);
+}
+
+void CompactValue::Release() noexcept {
+  if (payload_.cell->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+
+  if (kind_ == Kind::kString) {
+    delete static_cast<StringCell*>(payload_.cell);
+  } else {
+    delete static_cast<FunctionCell*>(payload_.cell);
+  }
+}
+
+const LualikeValue::StringT& CompactValue::AsString() const noexcept {
+  return static_cast<const StringCell*>(payload_.cell)->value;
+}
+
+const LualikeValue::FuncT& CompactValue::AsFunction() const noexcept {
+  return static_cast<const FunctionCell*>(payload_.cell)->value;
+}
+
+std::string CompactValue::ToString() const { return ToValue().ToString(); }
+
+std::strong_ordering CompactValue::CompareHeapValues(
+    const CompactValue& lhs, const CompactValue& rhs) noexcept {
+  if (lhs.kind_ == Kind::kString) {
+    return lhs.AsString() <=> rhs.AsString();
+  }
+
+  return lhs.AsFunction() <=> rhs.AsFunction();
+}
+
+CompactValue operator+(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformArithmeticBinOp(
+      lhs, rhs,
+      [](const auto lhs_value, const auto rhs_value) {
+        return lhs_value + rhs_value;
+      });
+}
+
+CompactValue operator-(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformArithmeticBinOp(
+      lhs, rhs,
+      [](const auto lhs_value, const auto rhs_value) {
+        return lhs_value - rhs_value;
+      });
+}
+
+CompactValue operator*(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformArithmeticBinOp(
+      lhs, rhs,
+      [](const auto lhs_value, const auto rhs_value) {
+        return lhs_value * rhs_value;
+      });
+}
+
+CompactValue operator/(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformFloatBinOp(lhs, rhs,
+                           [](const auto lhs_value, const auto rhs_value) {
+                             return lhs_value / rhs_value;
+                           });
+}
+
+CompactValue operator%(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformArithmeticBinOp(
+      lhs, rhs, [](const auto lhs_value, const auto rhs_value) {
+        return static_cast<LualikeValue::IntT>(
+            std::floor(std::fmod(lhs_value, rhs_value)));
+      });
+}
+
+CompactValue Exponentiate(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformFloatBinOp(lhs, rhs,
+                           [](const auto lhs_value, const auto rhs_value) {
+                             return std::pow(lhs_value, rhs_value);
+                           });
+}
+
+CompactValue FloorDivide(const CompactValue& lhs, const CompactValue& rhs) {
+  return PerformFloatBinOp(lhs, rhs,
+                           [](const auto lhs_value, const auto rhs_value) {
+                             return std::floor(lhs_value / rhs_value);
+                           });
+}
+
+CompactValue operator-(const CompactValue& operand) {
+  switch (operand.GetKind()) {
+    case Kind::kInt:
+      return CompactValue{-operand.AsInt()};
+    case Kind::kFloat:
+      return CompactValue{-operand.AsFloat()};
+    default:
+      throw LualikeValueOpErr(LualikeValueOpErrKind::kNotNumericOperand);
+  }
+}
+
+CompactValue operator||(const CompactValue& lhs, const CompactValue& rhs) {
+  const auto lhs_as_bool = TryAsBool(lhs, LualikeValueOpErrKind::kLhsNotBool);
+  const auto rhs_as_bool = TryAsBool(rhs, LualikeValueOpErrKind::kRhsNotBool);
+
+  return CompactValue{lhs_as_bool || rhs_as_bool};
+}
+
+CompactValue operator&&(const CompactValue& lhs, const CompactValue& rhs) {
+  const auto lhs_as_bool = TryAsBool(lhs, LualikeValueOpErrKind::kLhsNotBool);
+  const auto rhs_as_bool = TryAsBool(rhs, LualikeValueOpErrKind::kRhsNotBool);
+
+  return CompactValue{lhs_as_bool && rhs_as_bool};
+}
+
+CompactValue operator!(const CompactValue& operand) {
+  const auto operand_as_bool =
+      TryAsBool(operand, LualikeValueOpErrKind::kNotBoolOperand);
+
+  return CompactValue{!operand_as_bool};
+}
+
+void PrintTo(const CompactValue& value, std::ostream* out) {
+  *out << value.ToString();
+}
+
+}  // namespace lualike::value
@@ -0,0 +1,201 @@
+#ifndef LUALIKE_COMPACT_VALUE_H_
+#define LUALIKE_COMPACT_VALUE_H_
+
+#include <atomic>
+#include <compare>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "lualike/value.h"
+
+namespace lualike::value {
+
+// A 16-byte tagged alternative to LualikeValue.
+//
+// Nil, booleans, integers and floats are stored inline, and copying them is a
+// plain 16-byte copy. Strings and functions live in a reference counted heap
+// cell that the value points to. Operators follow exactly the semantics of the
+// ones of LualikeValue, including the order of the operands' type checks and
+// the resulting LualikeValueOpErr kinds.
+//
+// NaN-boxing would make the value 8 bytes, but cannot hold a full 64-bit IntT
+// inline, so a separate tag is used instead.
+class CompactValue {
+ public:
+  // Ordered like the alternatives of LualikeValue::inner_value, so that
+  // comparisons between different kinds agree with LualikeValue's.
+  enum class Kind : uint8_t {
+    kNil,
+    kBool,
+    kInt,
+    kFloat,
+    kString,
+    kFunction,
+  };
+
+  CompactValue() noexcept : kind_(Kind::kNil) { payload_.int_value = 0; }
+  explicit CompactValue(LualikeValue::NilT) noexcept : CompactValue() {}
+  explicit CompactValue(LualikeValue::BoolT value) noexcept
+      : kind_(Kind::kBool) {
+    payload_.int_value = 0;
+    payload_.bool_value = value;
+  }
+  explicit CompactValue(LualikeValue::IntT value) noexcept
+      : kind_(Kind::kInt) {
+    payload_.int_value = value;
+  }
+  explicit CompactValue(LualikeValue::FloatT value) noexcept
+      : kind_(Kind::kFloat) {
+    payload_.float_value = value;
+  }
+  explicit CompactValue(LualikeValue::StringT value);
+  explicit CompactValue(LualikeValue::FuncT value);
+
+  static CompactValue FromValue(const LualikeValue& value);
+  LualikeValue ToValue() const;
+
+  CompactValue(const CompactValue& other) noexcept
+      : payload_(other.payload_), kind_(other.kind_) {
+    if (IsHeapKind(kind_)) {
+      payload_.cell->ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  CompactValue(CompactValue&& other) noexcept
+      : payload_(other.payload_), kind_(other.kind_) {
+    other.kind_ = Kind::kNil;
+  }
+
+  CompactValue& operator=(const CompactValue& other) noexcept {
+    CompactValue copy{other};
+    swap(*this, copy);
+    return *this;
+  }
+
+  CompactValue& operator=(CompactValue&& other) noexcept {
+    CompactValue moved{std::move(other)};
+    swap(*this, moved);
+    return *this;
+  }
+
+  ~CompactValue() {
+    if (IsHeapKind(kind_)) {
+      Release();
+    }
+  }
+
+  friend void swap(CompactValue& lhs, CompactValue& rhs) noexcept {
+    std::swap(lhs.payload_, rhs.payload_);
+    std::swap(lhs.kind_, rhs.kind_);
+  }
+
+  Kind GetKind() const noexcept { return kind_; }
+
+  // The accessors expect the value to be of the matching kind.
+  LualikeValue::BoolT AsBool() const noexcept { return payload_.bool_value; }
+  LualikeValue::IntT AsInt() const noexcept { return payload_.int_value; }
+  LualikeValue::FloatT AsFloat() const noexcept { return payload_.float_value; }
+  const LualikeValue::StringT& AsString() const noexcept;
+  const LualikeValue::FuncT& AsFunction() const noexcept;
+
+  std::string ToString() const;
+
+  friend bool operator==(const CompactValue& lhs,
+                         const CompactValue& rhs) noexcept {
+    if (lhs.kind_ != rhs.kind_) {
+      return false;
+    }
+
+    switch (lhs.kind_) {
+      case Kind::kNil:
+        return true;
+      case Kind::kBool:
+        return lhs.AsBool() == rhs.AsBool();
+      case Kind::kInt:
+        return lhs.AsInt() == rhs.AsInt();
+      case Kind::kFloat:
+        return lhs.AsFloat() == rhs.AsFloat();
+      default:
+        return CompareHeapValues(lhs, rhs) == 0;
+    }
+  }
+
+  friend std::partial_ordering operator<=>(const CompactValue& lhs,
+                                           const CompactValue& rhs) noexcept {
+    if (lhs.kind_ != rhs.kind_) {
+      return lhs.kind_ <=> rhs.kind_;
+    }
+
+    switch (lhs.kind_) {
+      case Kind::kNil:
+        return std::partial_ordering::equivalent;
+      case Kind::kBool:
+        return lhs.AsBool() <=> rhs.AsBool();
+      case Kind::kInt:
+        return lhs.AsInt() <=> rhs.AsInt();
+      case Kind::kFloat:
+        return lhs.AsFloat() <=> rhs.AsFloat();
+      default:
+        return CompareHeapValues(lhs, rhs);
+    }
+  }
+
+  friend CompactValue operator+(const CompactValue& lhs,
+                                const CompactValue& rhs);
+  friend CompactValue operator-(const CompactValue& lhs,
+                                const CompactValue& rhs);
+  friend CompactValue operator*(const CompactValue& lhs,
+                                const CompactValue& rhs);
+  friend CompactValue operator/(const CompactValue& lhs,
+                                const CompactValue& rhs);
+  friend CompactValue operator%(const CompactValue& lhs,
+                                const CompactValue& rhs);
+  friend CompactValue Exponentiate(const CompactValue& lhs,
+                                   const CompactValue& rhs);
+  friend CompactValue FloorDivide(const CompactValue& lhs,
+                                  const CompactValue& rhs);
+
+  friend CompactValue operator-(const CompactValue& operand);
+  friend CompactValue operator||(const CompactValue& lhs,
+                                 const CompactValue& rhs);
+  friend CompactValue operator&&(const CompactValue& lhs,
+                                 const CompactValue& rhs);
+  friend CompactValue operator!(const CompactValue& operand);
+
+ private:
+  struct HeapCell {
+    std::atomic<uint32_t> ref_count{1};
+  };
+  struct StringCell;
+  struct FunctionCell;
+
+  static constexpr bool IsHeapKind(Kind kind) noexcept {
+    return kind >= Kind::kString;
+  }
+
+  void Release() noexcept;
+
+  // Compares two strings or two functions.
+  static std::strong_ordering CompareHeapValues(
+      const CompactValue& lhs, const CompactValue& rhs) noexcept;
+
+  union Payload {
+    LualikeValue::BoolT bool_value;
+    LualikeValue::IntT int_value;
+    LualikeValue::FloatT float_value;
+    HeapCell* cell;
+  };
+
+  Payload payload_;
+  Kind kind_;
+};
+
+static_assert(sizeof(CompactValue) == 16);
+
+void PrintTo(const CompactValue& value, std::ostream* os);
+
+}  // namespace lualike::value
+
+#endif  // LUALIKE_COMPACT_VALUE_H_
@@ -47,32 +47,8 @@ std::vector<const ErrorBase*> CollectChain(const ErrorBase* root) {
   return chain;
 }
 
-struct LineInfo {
-  size_t line_number{};
-  size_t line_begin{};
-  size_t line_end{};
-};
-
-LineInfo LocateLine(std::string_view source_text, size_t offset) {
-  offset = std::min(offset, source_text.size());
-
-  LineInfo line{1, 0, source_text.size()};
-  for (size_t index = 0; index < offset; ++index) {
-    if (source_text[index] == '\n') {
-      ++line.line_number;
-      line.line_begin = index + 1;
-    }
-  }
-
-  if (const size_t line_end = source_text.find('\n', line.line_begin);
-      line_end != std::string_view::npos) {
-    line.line_end = line_end;
-  }
-
-  return line;
-}
-
 std::string RenderSpanSnippet(std::string_view source_text,
+                              const source::LineIndex& lines,
                               token::SourceSpan span,
                               std::string_view message) {
   if (source_text.empty()) {
@@ -82,7 +58,7 @@ std::string RenderSpanSnippet(std::string_view source_text,
   span.begin = std::min(span.begin, source_text.size());
   span.end = std::clamp(span.end, span.begin, source_text.size());
 
-  const auto line = LocateLine(source_text, span.begin);
+  const auto line = lines.Locate(span.begin);
   const auto line_text =
       source_text.substr(line.line_begin, line.line_end - line.line_begin);
   const size_t column_begin = span.begin - line.line_begin;
@@ -117,20 +93,13 @@ void AppendCallStack(std::ostringstream* out, const CallStack& call_stack) {
 
 }  // namespace
 
-ErrorBase::ErrorBase(std::string message, std::unique_ptr<ErrorBase> source,
+ErrorBase::ErrorBase(std::string message,
+                     std::shared_ptr<const ErrorBase> source,
                      std::exception_ptr exception_ptr)
     : std::runtime_error(std::move(message)),
       exception_ptr_(std::move(exception_ptr)),
       source_(std::move(source)) {}
 
-std::unique_ptr<ErrorBase> ErrorBase::CloneSource() const {
-  return source_ ? source_->Clone() : nullptr;
-}
-
-std::exception_ptr ErrorBase::GetStoredExceptionPtr() const noexcept {
-  return exception_ptr_;
-}
-
 std::optional<token::SourceSpan> ErrorBase::GetContextSpan() const noexcept {
   return std::nullopt;
 }
@@ -159,7 +128,7 @@ std::exception_ptr ErrorBase::GetExceptionPtr() const noexcept {
 }
 
 ContextError::ContextError(std::string message,
-                           std::unique_ptr<ErrorBase> source,
+                           std::shared_ptr<const ErrorBase> source,
                            std::optional<token::SourceSpan> context_span,
                            std::optional<CallStack> call_stack,
                            std::exception_ptr exception_ptr)
@@ -168,11 +137,6 @@ ContextError::ContextError(std::string message,
       context_span_(context_span),
       call_stack_(std::move(call_stack)) {}
 
-std::unique_ptr<ErrorBase> ContextError::Clone() const {
-  return std::make_unique<ContextError>(what(), CloneSource(), context_span_,
-                                        call_stack_, GetStoredExceptionPtr());
-}
-
 std::optional<token::SourceSpan> ContextError::GetContextSpan() const noexcept {
   return context_span_;
 }
@@ -181,44 +145,33 @@ const CallStack* ContextError::GetCallStack() const noexcept {
   return call_stack_ ? &call_stack_.value() : nullptr;
 }
 
-Error::Error(std::unique_ptr<ErrorBase> root, std::string source_text)
-    : root_(std::move(root)), source_text_(std::move(source_text)) {}
+Error::Error(std::shared_ptr<const ErrorBase> root,
+             std::shared_ptr<const source::SourceBuffer> source)
+    : root_(std::move(root)), source_(std::move(source)) {}
 
 Error::Error(std::unique_ptr<ErrorBase> root) : Error(std::move(root), {}) {}
 
-Error::Error(const Error& rhs)
-    : root_(rhs.root_ ? rhs.root_->Clone() : nullptr),
-      source_text_(rhs.source_text_),
-      cached_what_(rhs.cached_what_) {}
-
-Error& Error::operator=(const Error& rhs) {
-  if (this == &rhs) {
-    return *this;
-  }
-
-  root_ = rhs.root_ ? rhs.root_->Clone() : nullptr;
-  source_text_ = rhs.source_text_;
-  cached_what_ = rhs.cached_what_;
-  return *this;
-}
-
 Error Error::Message(std::string message) {
-  return Error(std::make_unique<ContextError>(std::move(message)));
+  return Error(std::make_shared<const ContextError>(std::move(message)),
+               nullptr);
 }
 
 Error Error::Context(std::string message,
                      std::optional<token::SourceSpan> context_span,
                      std::optional<CallStack> call_stack) {
-  return Error(std::make_unique<ContextError>(
-      std::move(message), nullptr, context_span, std::move(call_stack)));
+  return Error(
+      std::make_shared<const ContextError>(std::move(message), nullptr,
+                                           context_span, std::move(call_stack)),
+      nullptr);
 }
 
 Error Error::FromException(std::string message, std::exception_ptr exception,
                            std::optional<token::SourceSpan> context_span,
                            std::optional<CallStack> call_stack) {
-  return Error(std::make_unique<ContextError>(
-      std::move(message), nullptr, context_span, std::move(call_stack),
-      std::move(exception)));
+  return Error(std::make_shared<const ContextError>(
+                   std::move(message), nullptr, context_span,
+                   std::move(call_stack), std::move(exception)),
+               nullptr);
 }
 
 Error Error::FromCurrentException(std::string message,
@@ -229,7 +182,8 @@ Error Error::FromCurrentException(std::string message,
 }
 
 Error&& Error::Wrap(std::string message) && {
-  root_ = std::make_unique<ContextError>(std::move(message), std::move(root_));
+  root_ =
+      std::make_shared<const ContextError>(std::move(message), std::move(root_));
   cached_what_.clear();
   return std::move(*this);
 }
@@ -246,24 +200,40 @@ Error&& Error::Wrap(std::string message, CallStack call_stack) && {
 Error&& Error::Wrap(std::string message,
                     std::optional<token::SourceSpan> context_span,
                     std::optional<CallStack> call_stack) && {
-  root_ = std::make_unique<ContextError>(std::move(message), std::move(root_),
-                                         context_span, std::move(call_stack));
+  root_ = std::make_shared<const ContextError>(
+      std::move(message), std::move(root_), context_span, std::move(call_stack));
   cached_what_.clear();
   return std::move(*this);
 }
 
 Error&& Error::AttachSourceText(std::string source_text) && {
-  if (source_text_.empty()) {
-    source_text_ = std::move(source_text);
+  if (!HasSourceText()) {
+    source_ = std::make_shared<const source::SourceBuffer>(
+        std::move(source_text));
+  }
+  return std::move(*this);
+}
+
+Error&& Error::AttachSource(
+    std::shared_ptr<const source::SourceBuffer> source) && {
+  if (!HasSourceText()) {
+    source_ = std::move(source);
   }
   return std::move(*this);
 }
 
 const ErrorBase* Error::Root() const noexcept { return root_.get(); }
 
-const std::string& Error::SourceText() const noexcept { return source_text_; }
+std::string_view Error::SourceText() const noexcept {
+  return source_ != nullptr ? source_->Text() : std::string_view{};
+}
+
+const std::shared_ptr<const source::SourceBuffer>& Error::GetSource()
+    const noexcept {
+  return source_;
+}
 
-bool Error::HasSourceText() const noexcept { return !source_text_.empty(); }
+bool Error::HasSourceText() const noexcept { return !SourceText().empty(); }
 
 std::string Error::BuildWhat() const {
   std::ostringstream out;
@@ -345,13 +315,24 @@ std::string Error::RenderPlain() const {
   return out.str();
 }
 
-std::string Error::RenderPretty() const { return RenderPretty(source_text_); }
+std::string Error::RenderPretty() const {
+  if (!HasSourceText()) {
+    return RenderPlain();
+  }
+
+  return RenderPretty(source_->Text(), source_->Lines());
+}
 
 std::string Error::RenderPretty(std::string_view source_text) const {
   if (source_text.empty()) {
     return RenderPlain();
   }
 
+  return RenderPretty(source_text, source::LineIndex(source_text));
+}
+
+std::string Error::RenderPretty(std::string_view source_text,
+                                const source::LineIndex& lines) const {
   const auto chain = CollectChain(root_.get());
   std::ostringstream out;
 
@@ -367,7 +348,8 @@ std::string Error::RenderPretty(std::string_view source_text) const {
       wrote_source_section = true;
     }
 
-    out << "\n\n" << RenderSpanSnippet(source_text, *span, current->what());
+    out << "\n\n" << RenderSpanSnippet(source_text, lines, *span,
+                                       current->what());
     if (const auto* call_stack = current->GetCallStack()) {
       AppendCallStack(&out, *call_stack);
     }
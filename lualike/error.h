@@ -9,6 +9,7 @@
 #include <string_view>
 #include <vector>
 
+#include "lualike/source.h"
 #include "lualike/token.h"
 
 namespace lualike::error {
@@ -24,15 +25,12 @@ using CallStack = std::vector<CallFrame>;
 
 class ErrorBase : public std::runtime_error {
   std::exception_ptr exception_ptr_;
-  std::unique_ptr<ErrorBase> source_;
-
- protected:
-  std::unique_ptr<ErrorBase> CloneSource() const;
-  std::exception_ptr GetStoredExceptionPtr() const noexcept;
+  // Shared, since errors are immutable once constructed.
+  std::shared_ptr<const ErrorBase> source_;
 
  public:
   explicit ErrorBase(std::string message,
-                     std::unique_ptr<ErrorBase> source = nullptr,
+                     std::shared_ptr<const ErrorBase> source = nullptr,
                      std::exception_ptr exception_ptr = {});
 
   ErrorBase(const ErrorBase&) = delete;
@@ -41,7 +39,6 @@ class ErrorBase : public std::runtime_error {
   ErrorBase& operator=(ErrorBase&&) noexcept = default;
   ~ErrorBase() override = default;
 
-  virtual std::unique_ptr<ErrorBase> Clone() const = 0;
   virtual std::optional<token::SourceSpan> GetContextSpan() const noexcept;
   std::optional<std::string_view> GetContext(
       std::string_view source_text) const noexcept;
@@ -57,31 +54,35 @@ class ContextError final : public ErrorBase {
 
  public:
   explicit ContextError(std::string message,
-                        std::unique_ptr<ErrorBase> source = nullptr,
+                        std::shared_ptr<const ErrorBase> source = nullptr,
                         std::optional<token::SourceSpan> context_span =
                             std::nullopt,
                         std::optional<CallStack> call_stack = std::nullopt,
                         std::exception_ptr exception_ptr = {});
 
-  std::unique_ptr<ErrorBase> Clone() const override;
   std::optional<token::SourceSpan> GetContextSpan() const noexcept override;
   const CallStack* GetCallStack() const noexcept override;
 };
 
+// Copies share the immutable chain of ErrorBases and the source, so copying an
+// Error costs O(1) in the size of both.
 class Error : public std::exception {
-  std::unique_ptr<ErrorBase> root_;
-  std::string source_text_;
+  std::shared_ptr<const ErrorBase> root_;
+  std::shared_ptr<const source::SourceBuffer> source_;
   mutable std::string cached_what_;
 
-  explicit Error(std::unique_ptr<ErrorBase> root, std::string source_text);
+  explicit Error(std::shared_ptr<const ErrorBase> root,
+                 std::shared_ptr<const source::SourceBuffer> source);
 
   std::string BuildWhat() const;
+  std::string RenderPretty(std::string_view source_text,
+                           const source::LineIndex& lines) const;
 
  public:
   explicit Error(std::unique_ptr<ErrorBase> root);
 
-  Error(const Error& rhs);
-  Error& operator=(const Error& rhs);
+  Error(const Error&) = default;
+  Error& operator=(const Error&) = default;
   Error(Error&&) noexcept = default;
   Error& operator=(Error&&) noexcept = default;
   ~Error() override = default;
@@ -107,10 +108,15 @@ class Error : public std::exception {
   Error&& Wrap(std::string message,
                std::optional<token::SourceSpan> context_span,
                std::optional<CallStack> call_stack) &&;
+  // Both keep a source that is already attached.
   Error&& AttachSourceText(std::string source_text) &&;
+  // Shares the source, and its line index, with every other error attached to
+  // it.
+  Error&& AttachSource(std::shared_ptr<const source::SourceBuffer> source) &&;
 
   const ErrorBase* Root() const noexcept;
-  const std::string& SourceText() const noexcept;
+  std::string_view SourceText() const noexcept;
+  const std::shared_ptr<const source::SourceBuffer>& GetSource() const noexcept;
   bool HasSourceText() const noexcept;
 
   const char* what() const noexcept override;
@@ -0,0 +1,403 @@
+#include "lualike/flat_ast.h"
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <print>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace lualike::ast {
+
+namespace {
+
+using Index = FlatProgram::Index;
+using ExpressionKind = FlatProgram::ExpressionKind;
+using StatementKind = FlatProgram::StatementKind;
+
+// Node kinds are converted from the index of the alternative held by the node.
+static_assert(std::is_same_v<
+              std::variant_alternative_t<
+                  static_cast<size_t>(ExpressionKind::kFunctionCall),
+                  decltype(Expression::node)>,
+              FunctionCallExpression>);
+static_assert(std::is_same_v<
+              std::variant_alternative_t<
+                  static_cast<size_t>(StatementKind::kFunctionDeclaration),
+                  decltype(Statement::node)>,
+              FunctionDeclaration>);
+
+class Flattener {
+  FlatProgram program_;
+
+  template <typename T>
+  static Index IndexOf(const std::vector<T>& table) {
+    return static_cast<Index>(table.size());
+  }
+
+  Index AddName(const value::InternedString& name);
+  Index AddSlot(const std::optional<LocalSlot>& slot);
+  Index AddExpression(const Expression& expression);
+  Index AddOptionalExpression(const std::optional<Expression>& expression);
+  Index AddBlock(const Block& block);
+  void FillStatement(Index index, const Statement& statement);
+
+  template <typename ExprT>
+  void FillExpressionNode(Index index, const ExprT& expr);
+  template <typename StmtT>
+  void FillStatementNode(Index index, const StmtT& stmt);
+
+ public:
+  FlatProgram Flatten(const Program& program) &&;
+};
+
+Index Flattener::AddName(const value::InternedString& name) {
+  const auto index = IndexOf(program_.names);
+  program_.names.push_back(name);
+  return index;
+}
+
+Index Flattener::AddSlot(const std::optional<LocalSlot>& slot) {
+  if (!slot) {
+    return FlatProgram::kNone;
+  }
+
+  const auto index = IndexOf(program_.slots);
+  program_.slots.push_back(*slot);
+  return index;
+}
+
+Index Flattener::AddExpression(const Expression& expression) {
+  auto& expressions = program_.expressions;
+  const auto index = IndexOf(expressions.kinds);
+  expressions.kinds.push_back(
+      static_cast<ExpressionKind>(expression.node.index()));
+  expressions.ops.push_back(0);
+  expressions.a.push_back(FlatProgram::kNone);
+  expressions.b.push_back(FlatProgram::kNone);
+  expressions.spans.push_back(expression.span);
+
+  std::visit(
+      [this, index](const auto& expr) { FillExpressionNode(index, expr); },
+      expression.node);
+  return index;
+}
+
+Index Flattener::AddOptionalExpression(
+    const std::optional<Expression>& expression) {
+  return expression ? AddExpression(*expression) : FlatProgram::kNone;
+}
+
+Index Flattener::AddBlock(const Block& block) {
+  const auto index = IndexOf(program_.blocks.statements);
+  const auto first_statement = IndexOf(program_.statements.kinds);
+  const auto statement_count = static_cast<Index>(block.statements.size());
+  program_.blocks.statements.push_back({first_statement, statement_count});
+  program_.blocks.slot_counts.push_back(block.slot_count);
+  program_.blocks.spans.push_back(block.span);
+
+  // Reserves the whole range first, so that the statements of nested blocks
+  // are appended after it and this block stays contiguous.
+  auto& statements = program_.statements;
+  const auto new_size = static_cast<size_t>(first_statement) + statement_count;
+  statements.kinds.resize(new_size);
+  statements.a.resize(new_size, FlatProgram::kNone);
+  statements.b.resize(new_size, FlatProgram::kNone);
+  statements.c.resize(new_size, FlatProgram::kNone);
+  statements.spans.resize(new_size);
+
+  for (Index i = 0; i < statement_count; ++i) {
+    FillStatement(first_statement + i, block.statements[i]);
+  }
+
+  return index;
+}
+
+void Flattener::FillStatement(Index index, const Statement& statement) {
+  program_.statements.kinds[index] =
+      static_cast<StatementKind>(statement.node.index());
+  program_.statements.spans[index] = statement.span;
+
+  std::visit(
+      [this, index](const auto& stmt) { FillStatementNode(index, stmt); },
+      statement.node);
+}
+
+template <typename ExprT>
+void Flattener::FillExpressionNode(Index index, const ExprT& expr) {
+  using T = std::decay_t<decltype(expr)>;
+  auto& expressions = program_.expressions;
+
+  if constexpr (std::is_same_v<T, LiteralExpression>) {
+    expressions.a[index] = IndexOf(program_.literals);
+    program_.literals.push_back(expr.value);
+  }
+
+  else if constexpr (std::is_same_v<T, VariableExpression>) {
+    expressions.a[index] = AddName(expr.name);
+    expressions.b[index] = AddSlot(expr.slot);
+  }
+
+  else if constexpr (std::is_same_v<T, UnaryExpression>) {
+    expressions.ops[index] = static_cast<uint8_t>(expr.op);
+    const auto rhs = AddExpression(*expr.rhs);
+    expressions.a[index] = rhs;
+  }
+
+  else if constexpr (std::is_same_v<T, BinaryExpression>) {
+    expressions.ops[index] = static_cast<uint8_t>(expr.op);
+    const auto lhs = AddExpression(*expr.lhs);
+    const auto rhs = AddExpression(*expr.rhs);
+    expressions.a[index] = lhs;
+    expressions.b[index] = rhs;
+  }
+
+  else if constexpr (std::is_same_v<T, FunctionCallExpression>) {
+    const auto callee = AddExpression(*expr.callee);
+    std::vector<Index> arguments;
+    arguments.reserve(expr.arguments.size());
+    for (const auto& argument : expr.arguments) {
+      arguments.push_back(AddExpression(argument));
+    }
+
+    expressions.a[index] = callee;
+    expressions.b[index] = IndexOf(program_.ranges);
+    program_.ranges.push_back(
+        {IndexOf(program_.arguments), static_cast<Index>(arguments.size())});
+    program_.arguments.insert(program_.arguments.end(), arguments.begin(),
+                              arguments.end());
+  }
+
+  else {
+    static_assert(false, "Non-exhaustive visitor!");
+  }
+}
+
+template <typename StmtT>
+void Flattener::FillStatementNode(Index index, const StmtT& stmt) {
+  using T = std::decay_t<decltype(stmt)>;
+
+  // The table may grow while children are added, so the operands are computed
+  // before they are stored.
+  Index a = FlatProgram::kNone;
+  Index b = FlatProgram::kNone;
+  Index c = FlatProgram::kNone;
+
+  if constexpr (std::is_same_v<T, ExpressionStatement>) {
+    a = AddExpression(stmt.expression);
+  }
+
+  else if constexpr (std::is_same_v<T, ReturnStatement>) {
+    a = AddOptionalExpression(stmt.expression);
+  }
+
+  else if constexpr (std::is_same_v<T, VariableDeclaration>) {
+    a = AddName(stmt.name);
+    b = AddOptionalExpression(stmt.initializer);
+    c = AddSlot(stmt.slot);
+  }
+
+  else if constexpr (std::is_same_v<T, Assignment>) {
+    // The assigned variable gets the span of the statement, which the tree
+    // walker reports for unknown variables.
+    a = AddExpression(
+        Expression{stmt.variable, program_.statements.spans[index]});
+    b = AddExpression(stmt.value);
+  }
+
+  else if constexpr (std::is_same_v<T, IfStatement>) {
+    a = AddExpression(stmt.condition);
+    b = AddBlock(*stmt.then_branch);
+    if (stmt.else_branch) {
+      c = AddBlock(*stmt.else_branch);
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, FunctionDeclaration>) {
+    a = AddName(stmt.name);
+    b = AddBlock(*stmt.body);
+    c = IndexOf(program_.functions);
+    program_.functions.push_back(
+        {.params = {IndexOf(program_.params),
+                    static_cast<Index>(stmt.params.size())},
+         .slot = AddSlot(stmt.slot)});
+    for (const auto& param : stmt.params) {
+      program_.params.push_back(AddName(param));
+    }
+  }
+
+  else {
+    static_assert(false, "Non-exhaustive visitor!");
+  }
+
+  program_.statements.a[index] = a;
+  program_.statements.b[index] = b;
+  program_.statements.c[index] = c;
+}
+
+FlatProgram Flattener::Flatten(const Program& program) && {
+  AddBlock(program);
+  return std::move(program_);
+}
+
+void AppendIndent(std::ostream* out, int indent) {
+  if (indent > 0) {
+    std::print(*out, "{: >{}}", "", indent * 2);
+  }
+}
+
+void PrintBlock(const FlatProgram& program, Index index, std::ostream* out,
+                int indent);
+
+void PrintExpression(const FlatProgram& program, Index index,
+                     std::ostream* out, int indent) {
+  const auto& expressions = program.expressions;
+  const auto a = expressions.a[index];
+  const auto b = expressions.b[index];
+
+  AppendIndent(out, indent);
+  switch (expressions.kinds[index]) {
+    case ExpressionKind::kLiteral:
+      std::println(*out, "LiteralExpression: {}",
+                   program.literals[a].ToString());
+      break;
+
+    case ExpressionKind::kVariable:
+      std::println(*out, "VariableExpression: {}", program.names[a]);
+      break;
+
+    case ExpressionKind::kUnary:
+      std::println(*out, "UnaryExpression: {}",
+                   UnaryOperatorToString(
+                       static_cast<UnaryOperator>(expressions.ops[index])));
+      PrintExpression(program, a, out, indent + 1);
+      break;
+
+    case ExpressionKind::kBinary:
+      std::println(*out, "BinaryExpression: {}",
+                   BinaryOperatorToString(
+                       static_cast<BinaryOperator>(expressions.ops[index])));
+      PrintExpression(program, a, out, indent + 1);
+      PrintExpression(program, b, out, indent + 1);
+      break;
+
+    case ExpressionKind::kFunctionCall: {
+      std::println(*out, "FunctionCallExpression");
+
+      AppendIndent(out, indent + 1);
+      std::println(*out, "Callee:");
+      PrintExpression(program, a, out, indent + 2);
+
+      AppendIndent(out, indent + 1);
+      std::println(*out, "Arguments:");
+      const auto range = program.ranges[b];
+      for (Index i = 0; i < range.count; ++i) {
+        PrintExpression(program, program.arguments[range.begin + i], out,
+                        indent + 2);
+      }
+      break;
+    }
+  }
+}
+
+void PrintStatement(const FlatProgram& program, Index index, std::ostream* out,
+                    int indent) {
+  const auto& statements = program.statements;
+  const auto a = statements.a[index];
+  const auto b = statements.b[index];
+  const auto c = statements.c[index];
+
+  AppendIndent(out, indent);
+  switch (statements.kinds[index]) {
+    case StatementKind::kExpression:
+      std::println(*out, "ExpressionStatement");
+      PrintExpression(program, a, out, indent + 1);
+      break;
+
+    case StatementKind::kReturn:
+      std::println(*out, "ReturnStatement");
+      if (a != FlatProgram::kNone) {
+        PrintExpression(program, a, out, indent + 1);
+      }
+      break;
+
+    case StatementKind::kVariableDeclaration:
+      std::println(*out, "VariableDeclaration: {}", program.names[a]);
+      if (b != FlatProgram::kNone) {
+        PrintExpression(program, b, out, indent + 1);
+      }
+      break;
+
+    case StatementKind::kAssignment:
+      std::println(*out, "Assignment");
+      PrintExpression(program, a, out, indent + 1);
+      PrintExpression(program, b, out, indent + 1);
+      break;
+
+    case StatementKind::kIf:
+      std::println(*out, "IfStatement");
+
+      AppendIndent(out, indent + 1);
+      std::println(*out, "Condition:");
+      PrintExpression(program, a, out, indent + 2);
+
+      AppendIndent(out, indent + 1);
+      std::println(*out, "Then:");
+      PrintBlock(program, b, out, indent + 2);
+
+      if (c != FlatProgram::kNone) {
+        AppendIndent(out, indent + 1);
+        std::println(*out, "Else:");
+        PrintBlock(program, c, out, indent + 2);
+      }
+      break;
+
+    case StatementKind::kFunctionDeclaration: {
+      const auto range = program.functions[c].params;
+      std::vector<std::string_view> params;
+      params.reserve(range.count);
+      for (Index i = 0; i < range.count; ++i) {
+        params.push_back(program.names[program.params[range.begin + i]]);
+      }
+
+      std::println(*out, "FunctionDeclaration: {}({:n:s})", program.names[a],
+                   params);
+      PrintBlock(program, b, out, indent + 1);
+      break;
+    }
+  }
+}
+
+void PrintBlock(const FlatProgram& program, Index index, std::ostream* out,
+                int indent) {
+  AppendIndent(out, indent);
+  std::print(*out, "Block\n");
+
+  const auto range = program.blocks.statements[index];
+  for (Index i = 0; i < range.count; ++i) {
+    PrintStatement(program, range.begin + i, out, indent + 1);
+  }
+}
+
+}  // namespace
+
+FlatProgram Flatten(const Program& program) {
+  return Flattener{}.Flatten(program);
+}
+
+std::string ToString(const FlatProgram& program) {
+  std::stringstream ss;
+  PrintTo(program, &ss);
+  return ss.str();
+}
+
+void PrintTo(const FlatProgram& program, std::ostream* out) {
+  PrintBlock(program, 0, out, 0);
+}
+
+}  // namespace lualike::ast
@@ -0,0 +1,102 @@
+#ifndef LUALIKE_FLAT_AST_H_
+#define LUALIKE_FLAT_AST_H_
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "lualike/ast.h"
+#include "lualike/interned_string.h"
+#include "lualike/token.h"
+#include "lualike/value.h"
+
+namespace lualike::ast {
+
+// A flattened, index-based form of a Program.
+//
+// Expressions, statements and blocks live in separate struct-of-arrays tables
+// and refer to each other by 32-bit indices instead of pointers. Each table
+// stores the kinds, spans and operands of its nodes in parallel vectors; the
+// meaning of the operands depends on the kind of the node and is listed next to
+// the kind. The statements of a block are stored contiguously. Block 0 is the
+// program itself.
+struct FlatProgram {
+  using Index = uint32_t;
+
+  static constexpr Index kNone = std::numeric_limits<Index>::max();
+
+  struct Range {
+    Index begin{};
+    Index count{};
+  };
+
+  // Both kinds follow the order of the alternatives of the node variants.
+  enum class ExpressionKind : uint8_t {
+    kLiteral,       // a: index into `literals`.
+    kVariable,      // a: index into `names`, b: index into `slots` or kNone.
+    kUnary,         // op: UnaryOperator, a: operand.
+    kBinary,        // op: BinaryOperator, a: lhs, b: rhs.
+    kFunctionCall,  // a: callee, b: index into `ranges` of `arguments`.
+  };
+
+  enum class StatementKind : uint8_t {
+    kExpression,           // a: expression.
+    kReturn,               // a: expression or kNone.
+    kVariableDeclaration,  // a: name, b: init or kNone, c: slot or kNone.
+    kAssignment,           // a: kVariable expression, b: value.
+    kIf,                   // a: condition, b: then block, c: else or kNone.
+    kFunctionDeclaration,  // a: name, b: body block, c: index into `functions`.
+  };
+
+  struct Function {
+    // Of `params`.
+    Range params;
+    // Index into `slots` or kNone.
+    Index slot{kNone};
+  };
+
+  struct Expressions {
+    std::vector<ExpressionKind> kinds;
+    std::vector<uint8_t> ops;
+    std::vector<Index> a;
+    std::vector<Index> b;
+    std::vector<token::SourceSpan> spans;
+  } expressions;
+
+  struct Statements {
+    std::vector<StatementKind> kinds;
+    std::vector<Index> a;
+    std::vector<Index> b;
+    std::vector<Index> c;
+    std::vector<token::SourceSpan> spans;
+  } statements;
+
+  struct Blocks {
+    std::vector<Range> statements;
+    std::vector<uint32_t> slot_counts;
+    std::vector<token::SourceSpan> spans;
+  } blocks;
+
+  std::vector<value::LualikeValue> literals;
+  std::vector<value::InternedString> names;
+  std::vector<LocalSlot> slots;
+  std::vector<Range> ranges;
+  // Expression indices of call arguments.
+  std::vector<Index> arguments;
+  // Name indices of function parameters.
+  std::vector<Index> params;
+  std::vector<Function> functions;
+};
+
+// Converts a Program, including the slots assigned by resolver::Resolve.
+FlatProgram Flatten(const Program& program);
+
+std::string ToString(const FlatProgram& program);
+// Prints the same dump as PrintTo for the Program it was flattened from.
+void PrintTo(const FlatProgram& program, std::ostream* out);
+
+}  // namespace lualike::ast
+
+#endif  // LUALIKE_FLAT_AST_H_
@@ -0,0 +1,95 @@
+#include "lualike/interned_string.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace lualike::value {
+
+class InternedString::Pool {
+  struct EntryHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view text) const noexcept {
+      return std::hash<std::string_view>{}(text);
+    }
+    size_t operator()(const Entry* entry) const noexcept { return entry->hash; }
+  };
+
+  struct EntryEqual {
+    using is_transparent = void;
+
+    static std::string_view TextOf(std::string_view text) noexcept {
+      return text;
+    }
+    static std::string_view TextOf(const Entry* entry) noexcept {
+      return entry->text;
+    }
+
+    bool operator()(const auto& lhs, const auto& rhs) const noexcept {
+      return TextOf(lhs) == TextOf(rhs);
+    }
+  };
+
+  std::mutex mutex_;
+  std::unordered_set<Entry*, EntryHash, EntryEqual> entries_;
+
+ public:
+  static Pool& Instance() {
+    // Leaked on purpose, so that strings held by other static objects can
+    // still be released during program shutdown.
+    static auto* const pool = new Pool();
+    return *pool;
+  }
+
+  Entry* Intern(std::string_view text) {
+    const auto hash = EntryHash{}(text);
+
+    const std::lock_guard lock(mutex_);
+    if (const auto it = entries_.find(text); it != entries_.end()) {
+      (*it)->ref_count.fetch_add(1, std::memory_order_relaxed);
+      return *it;
+    }
+
+    auto* const entry = new Entry{.hash = hash, .text = std::string(text)};
+    entries_.insert(entry);
+    return entry;
+  }
+
+  // Drops the last reference under the lock, so that a concurrent Intern
+  // cannot revive an entry that is being destroyed.
+  void ReleaseLast(Entry* entry) noexcept {
+    {
+      const std::lock_guard lock(mutex_);
+      if (entry->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+      }
+
+      entries_.erase(entry);
+    }
+
+    delete entry;
+  }
+};
+
+InternedString::Entry* InternedString::Intern(std::string_view text) {
+  if (text.empty()) {
+    return nullptr;
+  }
+
+  return Pool::Instance().Intern(text);
+}
+
+void InternedString::Release(Entry* entry) noexcept {
+  auto ref_count = entry->ref_count.load(std::memory_order_relaxed);
+  while (ref_count > 1) {
+    if (entry->ref_count.compare_exchange_weak(ref_count, ref_count - 1,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+      return;
+    }
+  }
+
+  Pool::Instance().ReleaseLast(entry);
+}
+
+}  // namespace lualike::value
@@ -0,0 +1,121 @@
+#ifndef LUALIKE_INTERNED_STRING_H_
+#define LUALIKE_INTERNED_STRING_H_
+
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace lualike::value {
+
+// An immutable, reference counted string whose contents are interned in a
+// process-wide pool.
+//
+// Equal contents always share one pool entry, so copies are pointer-sized and
+// equality is a pointer comparison. The length and the hash of the contents
+// are computed once, on interning. The pool is safe to use from multiple
+// threads; entries are released once the last InternedString referring to them
+// is destroyed.
+class InternedString {
+  struct Entry {
+    std::atomic<uint32_t> ref_count{1};
+    size_t hash{};
+    std::string text;
+  };
+
+  class Pool;
+
+  // Null for the empty string, which is never stored in the pool.
+  Entry* entry_{};
+
+  static Entry* Intern(std::string_view text);
+  static void Release(Entry* entry) noexcept;
+
+ public:
+  InternedString() noexcept = default;
+
+  // Implicit, so that names and string literals can be used wherever a
+  // LualikeValue::StringT is expected.
+  InternedString(std::string_view text)  // NOLINT(google-explicit-constructor)
+      : entry_(Intern(text)) {}
+  InternedString(const char* text)  // NOLINT(google-explicit-constructor)
+      : InternedString(std::string_view{text}) {}
+  InternedString(const std::string& text)  // NOLINT(google-explicit-constructor)
+      : InternedString(std::string_view{text}) {}
+
+  InternedString(const InternedString& other) noexcept : entry_(other.entry_) {
+    if (entry_ != nullptr) {
+      entry_->ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  InternedString(InternedString&& other) noexcept
+      : entry_(std::exchange(other.entry_, nullptr)) {}
+
+  InternedString& operator=(InternedString other) noexcept {
+    std::swap(entry_, other.entry_);
+    return *this;
+  }
+
+  ~InternedString() {
+    if (entry_ != nullptr) {
+      Release(entry_);
+    }
+  }
+
+  std::string_view View() const noexcept {
+    return entry_ != nullptr ? std::string_view{entry_->text}
+                             : std::string_view{};
+  }
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  operator std::string_view() const noexcept { return View(); }
+
+  size_t size() const noexcept {
+    return entry_ != nullptr ? entry_->text.size() : 0;
+  }
+  bool empty() const noexcept { return entry_ == nullptr; }
+
+  size_t Hash() const noexcept {
+    return entry_ != nullptr ? entry_->hash : std::hash<std::string_view>{}({});
+  }
+
+  friend bool operator==(const InternedString& lhs,
+                         const InternedString& rhs) noexcept {
+    return lhs.entry_ == rhs.entry_;
+  }
+
+  // Orders by contents, like std::string.
+  friend std::strong_ordering operator<=>(const InternedString& lhs,
+                                          const InternedString& rhs) noexcept {
+    if (lhs.entry_ == rhs.entry_) {
+      return std::strong_ordering::equal;
+    }
+
+    return lhs.View() <=> rhs.View();
+  }
+};
+
+}  // namespace lualike::value
+
+template <>
+struct std::hash<lualike::value::InternedString> {
+  size_t operator()(const lualike::value::InternedString& text) const noexcept {
+    return text.Hash();
+  }
+};
+
+template <>
+struct std::formatter<lualike::value::InternedString>
+    : std::formatter<std::string_view> {
+  auto format(const lualike::value::InternedString& text, auto& ctx) const {
+    return std::formatter<std::string_view>::format(text.View(), ctx);
+  }
+};
+
+#endif  // LUALIKE_INTERNED_STRING_H_
@@ -1,176 +1,417 @@
 #ifndef LUALIKE_INTERPRETER_H_
 #define LUALIKE_INTERPRETER_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <filesystem>
 #include <format>
 #include <istream>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
 #include <variant>
 
 #include "lualike/ast.h"
+#include "lualike/bytecode.h"
 #include "lualike/error.h"
+#include "lualike/flat_ast.h"
+#include "lualike/optimizer.h"
 #include "lualike/parser.h"
+#include "lualike/resolver.h"
+#include "lualike/runtime.h"
+#include "lualike/source.h"
+#include "lualike/source_file.h"
 #include "lualike/value.h"
+#include "lualike/vm.h"
 
 namespace lualike::interpreter {
 
-class Scope {
-  using NamesT = std::unordered_map<std::string, value::LualikeValue>;
+template <typename ExprT>
+value::LualikeValue ExprVisitor(const ExprT& expr, token::SourceSpan span,
+                                const Frame& frame);
+template <typename StmtT>
+std::optional<value::LualikeValue> StmtVisitor(const StmtT& stmt,
+                                               token::SourceSpan span,
+                                               const Frame& frame);
 
-  NamesT names_;
-  std::optional<std::shared_ptr<Scope>> parent_scope_;
+value::LualikeValue VisitExpression(const ast::Expression& expression,
+                                    const Frame& frame);
+std::optional<value::LualikeValue> VisitStatement(
+    const ast::Statement& statement, const Frame& frame);
+std::optional<value::LualikeValue> VisitProgram(
+    const std::shared_ptr<const ast::Program>& program, Scope& globals);
+std::optional<value::LualikeValue> VisitBlock(const ast::Block& block,
+                                              const Frame& enclosing);
+std::optional<value::LualikeValue> VisitBlockStatements(
+    const ast::Block& block, const Frame& frame);
+
+value::LualikeValue VisitFlatExpression(const ast::FlatProgram& program,
+                                        ast::FlatProgram::Index index,
+                                        const Frame& frame);
+std::optional<value::LualikeValue> VisitFlatStatement(
+    const ast::FlatProgram& program, ast::FlatProgram::Index index,
+    const Frame& frame);
+std::optional<value::LualikeValue> VisitFlatProgram(
+    const std::shared_ptr<const ast::FlatProgram>& program, Scope& globals);
+std::optional<value::LualikeValue> VisitFlatBlock(
+    const ast::FlatProgram& program, ast::FlatProgram::Index index,
+    const Frame& enclosing);
+std::optional<value::LualikeValue> VisitFlatBlockStatements(
+    const ast::FlatProgram& program, ast::FlatProgram::Index index,
+    const Frame& frame);
+
+// A function declared by a script. Shares ownership of the program its
+// declaration is part of, so it can be called after the program is gone. See
+// FunctionGlobals for the globals it runs against.
+class ScriptFunction final : public value::LualikeFunction {
+  std::shared_ptr<const void> code_;
+  const ast::FunctionDeclaration* declaration_;
+  FunctionGlobals globals_;
 
  public:
-  explicit Scope(std::shared_ptr<Scope> parent_scope)
-      : parent_scope_(std::move(parent_scope)) {}
-
-  explicit Scope() = default;
-
-  std::optional<value::LualikeValue> Get(const std::string& name) const {
-    if (const auto it = names_.find(name); it != names_.end()) {
-      return it->second;
+  ScriptFunction(std::shared_ptr<const void> code,
+                 const ast::FunctionDeclaration& declaration,
+                 Scope& globals) noexcept
+      : code_(std::move(code)),
+        declaration_(&declaration),
+        globals_(globals) {}
+
+  std::optional<value::LualikeValue> Call(
+      std::span<const value::LualikeValue> args) override {
+    const auto& body = *declaration_->body;
+    std::shared_ptr<Scope> declared_globals;
+    const auto frame = Frame::ForBody(globals_.ForCall(declared_globals), code_,
+                                      body.slot_count);
+    const auto bound = std::min(args.size(), declaration_->params.size());
+    for (uint32_t i = 0; i < bound; ++i) {
+      frame.Local({0, i}) = args[i];
     }
 
-    if (parent_scope_) {
-      return parent_scope_.value()->Get(name);
-    }
-
-    return std::nullopt;
+    return VisitBlockStatements(body, frame);
   }
+};
 
-  void Set(const std::string& name, const value::LualikeValue& value) {
-    if (names_.find(name) != names_.end()) {
-      names_[name] = value;
-      return;
-    }
+// The same for the walker over ast::FlatProgram.
+class FlatScriptFunction final : public value::LualikeFunction {
+  std::shared_ptr<const void> code_;
+  const ast::FlatProgram* program_;
+  ast::FlatProgram::Index body_;
+  uint32_t param_count_;
+  FunctionGlobals globals_;
 
-    if (parent_scope_ && parent_scope_.value()->Get(name).has_value()) {
-      parent_scope_.value()->Set(name, value);
-      return;
+ public:
+  FlatScriptFunction(std::shared_ptr<const void> code,
+                     const ast::FlatProgram& program,
+                     ast::FlatProgram::Index body, uint32_t param_count,
+                     Scope& globals) noexcept
+      : code_(std::move(code)),
+        program_(&program),
+        body_(body),
+        param_count_(param_count),
+        globals_(globals) {}
+
+  std::optional<value::LualikeValue> Call(
+      std::span<const value::LualikeValue> args) override {
+    std::shared_ptr<Scope> declared_globals;
+    const auto frame = Frame::ForBody(globals_.ForCall(declared_globals), code_,
+                                      program_->blocks.slot_counts[body_]);
+    const auto bound = std::min<size_t>(args.size(), param_count_);
+    for (uint32_t i = 0; i < bound; ++i) {
+      frame.Local({0, i}) = args[i];
     }
 
-    names_[name] = value;
+    return VisitFlatBlockStatements(*program_, body_, frame);
   }
 };
 
-inline error::Error MakeInterpreterError(
-    std::string message,
-    std::optional<token::SourceSpan> context_span = std::nullopt,
-    std::optional<error::CallStack> call_stack = std::nullopt) {
-  return error::Error::Context(std::move(message), context_span,
-                               std::move(call_stack));
-}
+namespace detail {
 
-template <typename ResultT, typename CallbackT>
-ResultT ExecuteWithForeignExceptionContext(const std::string& message,
-                                           token::SourceSpan context_span,
-                                           CallbackT&& callback) {
+template <typename CallbackT>
+std::expected<std::optional<value::LualikeValue>, error::Error>
+CatchExecutionErrors(CallbackT&& callback) noexcept {
   try {
     return std::forward<CallbackT>(callback)();
-  } catch (const error::Error&) {
-    throw;
+  } catch (error::Error& err) {
+    return std::unexpected(std::move(err));
+  } catch (const std::exception&) {
+    return std::unexpected(
+        error::Error::FromCurrentException("Internal interpreter error"));
   } catch (...) {
-    throw error::Error::FromCurrentException(message, context_span);
+    return std::unexpected(error::Error::Message("Unknown interpreter error"));
   }
 }
 
-template <typename ExprT>
-value::LualikeValue ExprVisitor(const ExprT& expr, token::SourceSpan span,
-                                std::shared_ptr<Scope> scope);
-template <typename StmtT>
-std::optional<value::LualikeValue> StmtVisitor(const StmtT& stmt,
-                                               token::SourceSpan span,
-                                               std::shared_ptr<Scope> scope);
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+ExecuteProgram(ast::Program program, std::shared_ptr<Scope> globals) noexcept {
+  return CatchExecutionErrors([&program, &globals] {
+    return VisitProgram(
+        std::make_shared<const ast::Program>(std::move(program)), *globals);
+  });
+}
 
-static bool IsTruthy(const value::LualikeValue& value);
+}  // namespace detail
 
-value::LualikeValue VisitExpression(const ast::Expression& expression,
-                                    std::shared_ptr<Scope> scope);
-std::optional<value::LualikeValue> VisitStatement(
-    const ast::Statement& statement, std::shared_ptr<Scope> scope);
-std::optional<value::LualikeValue> VisitBlock(const ast::Block& block,
-                                              std::shared_ptr<Scope> scope);
+enum class Engine : uint8_t {
+  // Walks the AST directly.
+  kTreeWalker,
+  // Compiles the AST to bytecode once and runs it on the stack-based VM.
+  kBytecode,
+  // Flattens the AST to an ast::FlatProgram once and walks that instead.
+  kFlatTreeWalker,
+};
 
-inline std::expected<std::optional<value::LualikeValue>, error::Error>
-Interpret(std::string_view input) noexcept {
-  try {
-    auto parse_result = parser::detail::ParseSourceView(input);
-    if (!parse_result) {
-      return std::unexpected(
-          std::move(parse_result).error().AttachSourceText(std::string(input)));
+// A parsed program that can be executed any number of times without going
+// through the lexer and parser again. Constants are folded once, on
+// construction. The source text is kept only to render runtime errors.
+//
+// Copies share the immutable code of the program, as do the functions it
+// declares, which keep it alive after the program is gone.
+class CompiledProgram {
+  std::shared_ptr<const ast::Program> program_;
+  // Only for Engine::kBytecode.
+  std::shared_ptr<const bytecode::Chunk> chunk_;
+  // Only for Engine::kFlatTreeWalker.
+  std::shared_ptr<const ast::FlatProgram> flat_program_;
+  // Shared with every runtime error of the program.
+  std::shared_ptr<const source::SourceBuffer> source_;
+  Engine engine_;
+
+ public:
+  explicit CompiledProgram(ast::Program program,
+                           std::shared_ptr<const source::SourceBuffer> source,
+                           Engine engine = Engine::kTreeWalker)
+      : source_(std::move(source)), engine_(engine) {
+    auto resolved = std::make_shared<ast::Program>(std::move(program));
+    optimizer::FoldConstants(*resolved);
+    resolver::Resolve(*resolved);
+    if (engine == Engine::kBytecode) {
+      chunk_ = std::make_shared<const bytecode::Chunk>(
+          bytecode::Compile(*resolved));
+    } else if (engine == Engine::kFlatTreeWalker) {
+      flat_program_ =
+          std::make_shared<const ast::FlatProgram>(ast::Flatten(*resolved));
     }
+    program_ = std::move(resolved);
+  }
 
-    return VisitBlock(parse_result.value(), std::make_shared<Scope>());
-  } catch (error::Error& err) {
-    return std::unexpected(std::move(err).AttachSourceText(std::string(input)));
-  } catch (const std::exception&) {
+  explicit CompiledProgram(ast::Program program, std::string source_text = {},
+                           Engine engine = Engine::kTreeWalker)
+      : CompiledProgram(std::move(program),
+                        source::SourceBuffer::Own(std::move(source_text)),
+                        engine) {}
+
+  const ast::Program& Program() const noexcept { return *program_; }
+  std::string_view SourceText() const noexcept { return source_->Text(); }
+  const std::shared_ptr<const source::SourceBuffer>& GetSource()
+      const noexcept {
+    return source_;
+  }
+  Engine GetEngine() const noexcept { return engine_; }
+
+  // Runs the program against a fresh global scope.
+  std::expected<std::optional<value::LualikeValue>, error::Error> Run()
+      const noexcept {
+    return Run(std::make_shared<Scope>());
+  }
+
+  // Runs the program against caller-provided globals, which may be reused
+  // across runs.
+  std::expected<std::optional<value::LualikeValue>, error::Error> Run(
+      std::shared_ptr<Scope> globals) const noexcept {
+    auto result = detail::CatchExecutionErrors(
+        [this, &globals]() -> std::optional<value::LualikeValue> {
+          if (chunk_) {
+            return vm::Execute(chunk_, std::move(globals));
+          }
+          if (flat_program_) {
+            return VisitFlatProgram(flat_program_, *globals);
+          }
+
+          return VisitProgram(program_, *globals);
+        });
+    if (!result && !source_->Text().empty()) {
+      return std::unexpected(std::move(result).error().AttachSource(source_));
+    }
+
+    return result;
+  }
+};
+
+// Parses the text of `source` in place. Errors and the returned program share
+// `source` instead of copying its text.
+inline std::expected<CompiledProgram, error::Error> Compile(
+    std::shared_ptr<const source::SourceBuffer> source,
+    Engine engine = Engine::kTreeWalker) noexcept {
+  auto parse_result = parser::detail::ParseSourceView(source->Text());
+  if (!parse_result) {
     return std::unexpected(
-        error::Error::FromCurrentException("Internal interpreter error")
-            .AttachSourceText(std::string(input)));
-  } catch (...) {
-    return std::unexpected(error::Error::Message("Unknown interpreter error")
-                               .AttachSourceText(std::string(input)));
+        std::move(parse_result).error().AttachSource(std::move(source)));
   }
+
+  return CompiledProgram(std::move(parse_result).value(), std::move(source),
+                         engine);
 }
 
-inline std::expected<std::optional<value::LualikeValue>, error::Error>
-Interpret(std::istream& input) noexcept {
+inline std::expected<CompiledProgram, error::Error> Compile(
+    std::string_view input, Engine engine = Engine::kTreeWalker) noexcept {
+  return Compile(source::SourceBuffer::Own(std::string(input)), engine);
+}
+
+// Maps or reads the file at `path`. The compiled program keeps the mapping for
+// rendering its runtime errors.
+inline std::expected<CompiledProgram, error::Error> CompileFile(
+    const std::filesystem::path& path,
+    Engine engine = Engine::kTreeWalker) noexcept {
+  auto source = source::ReadFile(path);
+  if (!source) {
+    return std::unexpected(std::move(source).error());
+  }
+
+  return Compile(std::move(source).value(), engine);
+}
+
+inline std::expected<CompiledProgram, error::Error> Compile(
+    std::istream& input, Engine engine = Engine::kTreeWalker) noexcept {
   auto source_result = parser::detail::ReadStreamToString(input);
   if (!source_result) {
     return std::unexpected(std::move(source_result).error());
   }
 
-  std::string source = std::move(source_result).value();
+  return Compile(source::SourceBuffer::Own(std::move(source_result).value()),
+                 engine);
+}
 
-  try {
-    auto parse_result = parser::detail::ParseSourceView(source);
-    if (!parse_result) {
-      return std::unexpected(
-          std::move(parse_result).error().AttachSourceText(std::move(source)));
-    }
+// Lexes the stream while reading it in chunks, see parser::ParseStream. Errors
+// of the program carry no source text.
+inline std::expected<CompiledProgram, error::Error> CompileStream(
+    std::istream& input, size_t chunk_size = lexer::Lexer::kDefaultChunkSize,
+    Engine engine = Engine::kTreeWalker) noexcept {
+  auto parse_result = parser::ParseStream(input, chunk_size);
+  if (!parse_result) {
+    return std::unexpected(std::move(parse_result).error());
+  }
 
-    return VisitBlock(parse_result.value(), std::make_shared<Scope>());
-  } catch (error::Error& err) {
-    return std::unexpected(std::move(err).AttachSourceText(std::move(source)));
-  } catch (const std::exception&) {
+  return CompiledProgram(std::move(parse_result).value(), std::string(),
+                         engine);
+}
+
+namespace detail {
+
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+InterpretSourceView(std::string_view input) noexcept {
+  auto parse_result = parser::detail::ParseSourceView(input);
+  if (!parse_result) {
+    return std::unexpected(std::move(parse_result).error());
+  }
+
+  resolver::Resolve(parse_result.value());
+  return ExecuteProgram(std::move(parse_result).value(),
+                        std::make_shared<Scope>());
+}
+
+}  // namespace detail
+
+// Copies the input into the returned error, if any.
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+Interpret(std::string_view input) noexcept {
+  auto result = detail::InterpretSourceView(input);
+  if (!result) {
     return std::unexpected(
-        error::Error::FromCurrentException("Internal interpreter error")
-            .AttachSourceText(std::move(source)));
-  } catch (...) {
-    return std::unexpected(error::Error::Message("Unknown interpreter error")
-                               .AttachSourceText(std::move(source)));
+        std::move(result).error().AttachSourceText(std::string(input)));
+  }
+
+  return result;
+}
+
+// Shares `source` with the returned error, if any.
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+Interpret(std::shared_ptr<const source::SourceBuffer> source) noexcept {
+  auto result = detail::InterpretSourceView(source->Text());
+  if (!result) {
+    return std::unexpected(
+        std::move(result).error().AttachSource(std::move(source)));
+  }
+
+  return result;
+}
+
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+InterpretFile(const std::filesystem::path& path) noexcept {
+  auto source = source::ReadFile(path);
+  if (!source) {
+    return std::unexpected(std::move(source).error());
   }
+
+  return Interpret(std::move(source).value());
+}
+
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+Interpret(std::istream& input) noexcept {
+  auto compile_result = Compile(input);
+  if (!compile_result) {
+    return std::unexpected(std::move(compile_result).error());
+  }
+
+  return compile_result->Run();
+}
+
+inline std::expected<std::optional<value::LualikeValue>, error::Error>
+InterpretStream(std::istream& input,
+                size_t chunk_size = lexer::Lexer::kDefaultChunkSize) noexcept {
+  auto parse_result = parser::ParseStream(input, chunk_size);
+  if (!parse_result) {
+    return std::unexpected(std::move(parse_result).error());
+  }
+
+  resolver::Resolve(parse_result.value());
+  return detail::ExecuteProgram(std::move(parse_result).value(),
+                                std::make_shared<Scope>());
 }
 
 inline value::LualikeValue VisitExpression(const ast::Expression& expression,
-                                           std::shared_ptr<Scope> scope) {
+                                           const Frame& frame) {
   return std::visit(
-      [&expression, scope](const auto& expr) {
-        return ExprVisitor(expr, expression.span, scope);
+      [&expression, &frame](const auto& expr) {
+        return ExprVisitor(expr, expression.span, frame);
       },
       expression.node);
 }
 
 inline std::optional<value::LualikeValue> VisitStatement(
-    const ast::Statement& statement, std::shared_ptr<Scope> scope) {
+    const ast::Statement& statement, const Frame& frame) {
   return std::visit(
-      [&statement, scope](const auto& stmt) {
-        return StmtVisitor(stmt, statement.span, scope);
+      [&statement, &frame](const auto& stmt) {
+        return StmtVisitor(stmt, statement.span, frame);
       },
       statement.node);
 }
 
-inline std::optional<value::LualikeValue> VisitBlock(
-    const ast::Block& block, std::shared_ptr<Scope> scope) {
-  const auto inner_scope = std::make_shared<Scope>(scope);
+// Functions declared by the program share `program`.
+inline std::optional<value::LualikeValue> VisitProgram(
+    const std::shared_ptr<const ast::Program>& program, Scope& globals) {
+  const RunningGlobals running(globals);
+  const std::shared_ptr<const void> code = program;
+  const auto frame = Frame::ForBody(globals, code, program->slot_count);
+  return VisitBlockStatements(*program, frame);
+}
+
+inline std::optional<value::LualikeValue> VisitBlock(const ast::Block& block,
+                                                     const Frame& enclosing) {
+  const auto frame = Frame::ForBlock(enclosing, block.slot_count);
+  return VisitBlockStatements(block, frame);
+}
+
+// Runs the statements of `block` in `frame`, which already holds its slots.
+inline std::optional<value::LualikeValue> VisitBlockStatements(
+    const ast::Block& block, const Frame& frame) {
   for (const auto& statement : block.statements) {
-    if (auto return_value = VisitStatement(statement, inner_scope)) {
+    if (auto return_value = VisitStatement(statement, frame)) {
       return return_value;
     }
   }
@@ -178,21 +419,9 @@ inline std::optional<value::LualikeValue> VisitBlock(
   return std::nullopt;
 }
 
-inline bool IsTruthy(const value::LualikeValue& value) {
-  if (std::holds_alternative<value::LualikeValue::NilT>(value.inner_value)) {
-    return false;
-  }
-
-  if (std::holds_alternative<value::LualikeValue::BoolT>(value.inner_value)) {
-    return std::get<value::LualikeValue::BoolT>(value.inner_value);
-  }
-
-  return true;
-}
-
 template <typename ExprT>
 value::LualikeValue ExprVisitor(const ExprT& expr, token::SourceSpan span,
-                                std::shared_ptr<Scope> scope) {
+                                const Frame& frame) {
   using T = std::decay_t<decltype(expr)>;
 
   if constexpr (std::is_same_v<T, ast::LiteralExpression>) {
@@ -200,7 +429,11 @@ value::LualikeValue ExprVisitor(const ExprT& expr, token::SourceSpan span,
   }
 
   else if constexpr (std::is_same_v<T, ast::VariableExpression>) {
-    if (const auto val = scope->Get(expr.name)) {
+    if (expr.slot) {
+      return frame.Local(*expr.slot);
+    }
+
+    if (const auto val = frame.Globals().Get(expr.name)) {
       return val.value();
     }
 
@@ -209,84 +442,32 @@ value::LualikeValue ExprVisitor(const ExprT& expr, token::SourceSpan span,
   }
 
   else if constexpr (std::is_same_v<T, ast::UnaryExpression>) {
-    auto rhs = VisitExpression(*expr.rhs, scope);
-
-    switch (expr.op) {
-      case ast::UnaryOperator::kNegate:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate unary negation", span, [&rhs] { return -rhs; });
-      case ast::UnaryOperator::kNot:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate logical negation", span,
-            [&rhs] { return !rhs; });
-    }
-
-    throw MakeInterpreterError("Unimplemented unary operator", span);
+    const auto rhs = VisitExpression(*expr.rhs, frame);
+    return EvaluateUnaryOperator(expr.op, rhs, span);
   }
 
   else if constexpr (std::is_same_v<T, ast::BinaryExpression>) {
-    auto lhs = VisitExpression(*expr.lhs, scope);
+    auto lhs = VisitExpression(*expr.lhs, frame);
 
     if (expr.op == ast::BinaryOperator::kAnd) {
-      return IsTruthy(lhs) ? VisitExpression(*expr.rhs, scope) : lhs;
+      return IsTruthy(lhs) ? VisitExpression(*expr.rhs, frame) : lhs;
     }
     if (expr.op == ast::BinaryOperator::kOr) {
-      return IsTruthy(lhs) ? lhs : VisitExpression(*expr.rhs, scope);
+      return IsTruthy(lhs) ? lhs : VisitExpression(*expr.rhs, frame);
     }
 
-    const auto rhs = VisitExpression(*expr.rhs, scope);
-
-    switch (expr.op) {
-      case ast::BinaryOperator::kAdd:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate addition", span,
-            [&lhs, &rhs] { return lhs + rhs; });
-      case ast::BinaryOperator::kSubtract:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate subtraction", span,
-            [&lhs, &rhs] { return lhs - rhs; });
-      case ast::BinaryOperator::kMultiply:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate multiplication", span,
-            [&lhs, &rhs] { return lhs * rhs; });
-      case ast::BinaryOperator::kDivide:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate division", span,
-            [&lhs, &rhs] { return lhs / rhs; });
-      case ast::BinaryOperator::kFloorDivide:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate floor division", span, [&lhs, &rhs] {
-              lhs.FloorDivideAndAssign(rhs);
-              return lhs;
-            });
-      case ast::BinaryOperator::kModulo:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate modulo", span,
-            [&lhs, &rhs] { return lhs % rhs; });
-      case ast::BinaryOperator::kPower:
-        return ExecuteWithForeignExceptionContext<value::LualikeValue>(
-            "Failed to evaluate exponentiation", span, [&lhs, &rhs] {
-              lhs.ExponentiateAndAssign(rhs);
-              return lhs;
-            });
-      case ast::BinaryOperator::kEqual:
-        return {lhs == rhs};
-      case ast::BinaryOperator::kNotEqual:
-        return {lhs != rhs};
-      case ast::BinaryOperator::kLessThan:
-        return {lhs < rhs};
-      case ast::BinaryOperator::kLessThanEqual:
-        return {lhs <= rhs};
-      case ast::BinaryOperator::kGreaterThan:
-        return {lhs > rhs};
-      case ast::BinaryOperator::kGreaterThanEqual:
-        return {lhs >= rhs};
-      case ast::BinaryOperator::kAnd:
-      case ast::BinaryOperator::kOr:
-        break;
-    }
+    const auto rhs = VisitExpression(*expr.rhs, frame);
+    return EvaluateBinaryOperator(expr.op, std::move(lhs), rhs, span);
+  }
 
-    throw MakeInterpreterError("Unimplemented binary operator", span);
+  else if constexpr (std::is_same_v<T, ast::FunctionCallExpression>) {
+    const auto callee = VisitExpression(*expr.callee, frame);
+    return CallWithArguments(
+        callee, expr.arguments.size(),
+        [&expr, &frame](size_t i) {
+          return VisitExpression(expr.arguments[i], frame);
+        },
+        span);
   }
 
   throw MakeInterpreterError("Unimplemented expression type", span);
@@ -295,23 +476,30 @@ value::LualikeValue ExprVisitor(const ExprT& expr, token::SourceSpan span,
 template <typename StmtT>
 std::optional<value::LualikeValue> StmtVisitor(const StmtT& stmt,
                                                token::SourceSpan span,
-                                               std::shared_ptr<Scope> scope) {
+                                               const Frame& frame) {
   using T = std::decay_t<decltype(stmt)>;
 
   if constexpr (std::is_same_v<T, ast::VariableDeclaration>) {
     value::LualikeValue value;
     if (stmt.initializer) {
-      value = VisitExpression(stmt.initializer.value(), scope);
+      value = VisitExpression(stmt.initializer.value(), frame);
     }
 
-    scope->Set(stmt.name, value);
+    if (stmt.slot) {
+      frame.Local(*stmt.slot) = std::move(value);
+    } else {
+      frame.Globals().Set(stmt.name, value);
+    }
   }
 
   else if constexpr (std::is_same_v<T, ast::Assignment>) {
-    auto value = VisitExpression(stmt.value, scope);
+    auto value = VisitExpression(stmt.value, frame);
+    auto& globals = frame.Globals();
 
-    if (const auto var_value = scope->Get(stmt.variable.name)) {
-      scope->Set(stmt.variable.name, value);
+    if (stmt.variable.slot) {
+      frame.Local(*stmt.variable.slot) = std::move(value);
+    } else if (globals.Get(stmt.variable.name)) {
+      globals.Set(stmt.variable.name, value);
     } else {
       throw MakeInterpreterError(
           std::format("Unknown variable: '{}'", stmt.variable.name), span);
@@ -319,27 +507,220 @@ std::optional<value::LualikeValue> StmtVisitor(const StmtT& stmt,
   }
 
   else if constexpr (std::is_same_v<T, ast::IfStatement>) {
-    auto condition = VisitExpression(stmt.condition, scope);
+    auto condition = VisitExpression(stmt.condition, frame);
 
     if (IsTruthy(condition)) {
-      return VisitBlock(*stmt.then_branch, scope);
+      return VisitBlock(*stmt.then_branch, frame);
     }
 
     if (stmt.else_branch) {
-      return VisitBlock(*stmt.else_branch, scope);
+      return VisitBlock(*stmt.else_branch, frame);
     }
   }
 
   else if constexpr (std::is_same_v<T, ast::ReturnStatement>) {
     if (stmt.expression.has_value()) {
-      return VisitExpression(stmt.expression.value(), scope);
+      return VisitExpression(stmt.expression.value(), frame);
     }
 
-    return std::nullopt;
+    // A bare return yields nil, so that it still ends the enclosing blocks.
+    return value::LualikeValue{};
   }
 
   else if constexpr (std::is_same_v<T, ast::ExpressionStatement>) {
-    VisitExpression(stmt.expression, scope);
+    VisitExpression(stmt.expression, frame);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::FunctionDeclaration>) {
+    value::LualikeValue function{std::make_shared<ScriptFunction>(
+        frame.Code(), stmt, frame.Globals())};
+
+    if (stmt.slot) {
+      frame.Local(*stmt.slot) = std::move(function);
+    } else {
+      frame.Globals().Set(stmt.name, function);
+    }
+  }
+
+  return std::nullopt;
+}
+
+// The walker over ast::FlatProgram mirrors the visitors above node by node.
+
+inline value::LualikeValue VisitFlatExpression(const ast::FlatProgram& program,
+                                               ast::FlatProgram::Index index,
+                                               const Frame& frame) {
+  using Kind = ast::FlatProgram::ExpressionKind;
+  const auto& expressions = program.expressions;
+  const auto a = expressions.a[index];
+  const auto b = expressions.b[index];
+  const auto span = expressions.spans[index];
+
+  switch (expressions.kinds[index]) {
+    case Kind::kLiteral:
+      return program.literals[a];
+
+    case Kind::kVariable: {
+      if (b != ast::FlatProgram::kNone) {
+        return frame.Local(program.slots[b]);
+      }
+
+      if (auto val = frame.Globals().Get(program.names[a])) {
+        return std::move(val).value();
+      }
+
+      throw MakeInterpreterError(
+          std::format("Unknown variable: '{}'", program.names[a]), span);
+    }
+
+    case Kind::kUnary: {
+      const auto rhs = VisitFlatExpression(program, a, frame);
+      return EvaluateUnaryOperator(
+          static_cast<ast::UnaryOperator>(expressions.ops[index]), rhs, span);
+    }
+
+    case Kind::kBinary: {
+      const auto op = static_cast<ast::BinaryOperator>(expressions.ops[index]);
+      auto lhs = VisitFlatExpression(program, a, frame);
+
+      if (op == ast::BinaryOperator::kAnd) {
+        return IsTruthy(lhs) ? VisitFlatExpression(program, b, frame) : lhs;
+      }
+      if (op == ast::BinaryOperator::kOr) {
+        return IsTruthy(lhs) ? lhs : VisitFlatExpression(program, b, frame);
+      }
+
+      const auto rhs = VisitFlatExpression(program, b, frame);
+      return EvaluateBinaryOperator(op, std::move(lhs), rhs, span);
+    }
+
+    case Kind::kFunctionCall: {
+      const auto callee = VisitFlatExpression(program, a, frame);
+      const auto range = program.ranges[b];
+      return CallWithArguments(
+          callee, range.count,
+          [&program, &frame, range](size_t i) {
+            return VisitFlatExpression(
+                program, program.arguments[range.begin + i], frame);
+          },
+          span);
+    }
+  }
+
+  throw MakeInterpreterError("Unimplemented expression type", span);
+}
+
+inline std::optional<value::LualikeValue> VisitFlatStatement(
+    const ast::FlatProgram& program, ast::FlatProgram::Index index,
+    const Frame& frame) {
+  using Kind = ast::FlatProgram::StatementKind;
+  constexpr auto kNone = ast::FlatProgram::kNone;
+  const auto& statements = program.statements;
+  const auto a = statements.a[index];
+  const auto b = statements.b[index];
+  const auto c = statements.c[index];
+
+  switch (statements.kinds[index]) {
+    case Kind::kVariableDeclaration: {
+      value::LualikeValue value;
+      if (b != kNone) {
+        value = VisitFlatExpression(program, b, frame);
+      }
+
+      if (c != kNone) {
+        frame.Local(program.slots[c]) = std::move(value);
+      } else {
+        frame.Globals().Set(program.names[a], value);
+      }
+      break;
+    }
+
+    case Kind::kAssignment: {
+      auto value = VisitFlatExpression(program, b, frame);
+      auto& globals = frame.Globals();
+      const auto name = program.expressions.a[a];
+      const auto slot = program.expressions.b[a];
+
+      if (slot != kNone) {
+        frame.Local(program.slots[slot]) = std::move(value);
+      } else if (globals.Get(program.names[name])) {
+        globals.Set(program.names[name], value);
+      } else {
+        throw MakeInterpreterError(
+            std::format("Unknown variable: '{}'", program.names[name]),
+            statements.spans[index]);
+      }
+      break;
+    }
+
+    case Kind::kIf: {
+      const auto condition = VisitFlatExpression(program, a, frame);
+
+      if (IsTruthy(condition)) {
+        return VisitFlatBlock(program, b, frame);
+      }
+
+      if (c != kNone) {
+        return VisitFlatBlock(program, c, frame);
+      }
+      break;
+    }
+
+    case Kind::kReturn:
+      if (a != kNone) {
+        return VisitFlatExpression(program, a, frame);
+      }
+      return value::LualikeValue{};
+
+    case Kind::kExpression:
+      VisitFlatExpression(program, a, frame);
+      break;
+
+    case Kind::kFunctionDeclaration: {
+      const auto& function = program.functions[c];
+      value::LualikeValue value{std::make_shared<FlatScriptFunction>(
+          frame.Code(), program, b, function.params.count, frame.Globals())};
+
+      if (function.slot != kNone) {
+        frame.Local(program.slots[function.slot]) = std::move(value);
+      } else {
+        frame.Globals().Set(program.names[a], value);
+      }
+      break;
+    }
+  }
+
+  return std::nullopt;
+}
+
+// Block 0 is the program itself. Functions declared by the program share
+// `program`.
+inline std::optional<value::LualikeValue> VisitFlatProgram(
+    const std::shared_ptr<const ast::FlatProgram>& program, Scope& globals) {
+  const RunningGlobals running(globals);
+  const std::shared_ptr<const void> code = program;
+  const auto frame =
+      Frame::ForBody(globals, code, program->blocks.slot_counts[0]);
+  return VisitFlatBlockStatements(*program, 0, frame);
+}
+
+inline std::optional<value::LualikeValue> VisitFlatBlock(
+    const ast::FlatProgram& program, ast::FlatProgram::Index index,
+    const Frame& enclosing) {
+  const auto frame =
+      Frame::ForBlock(enclosing, program.blocks.slot_counts[index]);
+  return VisitFlatBlockStatements(program, index, frame);
+}
+
+inline std::optional<value::LualikeValue> VisitFlatBlockStatements(
+    const ast::FlatProgram& program, ast::FlatProgram::Index index,
+    const Frame& frame) {
+  const auto range = program.blocks.statements[index];
+  for (auto statement = range.begin; statement < range.begin + range.count;
+       ++statement) {
+    if (auto return_value = VisitFlatStatement(program, statement, frame)) {
+      return return_value;
+    }
   }
 
   return std::nullopt;
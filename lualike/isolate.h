@@ -0,0 +1,75 @@
+#ifndef LUALIKE_ISOLATE_H_
+#define LUALIKE_ISOLATE_H_
+
+#include <expected>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "lualike/error.h"
+#include "lualike/interpreter.h"
+#include "lualike/runtime.h"
+#include "lualike/state.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+// One thread's instance of a program that many threads run at once.
+//
+// Every isolate of a program shares the compiled program and, optionally, the
+// globals of a prelude, neither of which is modified by running it. An isolate
+// owns its globals, forked copy-on-write from the prelude, so the values a run
+// creates and the globals it sets are never seen by other isolates:
+//
+//   State prelude;
+//   prelude.Run(prelude_source);
+//   auto program = std::make_shared<const CompiledProgram>(*Compile(rule));
+//   // On each worker thread:
+//   Isolate isolate(program, prelude);
+//   for (const auto& request : requests) {
+//     isolate.Globals().Set("request", request);
+//     isolate.Run();
+//     isolate.Reset();
+//   }
+//
+// The thread-safety contract of the library is:
+//  - A CompiledProgram is immutable once constructed. Any number of threads may
+//    run it at once, each against globals of its own.
+//  - A Scope, State or Isolate is used by one thread at a time. Isolates may be
+//    created from the same prelude on several threads at once, as long as none
+//    of them modifies the prelude meanwhile.
+//  - Values may be copied between threads. Strings and functions are reference
+//    counted atomically; strings are interned process-wide, so threads that
+//    copy the same string contend on its count. A function runs against the
+//    globals of the thread that calls it.
+//  - Host functions run on the thread of the isolate that calls them and have
+//    to be thread-safe if several isolates share them.
+class Isolate {
+  std::shared_ptr<const CompiledProgram> program_;
+  State state_;
+
+ public:
+  // An isolate whose globals start out empty.
+  explicit Isolate(std::shared_ptr<const CompiledProgram> program)
+      : program_(std::move(program)), state_(program_->GetEngine()) {}
+
+  // An isolate whose globals start out as the current globals of `prelude`.
+  Isolate(std::shared_ptr<const CompiledProgram> program, const State& prelude)
+      : program_(std::move(program)), state_(prelude.Fork()) {}
+
+  Scope& Globals() noexcept { return state_.Globals(); }
+  const CompiledProgram& Program() const noexcept { return *program_; }
+
+  // Runs the program. The globals it sets persist until the next Reset.
+  std::expected<std::optional<value::LualikeValue>, error::Error>
+  Run() noexcept {
+    return state_.Run(*program_);
+  }
+
+  // Returns the globals to those the isolate started out with.
+  void Reset() { state_.Reset(); }
+};
+
+}  // namespace lualike::interpreter
+
+#endif  // LUALIKE_ISOLATE_H_
@@ -1,12 +1,19 @@
 #ifndef LUALIKE_LEXER_H_
 #define LUALIKE_LEXER_H_
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 
 #include "lualike/error.h"
+#include "lualike/scanner.h"
 #include "lualike/token.h"
 
 namespace lualike::lexer {
@@ -57,15 +64,101 @@ inline bool IsNumeric(char symbol) noexcept {
   return symbol >= '0' && symbol <= '9';
 }
 
-inline bool IsAlphanumeric(char symbol) noexcept {
-  return IsAlphabetic(symbol) || IsNumeric(symbol);
+}  // namespace
+
+namespace detail {
+
+// A window over an input stream that is read in chunks.
+//
+// The window alternates between two buffers, so that the text of the token
+// returned last stays valid while the next window is filled. A buffer only
+// grows beyond the chunk size when a single token or comment does not fit
+// into it.
+class ChunkedInput {
+  std::istream& input_;
+  size_t chunk_size_;
+  std::array<std::string, 2> buffers_;
+  size_t current_{};
+  size_t size_{};
+  size_t offset_{};
+  bool is_exhausted_ = false;
+
+ public:
+  ChunkedInput(std::istream& input, size_t chunk_size)
+      : input_(input), chunk_size_(std::max<size_t>(chunk_size, 1)) {}
+
+  std::string_view Window() const noexcept {
+    return {buffers_[current_].data(), size_};
+  }
+  // Offset of the window in the whole input.
+  size_t Offset() const noexcept { return offset_; }
+  bool IsExhausted() const noexcept { return is_exhausted_; }
+
+  // Drops the first `consumed` bytes of the window and reads more input after
+  // the rest. Moves to the other buffer if `is_window_referenced`, leaving the
+  // current one untouched until the next refill.
+  void Refill(size_t consumed, bool is_window_referenced);
+};
+
+inline void ChunkedInput::Refill(size_t consumed, bool is_window_referenced) {
+  const auto kept = Window().substr(consumed);
+  // Leaves at least half of the buffer for new input.
+  const size_t capacity = std::max(chunk_size_, 2 * kept.size());
+
+  if (is_window_referenced) {
+    auto& target = buffers_[1 - current_];
+    target.resize(std::max(target.size(), capacity));
+    std::ranges::copy(kept, target.begin());
+    current_ = 1 - current_;
+  } else {
+    // Moves the kept bytes to the front before growing, which may reallocate.
+    // They overlap with where they are moved to.
+    auto& target = buffers_[current_];
+    if (consumed != 0) {
+      std::memmove(target.data(), kept.data(), kept.size());
+    }
+    target.resize(std::max(target.size(), capacity));
+  }
+
+  offset_ += consumed;
+  size_ = kept.size();
+
+  auto& buffer = buffers_[current_];
+  input_.read(buffer.data() + size_,
+              static_cast<std::streamsize>(buffer.size() - size_));
+  size_ += static_cast<size_t>(input_.gcount());
+  if (input_.bad()) {
+    throw error::Error::Message("Failed to read input stream");
+  }
+  if (!input_) {
+    is_exhausted_ = true;
+  }
 }
 
-}  // namespace
+}  // namespace detail
 
+// Splits a source text into tokens.
+//
+// A lexer constructed from a stream reads it in chunks of a fixed size, so
+// that large inputs are lexed while they are read. The source_span of a token
+// then only stays valid until the token after the next one is requested; the
+// span offsets are relative to the whole stream.
 class Lexer {
   std::string_view source_;
   size_t cursor_{};
+  // Offset of source_ in the whole input, and where source_ comes from when
+  // lexing a stream.
+  size_t offset_{};
+  std::unique_ptr<detail::ChunkedInput> input_;
+  bool has_returned_from_window_ = false;
+
+  // Whether the input may continue after source_.
+  bool IsPartial() const noexcept {
+    return input_ != nullptr && !input_->IsExhausted();
+  }
+
+  std::optional<token::Token> ScanToken();
+  std::optional<token::Token> NextStreamedToken();
 
   token::Token ReadAlphanumeric(size_t start);
   token::Token ReadShortLiteralString(char delimiter, size_t start);
@@ -74,60 +167,68 @@ class Lexer {
   token::Token FillTokenData(token::Token t, size_t start);
 
  public:
-  explicit Lexer(std::string_view input) : source_(input) {}
-
-  std::optional<token::Token> NextToken();
-};
-
-inline token::Token Lexer::ReadAlphanumeric(size_t start) {
-  while (cursor_ < source_.size()) {
-    const char symbol = source_[cursor_];
+  static constexpr size_t kDefaultChunkSize = size_t{64} << 10U;
 
-    if (IsAlphanumeric(symbol) || symbol == '_') {
-      ++cursor_;
-    } else {
-      break;
+  explicit Lexer(std::string_view input) : source_(input) {}
+  // Lexes a part of a larger text that begins at `offset` in it.
+  Lexer(std::string_view input, size_t offset)
+      : source_(input), offset_(offset) {}
+  explicit Lexer(std::istream& input, size_t chunk_size = kDefaultChunkSize)
+      : input_(std::make_unique<detail::ChunkedInput>(input, chunk_size)) {}
+
+  std::optional<token::Token> NextToken() {
+    if (input_ == nullptr) {
+      return ScanToken();
     }
-  }
 
-  const auto token_data = source_.substr(start, cursor_ - start);
+    return NextStreamedToken();
+  }
 
-  if (const auto find_result = token::kKeywordsMap.find(token_data);
-      find_result != token::kKeywordsMap.cend()) {
-    return {.token_kind = find_result->second};
+  // After NextToken threw, skips the byte the error was raised at, so that
+  // lexing can resume after it.
+  void SkipInvalidByte() noexcept {
+    cursor_ = std::min(cursor_ + 1, source_.size());
   }
+};
 
-  return {.token_kind = token::TokenKind::kName};
+inline token::Token Lexer::ReadAlphanumeric(size_t start) {
+  cursor_ = scanner::SkipNameChars(source_, cursor_);
+
+  return {.token_kind =
+              token::FindKeyword(source_.substr(start, cursor_ - start))};
 }
 
 inline token::Token Lexer::ReadShortLiteralString(char delimiter,
                                                   size_t start) {
-  while (cursor_ < source_.size()) {
-    const char symbol = source_[cursor_];
+  cursor_ = scanner::FindByte(source_, cursor_, delimiter);
+  if (cursor_ < source_.size()) {
     ++cursor_;
+    return {.token_kind = token::TokenKind::kStringLiteral};
+  }
 
-    if (symbol == delimiter) {
-      return {.token_kind = token::TokenKind::kStringLiteral};
-    }
+  if (IsPartial()) {
+    // Rescanned once more input is available.
+    return {};
   }
 
-  throw MakeLexerError(LexerErrKind::kInvalidString, {start, cursor_});
+  throw MakeLexerError(LexerErrKind::kInvalidString,
+                       {offset_ + start, offset_ + cursor_});
 }
 
 inline token::Token Lexer::ReadNumericConstant(size_t start) {
   bool has_met_fractional_part = false;
 
-  while (cursor_ < source_.size()) {
+  while ((cursor_ = scanner::SkipDigits(source_, cursor_)) < source_.size()) {
     const char symbol = source_[cursor_];
 
-    if (symbol == '.' || symbol == ',') {
+    if (symbol == '.') {
       if (has_met_fractional_part) {
         throw MakeLexerError(LexerErrKind::kInvalidNumber,
-                             {start, cursor_ + 1});
+                             {offset_ + start, offset_ + cursor_ + 1});
       }
 
       has_met_fractional_part = true;
-    } else if (!IsNumeric(symbol)) {
+    } else {
       break;
     }
 
@@ -141,19 +242,33 @@ inline token::Token Lexer::ReadNumericConstant(size_t start) {
   return {.token_kind = token::TokenKind::kIntLiteral};
 }
 
-inline std::optional<token::Token> Lexer::NextToken() {
+inline std::optional<token::Token> Lexer::NextStreamedToken() {
+  while (true) {
+    const size_t resume_at = cursor_;
+    auto next_token = ScanToken();
+    // A token that reaches the end of the window may continue after it.
+    if (cursor_ < source_.size() || !IsPartial()) {
+      has_returned_from_window_ |= next_token.has_value();
+      return next_token;
+    }
+
+    input_->Refill(resume_at, has_returned_from_window_);
+    has_returned_from_window_ = false;
+    source_ = input_->Window();
+    offset_ = input_->Offset();
+    cursor_ = 0;
+  }
+}
+
+inline std::optional<token::Token> Lexer::ScanToken() {
   while (cursor_ < source_.size()) {
     if (IsSpace(source_[cursor_])) {
-      ++cursor_;
+      cursor_ = scanner::SkipWhitespace(source_, cursor_ + 1);
     }
 
     else if (source_[cursor_] == '-' && cursor_ + 1 < source_.size() &&
              source_[cursor_ + 1] == '-') {
-      cursor_ += 2;
-      while (cursor_ < source_.size() && source_[cursor_] != '\n') {
-        ++cursor_;
-      }
-
+      cursor_ = scanner::FindByte(source_, cursor_ + 2, '\n');
     }
 
     else {
@@ -183,28 +298,34 @@ inline std::optional<token::Token> Lexer::NextToken() {
     return FillTokenData(ReadShortLiteralString(symbol, start), start);
   }
 
-  if (cursor_ + 1 < source_.size()) {
-    if (const auto find_result =
-            token::kOtherTwoCharTokensMap.find(source_.substr(cursor_, 2));
-        find_result != token::kOtherTwoCharTokensMap.cend()) {
+  const auto& punctuation = token::FindPunctuation(symbol);
+  if (punctuation.pair != token::TokenKind::kNone) {
+    if (cursor_ + 1 == source_.size() && IsPartial()) {
+      // The second character of the pair is still to be read.
+      cursor_ = source_.size();
+      return std::nullopt;
+    }
+
+    if (cursor_ + 1 < source_.size() &&
+        source_[cursor_ + 1] == punctuation.pair_second) {
       cursor_ += 2;
-      return FillTokenData({.token_kind = find_result->second}, start);
+      return FillTokenData({.token_kind = punctuation.pair}, start);
     }
   }
 
-  const auto find_result = token::kOtherSingleCharTokensMap.find(symbol);
-  if (find_result != token::kOtherSingleCharTokensMap.cend()) {
+  if (punctuation.single != token::TokenKind::kNone) {
     ++cursor_;
-    return FillTokenData({.token_kind = find_result->second}, start);
+    return FillTokenData({.token_kind = punctuation.single}, start);
   }
 
-  throw MakeLexerError(LexerErrKind::kInvalidSymbol, {start, cursor_ + 1});
+  throw MakeLexerError(LexerErrKind::kInvalidSymbol,
+                       {offset_ + start, offset_ + cursor_ + 1});
 }
 
 inline token::Token Lexer::FillTokenData(token::Token next_token,
                                          size_t start) {
   next_token.source_span = source_.substr(start, cursor_ - start);
-  next_token.span = {start, cursor_};
+  next_token.span = {offset_ + start, offset_ + cursor_};
   return next_token;
 }
 
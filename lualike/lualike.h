@@ -1,11 +1,25 @@
 #ifndef LUALIKE_LUALIKE_H_
 #define LUALIKE_LUALIKE_H_
 
+#include "lualike/batch.h"
 #include "lualike/interpreter.h"
+#include "lualike/isolate.h"
+#include "lualike/state.h"
 
 namespace lualike {
 
+using interpreter::Compile;
+using interpreter::CompiledProgram;
+using interpreter::CompileFile;
+using interpreter::CompileStream;
+using interpreter::Engine;
+using interpreter::InputColumn;
 using interpreter::Interpret;
+using interpreter::InterpretFile;
+using interpreter::InterpretStream;
+using interpreter::Isolate;
+using interpreter::RunBatch;
+using interpreter::State;
 
 }  // namespace lualike
 
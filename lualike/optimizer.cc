@@ -0,0 +1,187 @@
+#include "lualike/optimizer.h"
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "lualike/runtime.h"
+#include "lualike/value.h"
+
+namespace lualike::optimizer {
+
+namespace {
+
+const value::LualikeValue* AsLiteral(const ast::Expression& expression) {
+  const auto* literal = std::get_if<ast::LiteralExpression>(&expression.node);
+  return literal != nullptr ? &literal->value : nullptr;
+}
+
+void FoldExpression(ast::Expression& expression);
+void FoldBlock(ast::Block& block);
+
+void FoldUnaryExpression(ast::Expression& expression,
+                         ast::UnaryExpression& unary) {
+  FoldExpression(*unary.rhs);
+  const auto* rhs = AsLiteral(*unary.rhs);
+  if (rhs == nullptr) {
+    return;
+  }
+
+  // Operations that fail are kept, so that their error is reported only if
+  // they are reached.
+  if (auto folded = interpreter::TryEvaluateUnaryOperator(unary.op, *rhs)) {
+    expression.node = ast::LiteralExpression{std::move(folded).value()};
+  }
+}
+
+void FoldBinaryExpression(ast::Expression& expression,
+                          ast::BinaryExpression& binary) {
+  FoldExpression(*binary.lhs);
+  FoldExpression(*binary.rhs);
+  const auto* lhs = AsLiteral(*binary.lhs);
+  if (lhs == nullptr) {
+    return;
+  }
+
+  if (binary.op == ast::BinaryOperator::kAnd ||
+      binary.op == ast::BinaryOperator::kOr) {
+    // The result is one of the operands, so the rhs may be kept even if it is
+    // not a literal.
+    const bool yields_lhs = interpreter::IsTruthy(*lhs) ==
+                            (binary.op == ast::BinaryOperator::kOr);
+    auto result = std::move(yields_lhs ? *binary.lhs : *binary.rhs);
+    expression = std::move(result);
+    return;
+  }
+
+  const auto* rhs = AsLiteral(*binary.rhs);
+  if (rhs == nullptr) {
+    return;
+  }
+
+  if (auto folded =
+          interpreter::TryEvaluateBinaryOperator(binary.op, *lhs, *rhs)) {
+    expression.node = ast::LiteralExpression{std::move(folded).value()};
+  }
+}
+
+void FoldExpression(ast::Expression& expression) {
+  if (auto* unary = std::get_if<ast::UnaryExpression>(&expression.node)) {
+    FoldUnaryExpression(expression, *unary);
+  } else if (auto* binary =
+                 std::get_if<ast::BinaryExpression>(&expression.node)) {
+    FoldBinaryExpression(expression, *binary);
+  } else if (auto* call =
+                 std::get_if<ast::FunctionCallExpression>(&expression.node)) {
+    FoldExpression(*call->callee);
+    for (auto& argument : call->arguments) {
+      FoldExpression(argument);
+    }
+  }
+}
+
+// A branch can replace its if statement in the enclosing block only if that
+// does not change what its statements mean there: local declarations would
+// bind in the enclosing block instead.
+bool CanSpliceIntoEnclosingBlock(const ast::Block& branch) {
+  for (const auto& statement : branch.statements) {
+    const auto* declaration =
+        std::get_if<ast::VariableDeclaration>(&statement.node);
+    if (declaration != nullptr && declaration->is_local) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Folds an if statement with a literal condition. Appends what remains of it
+// to `statements`.
+void PruneIfStatement(ast::Statement& statement, ast::IfStatement& if_stmt,
+                      const value::LualikeValue& condition,
+                      std::vector<ast::Statement>& statements) {
+  auto& taken = interpreter::IsTruthy(condition) ? if_stmt.then_branch
+                                                 : if_stmt.else_branch;
+  if (!taken) {
+    return;
+  }
+
+  if (CanSpliceIntoEnclosingBlock(*taken)) {
+    for (auto& nested : taken->statements) {
+      statements.push_back(std::move(nested));
+    }
+    return;
+  }
+
+  // Keeps the branch in its own block, behind a condition that always holds.
+  if_stmt.condition.node = ast::LiteralExpression{value::LualikeValue{true}};
+  if_stmt.then_branch = std::move(taken);
+  if_stmt.else_branch.reset();
+  statements.push_back(std::move(statement));
+}
+
+void FoldStatement(ast::Statement& statement,
+                   std::vector<ast::Statement>& statements) {
+  auto* if_stmt = std::get_if<ast::IfStatement>(&statement.node);
+  if (if_stmt != nullptr) {
+    FoldExpression(if_stmt->condition);
+    FoldBlock(*if_stmt->then_branch);
+    if (if_stmt->else_branch) {
+      FoldBlock(*if_stmt->else_branch);
+    }
+
+    if (const auto* condition = AsLiteral(if_stmt->condition)) {
+      const auto condition_value = *condition;
+      PruneIfStatement(statement, *if_stmt, condition_value, statements);
+      return;
+    }
+  }
+
+  std::visit(
+      [](auto& stmt) {
+        using T = std::decay_t<decltype(stmt)>;
+
+        if constexpr (std::is_same_v<T, ast::ExpressionStatement>) {
+          FoldExpression(stmt.expression);
+        }
+
+        else if constexpr (std::is_same_v<T, ast::ReturnStatement>) {
+          if (stmt.expression) {
+            FoldExpression(*stmt.expression);
+          }
+        }
+
+        else if constexpr (std::is_same_v<T, ast::VariableDeclaration>) {
+          if (stmt.initializer) {
+            FoldExpression(*stmt.initializer);
+          }
+        }
+
+        else if constexpr (std::is_same_v<T, ast::Assignment>) {
+          FoldExpression(stmt.value);
+        }
+
+        else if constexpr (std::is_same_v<T, ast::FunctionDeclaration>) {
+          FoldBlock(*stmt.body);
+        }
+      },
+      statement.node);
+  statements.push_back(std::move(statement));
+}
+
+void FoldBlock(ast::Block& block) {
+  std::vector<ast::Statement> statements;
+  statements.reserve(block.statements.size());
+  for (auto& statement : block.statements) {
+    FoldStatement(statement, statements);
+  }
+
+  block.statements = std::move(statements);
+}
+
+}  // namespace
+
+void FoldConstants(ast::Program& program) { FoldBlock(program); }
+
+}  // namespace lualike::optimizer
@@ -0,0 +1,22 @@
+#ifndef LUALIKE_OPTIMIZER_H_
+#define LUALIKE_OPTIMIZER_H_
+
+#include "lualike/ast.h"
+
+namespace lualike::optimizer {
+
+// Folds unary and binary expressions whose operands are literals into a single
+// literal, evaluating them with the same operators the engines use at runtime.
+// `and`/`or` with a literal left-hand side are reduced to the operand they
+// would yield. If statements with literal conditions lose the branch that can
+// never run.
+//
+// An operation that would fail is left in place, so that its error is still
+// reported when, and only if, the expression is evaluated.
+//
+// Must run before resolver::Resolve, as it may move statements between blocks.
+void FoldConstants(ast::Program& program);
+
+}  // namespace lualike::optimizer
+
+#endif  // LUALIKE_OPTIMIZER_H_
@@ -2,23 +2,31 @@
 #define LUALIKE_PARSER_H_
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <filesystem>
 #include <format>
 #include <initializer_list>
 #include <istream>
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <ranges>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <thread>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "lualike/ast.h"
 #include "lualike/error.h"
 #include "lualike/lexer.h"
+#include "lualike/source.h"
+#include "lualike/source_file.h"
 #include "lualike/value.h"
 
 namespace lualike::parser {
@@ -65,11 +73,29 @@ inline std::expected<ResultT, error::Error> AttachSourceText(
 
 }  // namespace detail
 
+struct ParseOptions {
+  // Allocates all nodes of the program in a single arena, or one per part when
+  // parsing in parallel, that is owned by the returned ast::Program and
+  // released with it in one go.
+  bool use_arena = false;
+  // Splits the source at top-level statements and parses the parts on this
+  // many threads. Sources too small to split are parsed on the calling thread.
+  unsigned parse_threads = 1;
+};
+
 class Parser {
   lexer::Lexer lexer_;
+  // Where errors are collected in recovery mode, null otherwise.
+  std::vector<error::Error>* errors_{};
   std::optional<token::Token> current_token_;
   std::optional<token::Token> previous_token_;
+  ParseOptions options_;
+  ast::Arena* arena_{};
+
+  template <typename NodeT>
+  ast::NodePtr<NodeT> MakeNode(NodeT node);
 
+  std::optional<token::Token> NextToken();
   bool IsEOF() const;
   token::SourceSpan CurrentCursorSpan() const;
   token::SourceSpan SpanFrom(const token::Token& start_token) const;
@@ -83,20 +109,52 @@ class Parser {
   token::Token Consume(token::TokenKind kind);
   bool Match(token::TokenKind kind);
 
+  void SkipToNextStatement(std::initializer_list<token::TokenKind> end_tokens,
+                           bool is_in_block);
+  bool ParseBlockStmt(std::vector<ast::Statement>& statements,
+                      std::initializer_list<token::TokenKind> end_tokens);
   ast::Statement ParseStmt();
   ast::ReturnStatement ParseRetStmt();
-  ast::VariableDeclaration ParseVarDecl(bool is_local);
+  ast::VariableDeclaration ParseVarDecl(value::InternedString name,
+                                        bool is_local);
   ast::IfStatement ParseIfStmt();
+  ast::FunctionDeclaration ParseFunctionDecl();
   ast::Block ParseBlock(std::initializer_list<token::TokenKind> end_tokens);
   ast::ExpressionStatement ParseExprStmt();
   ast::Expression ParseExpr(int min_precedence = 0);
   ast::Expression ParsePrimExpr();
+  ast::Expression ParseCallSuffixes(ast::Expression callee);
 
  public:
-  explicit Parser(std::string_view input)
-      : lexer_(input), current_token_(lexer_.NextToken()) {}
+  explicit Parser(std::string_view input, ParseOptions options = {})
+      : lexer_(input), current_token_(lexer_.NextToken()), options_(options) {}
+  // Parses a part of a larger source that begins at `offset` in it.
+  Parser(std::string_view input, size_t offset, ParseOptions options = {})
+      : lexer_(input, offset),
+        current_token_(lexer_.NextToken()),
+        options_(options) {}
+  // Lexes `input` while reading it in chunks of `chunk_size` bytes.
+  Parser(std::istream& input, size_t chunk_size, ParseOptions options = {})
+      : lexer_(input, chunk_size),
+        current_token_(lexer_.NextToken()),
+        options_(options) {}
+  // Recovers from errors instead of throwing them: each one is appended to
+  // `errors`, and parsing resumes at the next statement. The statements with
+  // errors are left out of the program.
+  Parser(std::string_view input, std::vector<error::Error>& errors,
+         ParseOptions options = {})
+      : lexer_(input),
+        errors_(&errors),
+        current_token_(NextToken()),
+        options_(options) {}
 
   ast::Program Parse();
+  // Appends top-level statements to `program` like Parse, but stops before the
+  // first one that begins at an offset accepted by `is_resync_point`. Returns
+  // whether it stopped there. New nodes go to a new arena of `program` in arena
+  // mode.
+  template <typename IsResyncPointFn>
+  bool ParseUntil(ast::Program& program, IsResyncPointFn&& is_resync_point);
 };
 
 template <typename NodeT>
@@ -126,53 +184,66 @@ inline token::SourceSpan SpanFromStatements(
                                  statements.back().span);
 }
 
-inline const std::unordered_map<token::TokenKind, int> kBinOpsPrecedences = {
-    {token::TokenKind::kKeywordOr, 1},
-    {token::TokenKind::kKeywordAnd, 2},
-    {token::TokenKind::kOtherLessThan, 3},
-    {token::TokenKind::kOtherGreaterThan, 3},
-    {token::TokenKind::kOtherLessThanEqual, 3},
-    {token::TokenKind::kOtherGreaterThanEqual, 3},
-    {token::TokenKind::kOtherTildeEqual, 3},
-    {token::TokenKind::kOtherDoubleEqual, 3},
-    {token::TokenKind::kOtherPlus, 9},
-    {token::TokenKind::kOtherMinus, 9},
-    {token::TokenKind::kOtherAsterisk, 10},
-    {token::TokenKind::kOtherSlash, 10},
-    {token::TokenKind::kOtherDoubleSlash, 10},
-    {token::TokenKind::kOtherPercent, 10},
-    {token::TokenKind::kOtherCaret, 11},
+struct BinaryOperatorEntry {
+  // -1 for tokens that are no binary operator.
+  int precedence = -1;
+  ast::BinaryOperator oper{};
+  bool is_right_associative = false;
 };
 
-inline const std::unordered_map<token::TokenKind, ast::BinaryOperator>
-    kTokenToBinOp = {
-        {token::TokenKind::kKeywordOr, ast::BinaryOperator::kOr},
-        {token::TokenKind::kKeywordAnd, ast::BinaryOperator::kAnd},
-        {token::TokenKind::kOtherLessThan, ast::BinaryOperator::kLessThan},
-        {token::TokenKind::kOtherGreaterThan,
-         ast::BinaryOperator::kGreaterThan},
-        {token::TokenKind::kOtherLessThanEqual,
-         ast::BinaryOperator::kLessThanEqual},
-        {token::TokenKind::kOtherGreaterThanEqual,
-         ast::BinaryOperator::kGreaterThanEqual},
-        {token::TokenKind::kOtherTildeEqual, ast::BinaryOperator::kNotEqual},
-        {token::TokenKind::kOtherDoubleEqual, ast::BinaryOperator::kEqual},
-        {token::TokenKind::kOtherPlus, ast::BinaryOperator::kAdd},
-        {token::TokenKind::kOtherMinus, ast::BinaryOperator::kSubtract},
-        {token::TokenKind::kOtherAsterisk, ast::BinaryOperator::kMultiply},
-        {token::TokenKind::kOtherSlash, ast::BinaryOperator::kDivide},
-        {token::TokenKind::kOtherDoubleSlash,
-         ast::BinaryOperator::kFloorDivide},
-        {token::TokenKind::kOtherPercent, ast::BinaryOperator::kModulo},
-        {token::TokenKind::kOtherCaret, ast::BinaryOperator::kPower},
-};
+inline constexpr int kUnaryPrecedence = 99;
+
+namespace detail {
+
+consteval std::array<BinaryOperatorEntry, token::kTokenKindCount>
+BuildBinaryOperatorTable() {
+  std::array<BinaryOperatorEntry, token::kTokenKindCount> table{};
+  const auto set = [&table](token::TokenKind token_kind, int precedence,
+                            ast::BinaryOperator oper) {
+    table[static_cast<size_t>(token_kind)] = {precedence, oper};
+  };
+
+  set(token::TokenKind::kKeywordOr, 1, ast::BinaryOperator::kOr);
+  set(token::TokenKind::kKeywordAnd, 2, ast::BinaryOperator::kAnd);
+  set(token::TokenKind::kOtherLessThan, 3, ast::BinaryOperator::kLessThan);
+  set(token::TokenKind::kOtherGreaterThan, 3,
+      ast::BinaryOperator::kGreaterThan);
+  set(token::TokenKind::kOtherLessThanEqual, 3,
+      ast::BinaryOperator::kLessThanEqual);
+  set(token::TokenKind::kOtherGreaterThanEqual, 3,
+      ast::BinaryOperator::kGreaterThanEqual);
+  set(token::TokenKind::kOtherTildeEqual, 3, ast::BinaryOperator::kNotEqual);
+  set(token::TokenKind::kOtherDoubleEqual, 3, ast::BinaryOperator::kEqual);
+  set(token::TokenKind::kOtherPlus, 9, ast::BinaryOperator::kAdd);
+  set(token::TokenKind::kOtherMinus, 9, ast::BinaryOperator::kSubtract);
+  set(token::TokenKind::kOtherAsterisk, 10, ast::BinaryOperator::kMultiply);
+  set(token::TokenKind::kOtherSlash, 10, ast::BinaryOperator::kDivide);
+  set(token::TokenKind::kOtherDoubleSlash, 10,
+      ast::BinaryOperator::kFloorDivide);
+  set(token::TokenKind::kOtherPercent, 10, ast::BinaryOperator::kModulo);
+  set(token::TokenKind::kOtherCaret, 11, ast::BinaryOperator::kPower);
+  table[static_cast<size_t>(token::TokenKind::kOtherCaret)]
+      .is_right_associative = true;
+
+  return table;
+}
+
+inline constexpr auto kBinaryOperatorTable = BuildBinaryOperatorTable();
+
+}  // namespace detail
+
+constexpr const BinaryOperatorEntry& FindBinaryOperator(
+    token::TokenKind token_kind) noexcept {
+  return detail::kBinaryOperatorTable[static_cast<size_t>(token_kind)];
+}
 
 inline value::LualikeValue TokenToValue(const token::Token& token) {
   try {
     switch (token.token_kind) {
       case token::TokenKind::kStringLiteral: {
         const std::string_view data = token.source_span;
-        return {std::string(data.substr(1, data.length() - 2))};
+        return {value::LualikeValue::StringT(
+            data.substr(1, data.length() - 2))};
       }
 
       case token::TokenKind::kIntLiteral:
@@ -182,7 +253,7 @@ inline value::LualikeValue TokenToValue(const token::Token& token) {
         return {std::stod(std::string(token.source_span))};
 
       case token::TokenKind::kName:
-        return {std::string(token.source_span)};
+        return {value::LualikeValue::StringT(token.source_span)};
 
       case token::TokenKind::kKeywordTrue:
         return {true};
@@ -210,11 +281,11 @@ inline value::LualikeValue TokenToValue(const token::Token& token) {
 
 namespace detail {
 
-inline std::expected<ast::Program, error::Error> ParseSourceView(
-    std::string_view input) noexcept {
+template <typename ParseFnT>
+std::expected<ast::Program, error::Error> CatchParserErrors(
+    ParseFnT&& parse) noexcept {
   try {
-    Parser parser(input);
-    return parser.Parse();
+    return std::forward<ParseFnT>(parse)();
   } catch (error::Error& err) {
     return std::unexpected(std::move(err));
   } catch (const std::exception&) {
@@ -225,28 +296,364 @@ inline std::expected<ast::Program, error::Error> ParseSourceView(
   }
 }
 
+// Parts smaller than this are not worth a thread.
+inline constexpr size_t kMinParallelPartSize = size_t{16} << 10U;
+// More parts than threads even out parts that take longer to parse.
+inline constexpr size_t kParallelPartsPerThread = 4;
+
+// Offsets at which `input` can be split into parts that parse independently,
+// including 0 and the size of the input. Splits before top-level `local`, `if`
+// and `function` statements, as none of them can continue a preceding
+// statement.
+inline std::vector<size_t> FindParallelPartBoundaries(std::string_view input,
+                                                      unsigned threads) {
+  const size_t min_part_size =
+      std::max(kMinParallelPartSize,
+               input.size() / (size_t{threads} * kParallelPartsPerThread));
+
+  std::vector<size_t> boundaries{0};
+  lexer::Lexer lexer(input);
+  int block_depth = 0;
+  while (const auto token = lexer.NextToken()) {
+    const auto token_kind = token->token_kind;
+    if (token_kind == token::TokenKind::kKeywordEnd) {
+      --block_depth;
+      continue;
+    }
+    const bool opens_block = token_kind == token::TokenKind::kKeywordIf ||
+                             token_kind == token::TokenKind::kKeywordFunction;
+    if (!opens_block && token_kind != token::TokenKind::kKeywordLocal) {
+      continue;
+    }
+
+    if (block_depth == 0 &&
+        token->span.begin - boundaries.back() >= min_part_size) {
+      boundaries.push_back(token->span.begin);
+    }
+    if (opens_block) {
+      ++block_depth;
+    }
+  }
+
+  boundaries.push_back(input.size());
+  return boundaries;
+}
+
+// Parses the parts between `boundaries` on a pool of threads and joins them in
+// order.
+//
+// If any part fails, or a part other than the last one ends with a return
+// statement, the whole source is parsed again on the calling thread, so that
+// the first error by source position is reported exactly as without threads.
+inline ast::Program ParseInParallel(std::string_view input,
+                                    const std::vector<size_t>& boundaries,
+                                    ParseOptions options) {
+  const size_t part_count = boundaries.size() - 1;
+  std::vector<std::expected<ast::Program, error::Error>> parts(part_count);
+
+  std::atomic<size_t> next_part{0};
+  const auto parse_parts = [&] {
+    for (size_t part = next_part.fetch_add(1, std::memory_order_relaxed);
+         part < part_count;
+         part = next_part.fetch_add(1, std::memory_order_relaxed)) {
+      const size_t begin = boundaries[part];
+      parts[part] = CatchParserErrors([&] {
+        return Parser(input.substr(begin, boundaries[part + 1] - begin), begin,
+                      options)
+            .Parse();
+      });
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    const size_t worker_count =
+        std::min<size_t>(options.parse_threads, part_count) - 1;
+    for (size_t worker = 0; worker < worker_count; ++worker) {
+      workers.emplace_back(parse_parts);
+    }
+    parse_parts();
+  }
+
+  ast::Program program;
+  for (size_t part = 0; part < part_count; ++part) {
+    auto& result = parts[part];
+    const bool has_trailing_return =
+        result && part + 1 < part_count && !result->statements.empty() &&
+        std::holds_alternative<ast::ReturnStatement>(
+            result->statements.back().node);
+    if (!result || has_trailing_return) {
+      return Parser(input, options).Parse();
+    }
+
+    std::ranges::move(result->statements,
+                      std::back_inserter(program.statements));
+    if (result->arena) {
+      program.part_arenas.push_back(std::move(result->arena));
+    }
+  }
+
+  program.span = SpanFromStatements(program.statements);
+  return program;
+}
+
+inline std::expected<ast::Program, error::Error> ParseSourceView(
+    std::string_view input, ParseOptions options = {}) noexcept {
+  return CatchParserErrors([input, options] {
+    if (options.parse_threads > 1 &&
+        input.size() >= 2 * kMinParallelPartSize) {
+      std::vector<size_t> boundaries;
+      try {
+        boundaries = FindParallelPartBoundaries(input, options.parse_threads);
+      } catch (const error::Error&) {
+        // Reported by the parser below, unless it fails earlier.
+      }
+
+      if (boundaries.size() > 2) {
+        return ParseInParallel(input, boundaries, options);
+      }
+    }
+
+    return Parser(input, options).Parse();
+  });
+}
+
 }  // namespace detail
 
 inline std::expected<ast::Program, error::Error> Parse(
-    std::string_view input) noexcept {
-  return detail::AttachSourceText(detail::ParseSourceView(input),
+    std::string_view input, ParseOptions options = {}) noexcept {
+  return detail::AttachSourceText(detail::ParseSourceView(input, options),
                                   std::string(input));
 }
 
+// Shares `source` with the returned error instead of copying its text.
 inline std::expected<ast::Program, error::Error> Parse(
-    std::istream& input) noexcept {
+    std::shared_ptr<const source::SourceBuffer> source,
+    ParseOptions options = {}) noexcept {
+  auto ast_result = detail::ParseSourceView(source->Text(), options);
+  if (!ast_result) {
+    return std::unexpected(
+        std::move(ast_result).error().AttachSource(std::move(source)));
+  }
+
+  return ast_result;
+}
+
+// Maps or reads the file at `path` and lexes it in place.
+inline std::expected<ast::Program, error::Error> ParseFile(
+    const std::filesystem::path& path, ParseOptions options = {}) noexcept {
+  auto source = source::ReadFile(path);
+  if (!source) {
+    return std::unexpected(std::move(source).error());
+  }
+
+  return Parse(std::move(source).value(), options);
+}
+
+inline std::expected<ast::Program, error::Error> Parse(
+    std::istream& input, ParseOptions options = {}) noexcept {
   auto source_result = detail::ReadStreamToString(input);
   if (!source_result) {
     return std::unexpected(std::move(source_result).error());
   }
 
   std::string source = std::move(source_result).value();
-  auto ast_result = detail::ParseSourceView(source);
+  auto ast_result = detail::ParseSourceView(source, options);
   return detail::AttachSourceText(std::move(ast_result), std::move(source));
 }
 
+// Unlike Parse(std::istream&), lexes the stream while reading it in chunks of
+// `chunk_size` bytes instead of reading it whole first, so memory stays bounded
+// by the size of the program rather than of its text. Errors point at offsets
+// in the stream but carry no source text to render.
+inline std::expected<ast::Program, error::Error> ParseStream(
+    std::istream& input, size_t chunk_size = lexer::Lexer::kDefaultChunkSize,
+    ParseOptions options = {}) noexcept {
+  return detail::CatchParserErrors(
+      [&] { return Parser(input, chunk_size, options).Parse(); });
+}
+
+struct RecoveredProgram {
+  // The statements that parsed, without the ones that have errors.
+  ast::Program program;
+  // Every error in the source, in the order they were found.
+  std::vector<error::Error> errors;
+};
+
+namespace detail {
+
+inline RecoveredProgram ParseRecoveringSourceView(std::string_view input,
+                                                  ParseOptions options) {
+  RecoveredProgram result;
+  auto ast_result = CatchParserErrors(
+      [&] { return Parser(input, result.errors, options).Parse(); });
+  if (ast_result) {
+    result.program = std::move(ast_result).value();
+  } else {
+    result.errors.push_back(std::move(ast_result).error());
+  }
+
+  return result;
+}
+
+}  // namespace detail
+
+// Unlike Parse, does not stop at the first error: parsing resumes at the next
+// statement after each one, so that a single pass finds every error. The source
+// is parsed on the calling thread, whatever `options.parse_threads` is.
+inline RecoveredProgram ParseRecovering(
+    std::shared_ptr<const source::SourceBuffer> source,
+    ParseOptions options = {}) noexcept {
+  auto result = detail::ParseRecoveringSourceView(source->Text(), options);
+  for (auto& err : result.errors) {
+    std::move(err).AttachSource(source);
+  }
+
+  return result;
+}
+
+// Copies the input once into a buffer that all errors share, if there are any.
+inline RecoveredProgram ParseRecovering(std::string_view input,
+                                        ParseOptions options = {}) noexcept {
+  auto result = detail::ParseRecoveringSourceView(input, options);
+  if (!result.errors.empty()) {
+    const auto source = source::SourceBuffer::Own(std::string(input));
+    for (auto& err : result.errors) {
+      std::move(err).AttachSource(source);
+    }
+  }
+
+  return result;
+}
+
+// A replacement of `range` in a source text by `replacement`.
+struct TextEdit {
+  token::SourceSpan range;
+  std::string_view replacement;
+};
+
+namespace detail {
+
+// Past this many arenas, a reparse in arena mode starts over with a full parse
+// to release the arenas of replaced statements.
+inline constexpr size_t kMaxReparseArenas = 32;
+
+inline ast::Program ReparseEdited(ast::Program previous, std::string_view input,
+                                  const TextEdit& edit, ParseOptions options) {
+  const size_t edit_end = edit.range.begin + edit.replacement.size();
+  if (edit.range.begin > edit.range.end || edit_end > input.size() ||
+      input.substr(edit.range.begin, edit.replacement.size()) !=
+          edit.replacement) {
+    throw MakeParserError("Edit does not match the edited source");
+  }
+
+  auto& old_statements = previous.statements;
+  if (old_statements.empty() ||
+      previous.part_arenas.size() >= kMaxReparseArenas) {
+    return Parser(input, options).Parse();
+  }
+
+  // The statement before the first one that reaches the edit is reparsed too:
+  // its first token is unchanged, but the edit may extend it.
+  const auto reaches_edit = std::ranges::partition_point(
+      old_statements, [&edit](const ast::Statement& statement) {
+        return statement.span.end < edit.range.begin;
+      });
+  const size_t reparse_from =
+      std::max<size_t>(reaches_edit - old_statements.begin(), 1) - 1;
+  const size_t reparse_offset =
+      reparse_from == 0 ? 0 : old_statements[reparse_from].span.begin;
+
+  // Parsing can resume with the old statements once a top-level statement
+  // begins where one of them did, after the edit.
+  const size_t shift = edit.replacement.size() - edit.range.size();
+  auto resync_candidate = std::ranges::partition_point(
+      old_statements, [&edit](const ast::Statement& statement) {
+        return statement.span.begin < edit.range.end;
+      });
+  const auto is_resync_point = [&](size_t offset) {
+    while (resync_candidate != old_statements.end() &&
+           resync_candidate->span.begin + shift < offset) {
+      ++resync_candidate;
+    }
+    return resync_candidate != old_statements.end() &&
+           resync_candidate->span.begin + shift == offset;
+  };
+
+  ast::Program program;
+  program.arena = std::move(previous.arena);
+  program.part_arenas = std::move(previous.part_arenas);
+  program.statements.reserve(old_statements.size());
+  std::move(old_statements.begin(), old_statements.begin() + reparse_from,
+            std::back_inserter(program.statements));
+
+  Parser parser(input.substr(reparse_offset), reparse_offset, options);
+  if (parser.ParseUntil(program, is_resync_point)) {
+    for (auto& statement :
+         std::ranges::subrange(resync_candidate, old_statements.end())) {
+      ast::ShiftSpans(statement, shift);
+      program.statements.push_back(std::move(statement));
+    }
+  }
+
+  if (program.statements.empty()) {
+    return Parser(input, options).Parse();
+  }
+
+  program.span = SpanFromStatements(program.statements);
+  return program;
+}
+
+}  // namespace detail
+
+// Parses `input`, the text that results from applying `edit` to the source of
+// `previous`, by reparsing only the top-level statements the edit may affect.
+// The others are moved over from `previous`, with their spans shifted.
+//
+// `previous` must be the unmodified result of a parse of the source before the
+// edit. Errors are the same as those of a full parse of `input`.
+inline std::expected<ast::Program, error::Error> Reparse(
+    ast::Program previous, std::shared_ptr<const source::SourceBuffer> input,
+    const TextEdit& edit, ParseOptions options = {}) noexcept {
+  auto ast_result = detail::CatchParserErrors([&] {
+    return detail::ReparseEdited(std::move(previous), input->Text(), edit,
+                                 options);
+  });
+  if (!ast_result) {
+    return std::unexpected(
+        std::move(ast_result).error().AttachSource(std::move(input)));
+  }
+
+  return ast_result;
+}
+
+// Copies the input into the returned error, if any.
+inline std::expected<ast::Program, error::Error> Reparse(
+    ast::Program previous, std::string_view input, const TextEdit& edit,
+    ParseOptions options = {}) noexcept {
+  return detail::AttachSourceText(
+      detail::CatchParserErrors([&] {
+        return detail::ReparseEdited(std::move(previous), input, edit,
+                                     options);
+      }),
+      std::string(input));
+}
+
 inline ast::Program Parser::Parse() {
   ast::Program program;
+  ParseUntil(program, [](size_t /*offset*/) { return false; });
+  program.span = SpanFromStatements(program.statements, CurrentCursorSpan());
+  return program;
+}
+
+template <typename IsResyncPointFn>
+bool Parser::ParseUntil(ast::Program& program,
+                        IsResyncPointFn&& is_resync_point) {
+  if (options_.use_arena) {
+    auto& arena = program.arena ? program.part_arenas.emplace_back()
+                                : program.arena;
+    arena = std::make_unique<ast::Arena>();
+    arena_ = arena.get();
+  }
   auto& stmts = program.statements;
 
   while (!IsEOF()) {
@@ -255,18 +662,36 @@ inline ast::Program Parser::Parse() {
     if (IsEOF()) {
       break;
     }
+    if (is_resync_point(Peek().span.begin)) {
+      return true;
+    }
 
-    auto statement = ParseStmt();
-    const bool terminates_program = IsBlockTerminatedBy(statement);
-    stmts.push_back(std::move(statement));
-    if (terminates_program) {
-      EnsureBlockEndsAfterReturn();
+    if (ParseBlockStmt(stmts, {})) {
       break;
     }
   }
 
-  program.span = SpanFromStatements(program.statements, CurrentCursorSpan());
-  return program;
+  return false;
+}
+
+template <typename NodeT>
+ast::NodePtr<NodeT> Parser::MakeNode(NodeT node) {
+  return ast::MakeNode<NodeT>(arena_, std::move(node));
+}
+
+inline std::optional<token::Token> Parser::NextToken() {
+  while (true) {
+    try {
+      return lexer_.NextToken();
+    } catch (error::Error& err) {
+      if (errors_ == nullptr) {
+        throw;
+      }
+
+      errors_->push_back(std::move(err));
+      lexer_.SkipInvalidByte();
+    }
+  }
 }
 
 inline bool Parser::IsEOF() const { return !current_token_.has_value(); }
@@ -333,7 +758,7 @@ inline token::Token Parser::Advance() {
 
   auto token = *current_token_;
   previous_token_ = token;
-  current_token_ = lexer_.NextToken();
+  current_token_ = NextToken();
   return token;
 }
 
@@ -360,47 +785,153 @@ inline bool Parser::Match(token::TokenKind kind) {
   return true;
 }
 
+// Skips the rest of a statement that failed to parse, up to where the next
+// statement of a block ending at `end_tokens` may begin: before a keyword that
+// begins a statement or ends the block, or past a `;` or a stray `end`. The
+// body of an if statement or function that failed before its `end` is skipped
+// with it.
+inline void Parser::SkipToNextStatement(
+    std::initializer_list<token::TokenKind> end_tokens, bool is_in_block) {
+  int block_depth = is_in_block ? 1 : 0;
+  while (!IsEOF()) {
+    const auto token_kind = Peek().token_kind;
+    const bool opens_block = token_kind == token::TokenKind::kKeywordIf ||
+                             token_kind == token::TokenKind::kKeywordFunction;
+    if (block_depth == 0) {
+      if (IsAtAnyOf(end_tokens) || opens_block ||
+          token_kind == token::TokenKind::kKeywordLocal ||
+          token_kind == token::TokenKind::kKeywordReturn) {
+        return;
+      }
+      if (token_kind == token::TokenKind::kOtherSemicolon ||
+          token_kind == token::TokenKind::kKeywordEnd) {
+        Advance();
+        return;
+      }
+    } else if (opens_block) {
+      ++block_depth;
+    } else if (token_kind == token::TokenKind::kKeywordEnd &&
+               --block_depth == 0) {
+      Advance();
+      return;
+    }
+
+    Advance();
+  }
+}
+
+// Parses the next statement of a block ending at `end_tokens` into
+// `statements`, and returns whether it ends the block.
+//
+// When recovering from errors, the statements that wrongly follow a return are
+// still parsed for their errors, but left out of the block.
+inline bool Parser::ParseBlockStmt(
+    std::vector<ast::Statement>& statements,
+    std::initializer_list<token::TokenKind> end_tokens) {
+  const bool opens_block =
+      IsAtAnyOf({token::TokenKind::kKeywordIf,
+                 token::TokenKind::kKeywordFunction});
+  try {
+    auto statement = ParseStmt();
+    const bool terminates_block = IsBlockTerminatedBy(statement);
+    statements.push_back(std::move(statement));
+    if (!terminates_block) {
+      return false;
+    }
+  } catch (error::Error& err) {
+    if (errors_ == nullptr) {
+      throw;
+    }
+
+    errors_->push_back(std::move(err));
+    SkipToNextStatement(end_tokens, opens_block);
+    return false;
+  }
+
+  try {
+    EnsureBlockEndsAfterReturn(end_tokens);
+  } catch (error::Error& err) {
+    if (errors_ == nullptr) {
+      throw;
+    }
+
+    errors_->push_back(std::move(err));
+    std::vector<ast::Statement> discarded;
+    while (!IsEOF() && !IsAtAnyOf(end_tokens) &&
+           !ParseBlockStmt(discarded, end_tokens)) {
+      ConsumeOptionalSemicolons();
+    }
+  }
+
+  return true;
+}
+
 inline ast::Statement Parser::ParseStmt() {
   ConsumeOptionalSemicolons();
 
+  // The span is taken once the statement is parsed; as arguments of one call
+  // the two could be evaluated in either order.
   const auto start_token = Peek();
+  ast::Statement statement;
   switch (start_token.token_kind) {
-    case token::TokenKind::kName:
-      return MakeStatement(ParseVarDecl(false), SpanFrom(start_token));
+    case token::TokenKind::kName: {
+      // Interned right away, as the text of a streamed token doesn't outlive
+      // the tokens after it.
+      value::InternedString name(Advance().source_span);
+      if (IsAtAnyOf({token::TokenKind::kOtherLeftParenthesis})) {
+        statement.node = ast::ExpressionStatement{ParseCallSuffixes(
+            MakeExpression(ast::VariableExpression{std::move(name)},
+                           start_token.span))};
+      } else {
+        statement.node = ParseVarDecl(std::move(name), /*is_local=*/false);
+      }
+      break;
+    }
     case token::TokenKind::kKeywordReturn:
-      return MakeStatement(ParseRetStmt(), SpanFrom(start_token));
-    case token::TokenKind::kKeywordLocal:
-      return MakeStatement(ParseVarDecl(true), SpanFrom(start_token));
+      statement.node = ParseRetStmt();
+      break;
+    case token::TokenKind::kKeywordLocal: {
+      Advance();
+      value::InternedString name(Consume(token::TokenKind::kName).source_span);
+      statement.node = ParseVarDecl(std::move(name), /*is_local=*/true);
+      break;
+    }
     case token::TokenKind::kKeywordIf:
-      return MakeStatement(ParseIfStmt(), SpanFrom(start_token));
+      statement.node = ParseIfStmt();
+      break;
+    case token::TokenKind::kKeywordFunction:
+      statement.node = ParseFunctionDecl();
+      break;
     default:
-      return MakeStatement(ParseExprStmt(), SpanFrom(start_token));
+      statement.node = ParseExprStmt();
+      break;
   }
+
+  statement.span = SpanFrom(start_token);
+  return statement;
 }
 
 inline ast::ReturnStatement Parser::ParseRetStmt() {
   Advance();
 
-  if (IsEOF() || Peek().token_kind == token::TokenKind::kOtherSemicolon) {
+  if (IsEOF() || IsAtAnyOf({token::TokenKind::kOtherSemicolon,
+                            token::TokenKind::kKeywordEnd,
+                            token::TokenKind::kKeywordElse})) {
     return {std::nullopt};
   }
 
   return {ParseExpr()};
 }
 
-inline ast::VariableDeclaration Parser::ParseVarDecl(bool is_local) {
-  if (is_local) {
-    Consume(token::TokenKind::kKeywordLocal);
-  }
-
-  const auto name_token = Consume(token::TokenKind::kName);
-
+// Parses what follows the name of a declaration.
+inline ast::VariableDeclaration Parser::ParseVarDecl(
+    value::InternedString name, bool is_local) {
   std::optional<ast::Expression> initializer;
   if (Match(token::TokenKind::kOtherEqual)) {
     initializer = ParseExpr();
   }
 
-  return {std::string(name_token.source_span), std::move(initializer)};
+  return {std::move(name), std::move(initializer), is_local};
 }
 
 inline ast::IfStatement Parser::ParseIfStmt() {
@@ -409,13 +940,12 @@ inline ast::IfStatement Parser::ParseIfStmt() {
   auto condition = ParseExpr();
 
   Consume(token::TokenKind::kKeywordThen);
-  auto then_branch = std::make_unique<ast::Block>(ParseBlock(
+  auto then_branch = MakeNode(ParseBlock(
       {token::TokenKind::kKeywordElse, token::TokenKind::kKeywordEnd}));
 
-  std::unique_ptr<ast::Block> else_branch;
+  ast::NodePtr<ast::Block> else_branch;
   if (Match(token::TokenKind::kKeywordElse)) {
-    else_branch = std::make_unique<ast::Block>(
-        ParseBlock({token::TokenKind::kKeywordEnd}));
+    else_branch = MakeNode(ParseBlock({token::TokenKind::kKeywordEnd}));
   }
 
   Consume(token::TokenKind::kKeywordEnd);
@@ -423,6 +953,32 @@ inline ast::IfStatement Parser::ParseIfStmt() {
   return {std::move(condition), std::move(then_branch), std::move(else_branch)};
 }
 
+inline ast::FunctionDeclaration Parser::ParseFunctionDecl() {
+  Advance();
+
+  value::InternedString name(Consume(token::TokenKind::kName).source_span);
+  std::vector<value::InternedString> params;
+  Consume(token::TokenKind::kOtherLeftParenthesis);
+  if (!Match(token::TokenKind::kOtherRightParenthesis)) {
+    do {
+      const auto param_token = Consume(token::TokenKind::kName);
+      value::InternedString param(param_token.source_span);
+      if (std::ranges::find(params, param) != params.end()) {
+        throw MakeParserError(
+            std::format("Duplicate parameter '{}'", param_token.source_span),
+            param_token.span);
+      }
+      params.push_back(std::move(param));
+    } while (Match(token::TokenKind::kOtherComma));
+    Consume(token::TokenKind::kOtherRightParenthesis);
+  }
+
+  auto body = MakeNode(ParseBlock({token::TokenKind::kKeywordEnd}));
+  Consume(token::TokenKind::kKeywordEnd);
+
+  return {std::move(name), std::move(params), std::move(body)};
+}
+
 inline ast::Block Parser::ParseBlock(
     std::initializer_list<token::TokenKind> end_tokens) {
   ast::Block block;
@@ -434,11 +990,7 @@ inline ast::Block Parser::ParseBlock(
       break;
     }
 
-    auto statement = ParseStmt();
-    const bool terminates_block = IsBlockTerminatedBy(statement);
-    block.statements.push_back(std::move(statement));
-    if (terminates_block) {
-      EnsureBlockEndsAfterReturn(end_tokens);
+    if (ParseBlockStmt(block.statements, end_tokens)) {
       break;
     }
   }
@@ -455,25 +1007,21 @@ inline ast::Expression Parser::ParseExpr(int min_precedence) {
   auto lhs = ParsePrimExpr();
 
   while (!IsEOF()) {
-    const auto prec_it = kBinOpsPrecedences.find(Peek().token_kind);
-    const int precedence =
-        prec_it != kBinOpsPrecedences.end() ? prec_it->second : -1;
-    if (precedence < min_precedence) {
+    const auto& binary_operator = FindBinaryOperator(Peek().token_kind);
+    if (binary_operator.precedence < min_precedence) {
       break;
     }
 
-    auto op_token = Advance();
-    const int next_precedence =
-        op_token.token_kind == token::TokenKind::kOtherCaret ? precedence
-                                                             : precedence + 1;
-    auto rhs = ParseExpr(next_precedence);
+    Advance();
+    auto rhs = ParseExpr(binary_operator.is_right_associative
+                             ? binary_operator.precedence
+                             : binary_operator.precedence + 1);
     const auto expression_span = token::MergeSourceSpans(lhs.span, rhs.span);
 
     lhs = MakeExpression(
         ast::BinaryExpression{
-            kTokenToBinOp.at(op_token.token_kind),
-            std::make_unique<ast::Expression>(std::move(lhs)),
-            std::make_unique<ast::Expression>(std::move(rhs))},
+            binary_operator.oper,
+            MakeNode(std::move(lhs)), MakeNode(std::move(rhs))},
         expression_span);
   }
 
@@ -494,12 +1042,12 @@ inline ast::Expression Parser::ParsePrimExpr() {
                             token.span);
 
     case token::TokenKind::kName:
-      return MakeExpression(
-          ast::VariableExpression{std::string(token.source_span)}, token.span);
+      return ParseCallSuffixes(MakeExpression(
+          ast::VariableExpression{value::InternedString(token.source_span)},
+          token.span));
 
     case token::TokenKind::kOtherMinus:
     case token::TokenKind::kKeywordNot: {
-      constexpr int kUnaryPrecedence = 99;
       const auto oper = token.token_kind == token::TokenKind::kOtherMinus
                             ? ast::UnaryOperator::kNegate
                             : ast::UnaryOperator::kNot;
@@ -508,7 +1056,7 @@ inline ast::Expression Parser::ParsePrimExpr() {
           token::MergeSourceSpans(token.span, rhs.span);
       return MakeExpression(
           ast::UnaryExpression{
-              oper, std::make_unique<ast::Expression>(std::move(rhs))},
+              oper, MakeNode(std::move(rhs))},
           expression_span);
     }
 
@@ -517,7 +1065,7 @@ inline ast::Expression Parser::ParsePrimExpr() {
       const auto right_paren =
           Consume(token::TokenKind::kOtherRightParenthesis);
       expr.span = token::MergeSourceSpans(token.span, right_paren.span);
-      return expr;
+      return ParseCallSuffixes(std::move(expr));
     }
 
     default:
@@ -528,6 +1076,30 @@ inline ast::Expression Parser::ParsePrimExpr() {
   }
 }
 
+// Parses the argument lists of any calls of `callee`, as in `f(1)(2)`.
+inline ast::Expression Parser::ParseCallSuffixes(ast::Expression callee) {
+  while (IsAtAnyOf({token::TokenKind::kOtherLeftParenthesis})) {
+    Advance();
+
+    std::vector<ast::Expression> arguments;
+    if (!IsAtAnyOf({token::TokenKind::kOtherRightParenthesis})) {
+      do {
+        arguments.push_back(ParseExpr());
+      } while (Match(token::TokenKind::kOtherComma));
+    }
+    const auto right_paren = Consume(token::TokenKind::kOtherRightParenthesis);
+
+    const auto call_span =
+        token::MergeSourceSpans(callee.span, right_paren.span);
+    callee = MakeExpression(
+        ast::FunctionCallExpression{MakeNode(std::move(callee)),
+                                    std::move(arguments)},
+        call_span);
+  }
+
+  return callee;
+}
+
 }  // namespace lualike::parser
 
 #endif  // LUALIKE_PARSER_H_
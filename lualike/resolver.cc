@@ -0,0 +1,179 @@
+#include "lualike/resolver.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "lualike/interned_string.h"
+
+namespace lualike::resolver {
+
+namespace {
+
+class Resolver {
+  using BlockBindings = std::unordered_map<value::InternedString, uint32_t>;
+
+  // Only nested blocks are tracked: the top-level block binds globals.
+  std::vector<BlockBindings> blocks_;
+
+  std::optional<ast::LocalSlot> Lookup(const value::InternedString& name) const;
+
+  void ResolveNestedBlock(ast::Block& block);
+  void ResolveFunctionBody(ast::FunctionDeclaration& function);
+  void ResolveStatement(ast::Statement& statement);
+  void ResolveExpression(ast::Expression& expression);
+
+  template <typename StmtT>
+  void ResolveStatementNode(StmtT& stmt);
+  template <typename ExprT>
+  void ResolveExpressionNode(ExprT& expr);
+
+ public:
+  void ResolveProgram(ast::Program& program);
+};
+
+std::optional<ast::LocalSlot> Resolver::Lookup(
+    const value::InternedString& name) const {
+  for (size_t depth = 0; depth < blocks_.size(); ++depth) {
+    const auto& bindings = blocks_[blocks_.size() - 1 - depth];
+    if (const auto it = bindings.find(name); it != bindings.end()) {
+      return ast::LocalSlot{static_cast<uint32_t>(depth), it->second};
+    }
+  }
+
+  return std::nullopt;
+}
+
+void Resolver::ResolveProgram(ast::Program& program) {
+  program.slot_count = 0;
+  for (auto& statement : program.statements) {
+    ResolveStatement(statement);
+  }
+}
+
+void Resolver::ResolveNestedBlock(ast::Block& block) {
+  blocks_.emplace_back();
+  for (auto& statement : block.statements) {
+    ResolveStatement(statement);
+  }
+
+  block.slot_count = static_cast<uint32_t>(blocks_.back().size());
+  blocks_.pop_back();
+}
+
+void Resolver::ResolveFunctionBody(ast::FunctionDeclaration& function) {
+  // The body sees its parameters and its own locals, but none of the blocks
+  // around the declaration.
+  auto enclosing_blocks = std::exchange(blocks_, {});
+  auto& params = blocks_.emplace_back();
+  for (const auto& param : function.params) {
+    params.emplace(param, static_cast<uint32_t>(params.size()));
+  }
+
+  for (auto& statement : function.body->statements) {
+    ResolveStatement(statement);
+  }
+
+  function.body->slot_count = static_cast<uint32_t>(blocks_.back().size());
+  blocks_ = std::move(enclosing_blocks);
+}
+
+void Resolver::ResolveStatement(ast::Statement& statement) {
+  std::visit([this](auto& stmt) { ResolveStatementNode(stmt); },
+             statement.node);
+}
+
+void Resolver::ResolveExpression(ast::Expression& expression) {
+  std::visit([this](auto& expr) { ResolveExpressionNode(expr); },
+             expression.node);
+}
+
+template <typename StmtT>
+void Resolver::ResolveStatementNode(StmtT& stmt) {
+  using T = std::decay_t<decltype(stmt)>;
+
+  if constexpr (std::is_same_v<T, ast::VariableDeclaration>) {
+    // The initializer is evaluated before the name is bound.
+    if (stmt.initializer) {
+      ResolveExpression(stmt.initializer.value());
+    }
+
+    if (!stmt.is_local || blocks_.empty()) {
+      stmt.slot = Lookup(stmt.name);
+      return;
+    }
+
+    // Redeclaring a local of the same block reuses its slot.
+    auto& current = blocks_.back();
+    const auto index = static_cast<uint32_t>(current.size());
+    const auto it = current.emplace(stmt.name, index).first;
+    stmt.slot = ast::LocalSlot{0, it->second};
+  }
+
+  else if constexpr (std::is_same_v<T, ast::Assignment>) {
+    ResolveExpression(stmt.value);
+    ResolveExpressionNode(stmt.variable);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::IfStatement>) {
+    ResolveExpression(stmt.condition);
+    ResolveNestedBlock(*stmt.then_branch);
+    if (stmt.else_branch) {
+      ResolveNestedBlock(*stmt.else_branch);
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, ast::ReturnStatement>) {
+    if (stmt.expression) {
+      ResolveExpression(stmt.expression.value());
+    }
+  }
+
+  else if constexpr (std::is_same_v<T, ast::ExpressionStatement>) {
+    ResolveExpression(stmt.expression);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::FunctionDeclaration>) {
+    // Binds like an assignment: a visible local of the same name, or else a
+    // global.
+    stmt.slot = Lookup(stmt.name);
+    ResolveFunctionBody(stmt);
+  }
+}
+
+template <typename ExprT>
+void Resolver::ResolveExpressionNode(ExprT& expr) {
+  using T = std::decay_t<decltype(expr)>;
+
+  if constexpr (std::is_same_v<T, ast::VariableExpression>) {
+    expr.slot = Lookup(expr.name);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::UnaryExpression>) {
+    ResolveExpression(*expr.rhs);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::BinaryExpression>) {
+    ResolveExpression(*expr.lhs);
+    ResolveExpression(*expr.rhs);
+  }
+
+  else if constexpr (std::is_same_v<T, ast::FunctionCallExpression>) {
+    ResolveExpression(*expr.callee);
+    for (auto& argument : expr.arguments) {
+      ResolveExpression(argument);
+    }
+  }
+}
+
+}  // namespace
+
+void Resolve(ast::Program& program) { Resolver{}.ResolveProgram(program); }
+
+}  // namespace lualike::resolver
@@ -0,0 +1,27 @@
+#ifndef LUALIKE_RESOLVER_H_
+#define LUALIKE_RESOLVER_H_
+
+#include "lualike/ast.h"
+
+namespace lualike::resolver {
+
+// Assigns a LocalSlot to every variable that lives in a nested block, so the
+// execution engines can address it by index instead of by name.
+//
+// Declarations in the top-level block of the program bind globals, which stay
+// name-based. Inside nested blocks only `local` declarations introduce a new
+// slot in the current block, shadowing any visible binding of the same name.
+// Declarations without `local` assign the innermost visible local of their
+// name, or else the global. Names that are not bound by any enclosing block
+// are left unresolved and are looked up in the globals at runtime.
+//
+// Function bodies start over with their parameters as the first slots of the
+// body, and don't see the locals of the blocks around their declaration. A
+// function declaration binds a visible local of its name, or else a global.
+//
+// Resolve may be run again after the program has been modified.
+void Resolve(ast::Program& program);
+
+}  // namespace lualike::resolver
+
+#endif  // LUALIKE_RESOLVER_H_
@@ -0,0 +1,486 @@
+#ifndef LUALIKE_RUNTIME_H_
+#define LUALIKE_RUNTIME_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "lualike/ast.h"
+#include "lualike/error.h"
+#include "lualike/interned_string.h"
+#include "lualike/token.h"
+#include "lualike/value.h"
+
+// Runtime pieces shared by every execution engine: variable scopes, error
+// construction and the evaluation of non-short-circuiting operators.
+namespace lualike::interpreter {
+
+// The globals of a run, stored by name.
+//
+// A scope can return to a snapshot of its bindings. While a snapshot is
+// taken, the first Set of each name records the value it replaces, so that
+// restoring the snapshot only touches the names set since.
+//
+// Forks of a scope share its bindings copy-on-write: they look names up in an
+// immutable copy of the bindings at the time of the fork, and keep only the
+// names set on them in a map of their own. The copy is made once and shared
+// by every fork until the scope is modified again. Fork may be called from
+// several threads at once, as long as none of them modifies the scope.
+//
+// Script functions refer to the scope they were declared in weakly, see
+// FunctionGlobals, for which it has to be owned by a shared_ptr.
+class Scope : public std::enable_shared_from_this<Scope> {
+  using NamesT =
+      std::unordered_map<value::InternedString, value::LualikeValue>;
+  // Previous values of the names set since the snapshot, nullopt for names
+  // that were unbound.
+  using JournalT = std::unordered_map<value::InternedString,
+                                      std::optional<value::LualikeValue>>;
+
+  // Shadows shared_.
+  NamesT names_;
+  std::shared_ptr<const NamesT> shared_;
+  std::optional<JournalT> journal_;
+  // The bindings handed to forks, reset by every modification.
+  mutable std::shared_ptr<const NamesT> frozen_;
+  mutable std::mutex fork_mutex_;
+
+ public:
+  explicit Scope() = default;
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+  std::optional<value::LualikeValue> Get(
+      const value::InternedString& name) const {
+    if (const auto it = names_.find(name); it != names_.end()) {
+      return it->second;
+    }
+
+    if (shared_) {
+      if (const auto it = shared_->find(name); it != shared_->end()) {
+        return it->second;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void Set(const value::InternedString& name,
+           const value::LualikeValue& value) {
+    if (journal_ && !journal_->contains(name)) {
+      journal_->emplace(name, Get(name));
+    }
+    names_[name] = value;
+    frozen_.reset();
+  }
+
+  // Sets `name` like Set and returns its binding, through which it can be
+  // assigned again without looking it up, for example once per row of a
+  // batch. The binding stays valid until the name is unbound. Snapshots and
+  // forks don't track assignments through it.
+  value::LualikeValue& Bind(const value::InternedString& name,
+                            const value::LualikeValue& value) {
+    Set(name, value);
+    return names_.find(name)->second;
+  }
+
+  // A new scope with the current bindings, which it shares with this scope
+  // and its other forks until either side sets them. Forks don't refer to
+  // this scope, so they may be used on other threads while it changes.
+  std::shared_ptr<Scope> Fork() const {
+    const std::lock_guard lock(fork_mutex_);
+    if (!frozen_) {
+      if (names_.empty()) {
+        frozen_ = shared_;
+      } else {
+        auto bindings =
+            shared_ ? std::make_shared<NamesT>(*shared_)
+                    : std::make_shared<NamesT>();
+        for (const auto& [name, value] : names_) {
+          (*bindings)[name] = value;
+        }
+        frozen_ = std::move(bindings);
+      }
+    }
+
+    auto fork = std::make_shared<Scope>();
+    fork->shared_ = frozen_;
+    return fork;
+  }
+
+  // Makes the current bindings the ones RestoreSnapshot returns to,
+  // replacing any earlier snapshot.
+  void TakeSnapshot() { journal_.emplace(); }
+
+  // Undoes every Set since the snapshot, which stays taken. Does nothing
+  // without a snapshot.
+  void RestoreSnapshot() {
+    if (!journal_) {
+      return;
+    }
+
+    // Names that were unbound at the snapshot can only be bound in names_.
+    for (auto& [name, previous] : *journal_) {
+      if (previous) {
+        names_[name] = std::move(previous).value();
+      } else {
+        names_.erase(name);
+      }
+    }
+    journal_->clear();
+    frozen_.reset();
+  }
+};
+
+namespace detail {
+
+inline thread_local Scope* running_globals = nullptr;
+
+}  // namespace detail
+
+// Makes `globals` the globals of the run on this thread while it exists. The
+// run owns them for its duration.
+//
+// Script functions run against the globals of the run that calls them, not
+// of the one that declared them, so that functions of a forked scope use the
+// fork they are called from. See FunctionGlobals for calls from outside any
+// run.
+class RunningGlobals {
+  Scope* previous_;
+
+ public:
+  explicit RunningGlobals(Scope& globals) noexcept
+      : previous_(std::exchange(detail::running_globals, &globals)) {}
+  RunningGlobals(const RunningGlobals&) = delete;
+  RunningGlobals& operator=(const RunningGlobals&) = delete;
+  ~RunningGlobals() { detail::running_globals = previous_; }
+};
+
+// The globals a script function runs against: those of the run that calls
+// it, see RunningGlobals, or else those it was declared under.
+//
+// A function is usually stored in the globals it was declared under, so it
+// only refers to them weakly. Called from outside any run once they are gone,
+// it runs against empty globals instead, where the first global it uses is an
+// unknown variable.
+class FunctionGlobals {
+  std::weak_ptr<Scope> declared_;
+
+ public:
+  explicit FunctionGlobals(Scope& declared) noexcept
+      : declared_(declared.weak_from_this()) {}
+
+  // Stores the globals it returns in `keep_alive` unless they belong to a
+  // run, which keeps them alive itself.
+  Scope& ForCall(std::shared_ptr<Scope>& keep_alive) const {
+    if (detail::running_globals != nullptr) {
+      return *detail::running_globals;
+    }
+
+    keep_alive = declared_.lock();
+    if (keep_alive == nullptr) {
+      keep_alive = std::make_shared<Scope>();
+    }
+    return *keep_alive;
+  }
+};
+
+namespace detail {
+
+// Slots of every frame alive on the thread, innermost last.
+inline std::vector<value::LualikeValue>& ThreadSlotStack() noexcept {
+  thread_local std::vector<value::LualikeValue> slots;
+  return slots;
+}
+
+}  // namespace detail
+
+// The activation of a block in the tree walkers, holding the slots that
+// resolver::Resolve assigned to its locals.
+//
+// Frames live on the native stack and refer to the frame of their enclosing
+// block without owning it. Their slots are pushed onto one contiguous stack
+// per thread when they are created and popped when they are destroyed, so
+// entering a block allocates nothing once that stack has grown to the deepest
+// nesting. A slot reference is invalidated by creating another frame.
+class Frame {
+  Scope* globals_;
+  // Owner of the code the frame runs, held by whoever created the body frame.
+  const std::shared_ptr<const void>* code_;
+  const Frame* enclosing_;
+  size_t base_;
+
+  Frame(Scope& globals, const std::shared_ptr<const void>& code,
+        const Frame* enclosing, size_t slot_count)
+      : globals_(&globals),
+        code_(&code),
+        enclosing_(enclosing),
+        base_(detail::ThreadSlotStack().size()) {
+    detail::ThreadSlotStack().resize(base_ + slot_count);
+  }
+
+ public:
+  Frame(const Frame&) = delete;
+  Frame& operator=(const Frame&) = delete;
+  ~Frame() { detail::ThreadSlotStack().resize(base_); }
+
+  // The frame of a program or function body, which sees no locals but its
+  // own. `code` owns the body and has to outlive the frame.
+  static Frame ForBody(Scope& globals, const std::shared_ptr<const void>& code,
+                       size_t slot_count) {
+    return {globals, code, nullptr, slot_count};
+  }
+
+  static Frame ForBlock(const Frame& enclosing, size_t slot_count) {
+    return {*enclosing.globals_, *enclosing.code_, &enclosing, slot_count};
+  }
+
+  Scope& Globals() const noexcept { return *globals_; }
+
+  // Shared by the functions declared in the frame, so that they can still be
+  // called once the run that declared them is over.
+  const std::shared_ptr<const void>& Code() const noexcept { return *code_; }
+
+  value::LualikeValue& Local(ast::LocalSlot slot) const {
+    const Frame* frame = this;
+    for (uint32_t depth = 0; depth < slot.depth; ++depth) {
+      frame = frame->enclosing_;
+    }
+
+    return detail::ThreadSlotStack()[frame->base_ + slot.index];
+  }
+};
+
+inline error::Error MakeInterpreterError(
+    std::string message,
+    std::optional<token::SourceSpan> context_span = std::nullopt,
+    std::optional<error::CallStack> call_stack = std::nullopt) {
+  return error::Error::Context(std::move(message), context_span,
+                               std::move(call_stack));
+}
+
+template <typename ResultT, typename CallbackT>
+ResultT ExecuteWithForeignExceptionContext(const std::string& message,
+                                           token::SourceSpan context_span,
+                                           CallbackT&& callback) {
+  try {
+    return std::forward<CallbackT>(callback)();
+  } catch (const error::Error&) {
+    throw;
+  } catch (...) {
+    throw error::Error::FromCurrentException(message, context_span);
+  }
+}
+
+// Same as the C-call limit of Lua, which bounds the native stack a script can
+// use through recursion.
+inline constexpr int kMaxCallDepth = 200;
+
+namespace detail {
+
+inline thread_local int call_depth = 0;
+
+class CallDepthGuard {
+ public:
+  explicit CallDepthGuard(token::SourceSpan span) {
+    if (call_depth >= kMaxCallDepth) {
+      throw error::Error::Context("Stack overflow", span);
+    }
+    ++call_depth;
+  }
+  CallDepthGuard(const CallDepthGuard&) = delete;
+  CallDepthGuard& operator=(const CallDepthGuard&) = delete;
+  ~CallDepthGuard() { --call_depth; }
+};
+
+}  // namespace detail
+
+// Calls `callee` as the call expression at `span`. A call without a result
+// evaluates to nil.
+inline value::LualikeValue CallFunction(
+    const value::LualikeValue& callee,
+    std::span<const value::LualikeValue> args, token::SourceSpan span) {
+  const auto* function =
+      std::get_if<value::LualikeValue::FuncT>(&callee.inner_value);
+  if (function == nullptr || *function == nullptr) {
+    throw MakeInterpreterError(
+        std::format("Attempt to call a non-function value: {}",
+                    callee.ToString()),
+        span);
+  }
+
+  const detail::CallDepthGuard guard(span);
+  auto result = ExecuteWithForeignExceptionContext<
+      std::optional<value::LualikeValue>>(
+      "Failed to call function", span,
+      [function, args] { return (*function)->Call(args); });
+  return std::move(result).value_or(value::LualikeValue{});
+}
+
+// Calls with up to this many arguments keep them on the native stack.
+inline constexpr size_t kInlineArgumentCount = 8;
+
+// Calls `callee` with the results of `evaluate_argument(0)` up to
+// `evaluate_argument(argument_count - 1)`, evaluated in order.
+template <typename EvaluateT>
+value::LualikeValue CallWithArguments(const value::LualikeValue& callee,
+                                      size_t argument_count,
+                                      const EvaluateT& evaluate_argument,
+                                      token::SourceSpan span) {
+  if (argument_count <= kInlineArgumentCount) {
+    std::array<value::LualikeValue, kInlineArgumentCount> args;
+    for (size_t i = 0; i < argument_count; ++i) {
+      args[i] = evaluate_argument(i);
+    }
+    return CallFunction(callee, std::span(args).first(argument_count), span);
+  }
+
+  std::vector<value::LualikeValue> args;
+  args.reserve(argument_count);
+  for (size_t i = 0; i < argument_count; ++i) {
+    args.push_back(evaluate_argument(i));
+  }
+  return CallFunction(callee, args, span);
+}
+
+inline bool IsTruthy(const value::LualikeValue& value) {
+  if (std::holds_alternative<value::LualikeValue::NilT>(value.inner_value)) {
+    return false;
+  }
+
+  if (std::holds_alternative<value::LualikeValue::BoolT>(value.inner_value)) {
+    return std::get<value::LualikeValue::BoolT>(value.inner_value);
+  }
+
+  return true;
+}
+
+// Evaluates a unary operator without throwing on an operand of the wrong type.
+inline value::LualikeValueOpResult TryEvaluateUnaryOperator(
+    ast::UnaryOperator op, const value::LualikeValue& rhs) noexcept {
+  switch (op) {
+    case ast::UnaryOperator::kNegate:
+      return value::TryNegate(rhs);
+    case ast::UnaryOperator::kNot:
+      return value::TryNot(rhs);
+  }
+
+  return std::unexpected(value::LualikeValueOpErrKind::kNormallyImpossibleErr);
+}
+
+// Evaluates every binary operator except `and`/`or`, whose short-circuiting
+// has to be handled by the engine itself, without throwing on operands of the
+// wrong type.
+inline value::LualikeValueOpResult TryEvaluateBinaryOperator(
+    ast::BinaryOperator op, const value::LualikeValue& lhs,
+    const value::LualikeValue& rhs) noexcept {
+  switch (op) {
+    case ast::BinaryOperator::kAdd:
+      return value::TryAdd(lhs, rhs);
+    case ast::BinaryOperator::kSubtract:
+      return value::TrySubtract(lhs, rhs);
+    case ast::BinaryOperator::kMultiply:
+      return value::TryMultiply(lhs, rhs);
+    case ast::BinaryOperator::kDivide:
+      return value::TryDivide(lhs, rhs);
+    case ast::BinaryOperator::kFloorDivide:
+      return value::TryFloorDivide(lhs, rhs);
+    case ast::BinaryOperator::kModulo:
+      return value::TryModulo(lhs, rhs);
+    case ast::BinaryOperator::kPower:
+      return value::TryExponentiate(lhs, rhs);
+    case ast::BinaryOperator::kEqual:
+      return value::LualikeValue{lhs == rhs};
+    case ast::BinaryOperator::kNotEqual:
+      return value::LualikeValue{lhs != rhs};
+    case ast::BinaryOperator::kLessThan:
+      return value::LualikeValue{lhs < rhs};
+    case ast::BinaryOperator::kLessThanEqual:
+      return value::LualikeValue{lhs <= rhs};
+    case ast::BinaryOperator::kGreaterThan:
+      return value::LualikeValue{lhs > rhs};
+    case ast::BinaryOperator::kGreaterThanEqual:
+      return value::LualikeValue{lhs >= rhs};
+    case ast::BinaryOperator::kAnd:
+    case ast::BinaryOperator::kOr:
+      break;
+  }
+
+  return std::unexpected(value::LualikeValueOpErrKind::kNormallyImpossibleErr);
+}
+
+// The error of an operation whose operands have the wrong type, with the kind
+// of the failure as its cause.
+inline error::Error MakeOperatorError(std::string_view operation,
+                                      value::LualikeValueOpErrKind error_kind,
+                                      token::SourceSpan span) {
+  return error::Error::Message(value::LualikeValueOpErrKindToString(error_kind))
+      .Wrap(std::format("Failed to evaluate {}", operation), span);
+}
+
+inline value::LualikeValue EvaluateUnaryOperator(
+    ast::UnaryOperator op, const value::LualikeValue& rhs,
+    token::SourceSpan span) {
+  auto result = TryEvaluateUnaryOperator(op, rhs);
+  if (result) {
+    return *std::move(result);
+  }
+
+  switch (op) {
+    case ast::UnaryOperator::kNegate:
+      throw MakeOperatorError("unary negation", result.error(), span);
+    case ast::UnaryOperator::kNot:
+      throw MakeOperatorError("logical negation", result.error(), span);
+  }
+
+  throw MakeInterpreterError("Unimplemented unary operator", span);
+}
+
+// Throwing wrapper around TryEvaluateBinaryOperator for the engines, which
+// report runtime errors as error::Error.
+inline value::LualikeValue EvaluateBinaryOperator(
+    ast::BinaryOperator op, const value::LualikeValue& lhs,
+    const value::LualikeValue& rhs, token::SourceSpan span) {
+  auto result = TryEvaluateBinaryOperator(op, lhs, rhs);
+  if (result) {
+    return *std::move(result);
+  }
+
+  switch (op) {
+    case ast::BinaryOperator::kAdd:
+      throw MakeOperatorError("addition", result.error(), span);
+    case ast::BinaryOperator::kSubtract:
+      throw MakeOperatorError("subtraction", result.error(), span);
+    case ast::BinaryOperator::kMultiply:
+      throw MakeOperatorError("multiplication", result.error(), span);
+    case ast::BinaryOperator::kDivide:
+      throw MakeOperatorError("division", result.error(), span);
+    case ast::BinaryOperator::kFloorDivide:
+      throw MakeOperatorError("floor division", result.error(), span);
+    case ast::BinaryOperator::kModulo:
+      throw MakeOperatorError("modulo", result.error(), span);
+    case ast::BinaryOperator::kPower:
+      throw MakeOperatorError("exponentiation", result.error(), span);
+    default:
+      break;
+  }
+
+  throw MakeInterpreterError("Unimplemented binary operator", span);
+}
+
+}  // namespace lualike::interpreter
+
+#endif  // LUALIKE_RUNTIME_H_
@@ -0,0 +1,268 @@
+#include "lualike/scanner.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LUALIKE_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lualike::scanner {
+
+namespace {
+
+using SkipFn = size_t (*)(std::string_view, size_t) noexcept;
+using FindFn = size_t (*)(std::string_view, size_t, char) noexcept;
+
+struct Implementation {
+  Isa isa;
+  SkipFn skip_whitespace;
+  SkipFn skip_name_chars;
+  SkipFn skip_digits;
+  FindFn find_byte;
+};
+
+using detail::IsDigitByte;
+using detail::IsNameByte;
+using detail::IsWhitespaceByte;
+
+const unsigned char* Bytes(std::string_view text) noexcept {
+  return reinterpret_cast<const unsigned char*>(text.data());
+}
+
+template <bool (*kMatches)(unsigned char) noexcept>
+size_t SkipScalar(std::string_view text, size_t pos) noexcept {
+  const auto* bytes = Bytes(text);
+  while (pos < text.size() && kMatches(bytes[pos])) {
+    ++pos;
+  }
+
+  return pos;
+}
+
+size_t FindByteScalar(std::string_view text, size_t pos, char byte) noexcept {
+  const auto found = text.find(byte, pos);
+  return found == std::string_view::npos ? text.size() : found;
+}
+
+constexpr Implementation kScalarImplementation{
+    .isa = Isa::kScalar,
+    .skip_whitespace = SkipScalar<IsWhitespaceByte>,
+    .skip_name_chars = SkipScalar<IsNameByte>,
+    .skip_digits = SkipScalar<IsDigitByte>,
+    .find_byte = FindByteScalar,
+};
+
+#ifdef LUALIKE_SCANNER_X86
+
+// The range checks compare signed bytes, so bytes of 0x80 and above never
+// match.
+__m128i InRange128(__m128i chunk, char low, char high) noexcept {
+  return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(low - 1)),
+                       _mm_cmplt_epi8(chunk, _mm_set1_epi8(high + 1)));
+}
+
+__m128i WhitespaceMask128(__m128i chunk) noexcept {
+  return _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                      InRange128(chunk, '\t', '\r'));
+}
+
+__m128i DigitMask128(__m128i chunk) noexcept {
+  return InRange128(chunk, '0', '9');
+}
+
+__m128i NameMask128(__m128i chunk) noexcept {
+  const auto lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+  return _mm_or_si128(
+      _mm_or_si128(DigitMask128(chunk), InRange128(lower, 'a', 'z')),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+}
+
+template <__m128i (*kMask)(__m128i) noexcept,
+          bool (*kMatches)(unsigned char) noexcept>
+size_t SkipSse2(std::string_view text, size_t pos) noexcept {
+  const auto* bytes = Bytes(text);
+  for (; pos + 16 <= text.size(); pos += 16) {
+    const auto chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos));
+    const auto stops =
+        ~static_cast<uint32_t>(_mm_movemask_epi8(kMask(chunk))) & 0xFFFFU;
+    if (stops != 0) {
+      return pos + static_cast<size_t>(std::countr_zero(stops));
+    }
+  }
+
+  return SkipScalar<kMatches>(text, pos);
+}
+
+size_t FindByteSse2(std::string_view text, size_t pos, char byte) noexcept {
+  const auto* bytes = Bytes(text);
+  const auto needle = _mm_set1_epi8(byte);
+  for (; pos + 16 <= text.size(); pos += 16) {
+    const auto chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos));
+    const auto matches = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+    if (matches != 0) {
+      return pos + static_cast<size_t>(std::countr_zero(matches));
+    }
+  }
+
+  return FindByteScalar(text, pos, byte);
+}
+
+constexpr Implementation kSse2Implementation{
+    .isa = Isa::kSse2,
+    .skip_whitespace = SkipSse2<WhitespaceMask128, IsWhitespaceByte>,
+    .skip_name_chars = SkipSse2<NameMask128, IsNameByte>,
+    .skip_digits = SkipSse2<DigitMask128, IsDigitByte>,
+    .find_byte = FindByteSse2,
+};
+
+[[gnu::target("avx2")]] __m256i InRange256(__m256i chunk, char low,
+                                           char high) noexcept {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(low - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chunk));
+}
+
+[[gnu::target("avx2")]] __m256i WhitespaceMask256(__m256i chunk) noexcept {
+  return _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                         InRange256(chunk, '\t', '\r'));
+}
+
+[[gnu::target("avx2")]] __m256i DigitMask256(__m256i chunk) noexcept {
+  return InRange256(chunk, '0', '9');
+}
+
+[[gnu::target("avx2")]] __m256i NameMask256(__m256i chunk) noexcept {
+  const auto lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+  return _mm256_or_si256(
+      _mm256_or_si256(DigitMask256(chunk), InRange256(lower, 'a', 'z')),
+      _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+}
+
+// Finishes with the SSE2 loop, so that runs ending in the last 31 bytes are
+// still mostly scanned 16 bytes at a time.
+template <__m256i (*kMask)(__m256i) noexcept,
+          __m128i (*kTailMask)(__m128i) noexcept,
+          bool (*kMatches)(unsigned char) noexcept>
+[[gnu::target("avx2")]] size_t SkipAvx2(std::string_view text,
+                                        size_t pos) noexcept {
+  const auto* bytes = Bytes(text);
+  for (; pos + 32 <= text.size(); pos += 32) {
+    const auto chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + pos));
+    const auto stops =
+        ~static_cast<uint32_t>(_mm256_movemask_epi8(kMask(chunk)));
+    if (stops != 0) {
+      return pos + static_cast<size_t>(std::countr_zero(stops));
+    }
+  }
+
+  return SkipSse2<kTailMask, kMatches>(text, pos);
+}
+
+[[gnu::target("avx2")]] size_t FindByteAvx2(std::string_view text, size_t pos,
+                                            char byte) noexcept {
+  const auto* bytes = Bytes(text);
+  const auto needle = _mm256_set1_epi8(byte);
+  for (; pos + 32 <= text.size(); pos += 32) {
+    const auto chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + pos));
+    const auto matches = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+    if (matches != 0) {
+      return pos + static_cast<size_t>(std::countr_zero(matches));
+    }
+  }
+
+  return FindByteSse2(text, pos, byte);
+}
+
+constexpr Implementation kAvx2Implementation{
+    .isa = Isa::kAvx2,
+    .skip_whitespace =
+        SkipAvx2<WhitespaceMask256, WhitespaceMask128, IsWhitespaceByte>,
+    .skip_name_chars = SkipAvx2<NameMask256, NameMask128, IsNameByte>,
+    .skip_digits = SkipAvx2<DigitMask256, DigitMask128, IsDigitByte>,
+    .find_byte = FindByteAvx2,
+};
+
+#endif  // LUALIKE_SCANNER_X86
+
+const Implementation* ForIsa(Isa isa) noexcept {
+  switch (isa) {
+#ifdef LUALIKE_SCANNER_X86
+    case Isa::kAvx2:
+      return &kAvx2Implementation;
+    case Isa::kSse2:
+      return &kSse2Implementation;
+#endif
+    default:
+      return &kScalarImplementation;
+  }
+}
+
+// Null until the first scan, so that it is constant-initialized and usable
+// from other static initializers.
+std::atomic<const Implementation*> active_implementation{nullptr};
+
+const Implementation& Active() noexcept {
+  const auto* implementation =
+      active_implementation.load(std::memory_order_relaxed);
+  if (implementation == nullptr) [[unlikely]] {
+    implementation = ForIsa(DetectIsa());
+    active_implementation.store(implementation, std::memory_order_relaxed);
+  }
+
+  return *implementation;
+}
+
+}  // namespace
+
+Isa DetectIsa() noexcept {
+#ifdef LUALIKE_SCANNER_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return Isa::kAvx2;
+  }
+
+  // Part of the x86-64 baseline.
+  return Isa::kSse2;
+#else
+  return Isa::kScalar;
+#endif
+}
+
+Isa ActiveIsa() noexcept { return Active().isa; }
+
+Isa SetIsa(Isa isa) noexcept {
+  const auto* implementation = ForIsa(isa > DetectIsa() ? DetectIsa() : isa);
+  active_implementation.store(implementation, std::memory_order_relaxed);
+  return implementation->isa;
+}
+
+namespace detail {
+
+size_t SkipWhitespace(std::string_view text, size_t pos) noexcept {
+  return Active().skip_whitespace(text, pos);
+}
+
+size_t SkipNameChars(std::string_view text, size_t pos) noexcept {
+  return Active().skip_name_chars(text, pos);
+}
+
+size_t SkipDigits(std::string_view text, size_t pos) noexcept {
+  return Active().skip_digits(text, pos);
+}
+
+size_t FindByte(std::string_view text, size_t pos, char byte) noexcept {
+  return Active().find_byte(text, pos, byte);
+}
+
+}  // namespace detail
+
+}  // namespace lualike::scanner
@@ -0,0 +1,98 @@
+#ifndef LUALIKE_SCANNER_H_
+#define LUALIKE_SCANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Vectorized byte scanning for the lexer.
+//
+// Every function returns the position of the first byte at or after `pos` that
+// ends the scanned run, or `text.size()` if there is none. The implementation
+// is selected once at runtime from the best instruction set the CPU supports;
+// all of them return the same results.
+namespace lualike::scanner {
+
+enum class Isa : uint8_t {
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+// The best instruction set supported by the CPU.
+Isa DetectIsa() noexcept;
+Isa ActiveIsa() noexcept;
+// Switches the implementation used by every thread, for tests and
+// benchmarks. Instruction sets the CPU does not support fall back to the best
+// supported one. Returns the instruction set actually selected.
+Isa SetIsa(Isa isa) noexcept;
+
+namespace detail {
+
+inline bool IsWhitespaceByte(unsigned char byte) noexcept {
+  return byte == ' ' || (byte >= '\t' && byte <= '\r');
+}
+
+inline bool IsDigitByte(unsigned char byte) noexcept {
+  return byte >= '0' && byte <= '9';
+}
+
+inline bool IsNameByte(unsigned char byte) noexcept {
+  const auto lower = static_cast<unsigned char>(byte | 0x20);
+  return IsDigitByte(byte) || (lower >= 'a' && lower <= 'z') || byte == '_';
+}
+
+// Most runs in real scripts are only a few bytes long, so the first bytes are
+// checked inline and only longer runs go through the selected implementation.
+inline constexpr size_t kInlineScanBytes = 8;
+
+template <bool (*kMatches)(unsigned char) noexcept>
+bool SkipInline(std::string_view text, size_t& pos) noexcept {
+  const size_t end =
+      text.size() - pos > kInlineScanBytes ? pos + kInlineScanBytes
+                                           : text.size();
+  for (; pos < end; ++pos) {
+    if (!kMatches(static_cast<unsigned char>(text[pos]))) {
+      return true;
+    }
+  }
+
+  return pos == text.size();
+}
+
+size_t SkipWhitespace(std::string_view text, size_t pos) noexcept;
+size_t SkipNameChars(std::string_view text, size_t pos) noexcept;
+size_t SkipDigits(std::string_view text, size_t pos) noexcept;
+size_t FindByte(std::string_view text, size_t pos, char byte) noexcept;
+
+}  // namespace detail
+
+// Skips ' ', '\t', '\n', '\v', '\f' and '\r'.
+inline size_t SkipWhitespace(std::string_view text, size_t pos) noexcept {
+  return detail::SkipInline<detail::IsWhitespaceByte>(text, pos)
+             ? pos
+             : detail::SkipWhitespace(text, pos);
+}
+
+// Skips letters, digits and '_'.
+inline size_t SkipNameChars(std::string_view text, size_t pos) noexcept {
+  return detail::SkipInline<detail::IsNameByte>(text, pos)
+             ? pos
+             : detail::SkipNameChars(text, pos);
+}
+
+inline size_t SkipDigits(std::string_view text, size_t pos) noexcept {
+  return detail::SkipInline<detail::IsDigitByte>(text, pos)
+             ? pos
+             : detail::SkipDigits(text, pos);
+}
+
+// Comment bodies and strings are usually long, so they are always scanned by
+// the selected implementation.
+inline size_t FindByte(std::string_view text, size_t pos, char byte) noexcept {
+  return detail::FindByte(text, pos, byte);
+}
+
+}  // namespace lualike::scanner
+
+#endif  // LUALIKE_SCANNER_H_
@@ -0,0 +1,41 @@
+#include "lualike/source.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace lualike::source {
+
+LineIndex::LineIndex(std::string_view text) : text_size_(text.size()) {
+  line_starts_.push_back(0);
+  for (size_t newline = text.find('\n'); newline != std::string_view::npos;
+       newline = text.find('\n', newline + 1)) {
+    line_starts_.push_back(newline + 1);
+  }
+}
+
+LineInfo LineIndex::Locate(size_t offset) const noexcept {
+  if (line_starts_.empty()) {
+    return {1, 0, 0};
+  }
+
+  offset = std::min(offset, text_size_);
+
+  // The last line start that is not after the offset.
+  const auto next_line =
+      std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+  const auto line = std::prev(next_line);
+
+  return {
+      .line_number = static_cast<size_t>(line - line_starts_.begin()) + 1,
+      .line_begin = *line,
+      .line_end = next_line != line_starts_.end() ? *next_line - 1 : text_size_,
+  };
+}
+
+const LineIndex& SourceBuffer::Lines() const {
+  std::call_once(line_index_built_,
+                 [this] { line_index_ = LineIndex(text_); });
+  return line_index_;
+}
+
+}  // namespace lualike::source
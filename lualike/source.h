@@ -0,0 +1,93 @@
+#ifndef LUALIKE_SOURCE_H_
+#define LUALIKE_SOURCE_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lualike::source {
+
+struct LineInfo {
+  // 1-based.
+  size_t line_number{};
+  size_t line_begin{};
+  // Offset of the terminating '\n', or the size of the text.
+  size_t line_end{};
+};
+
+// The offsets at which the lines of a text begin, for locating offsets in
+// O(log lines).
+class LineIndex {
+  std::vector<size_t> line_starts_;
+  size_t text_size_{};
+
+ public:
+  LineIndex() = default;
+  explicit LineIndex(std::string_view text);
+
+  // Offsets past the end of the text are clamped to it.
+  LineInfo Locate(size_t offset) const noexcept;
+  size_t LineCount() const noexcept { return line_starts_.size(); }
+};
+
+// An immutable source text, shared by reference between the parser, compiled
+// programs and every error produced from it.
+//
+// The text is either owned, kept alive by a shared owner such as a file
+// mapping, or borrowed from the caller, who then has to keep it alive for as
+// long as the buffer is referenced. The line index is built on the first
+// lookup, so sources whose errors are never rendered don't pay for it. Lookups
+// are safe from multiple threads.
+class SourceBuffer {
+  std::string owned_text_;
+  std::shared_ptr<const void> owner_;
+  std::string_view text_;
+  mutable std::once_flag line_index_built_;
+  mutable LineIndex line_index_;
+
+  struct BorrowTag {};
+
+ public:
+  explicit SourceBuffer(std::string text)
+      : owned_text_(std::move(text)), text_(owned_text_) {}
+  SourceBuffer(BorrowTag, std::string_view text,
+               std::shared_ptr<const void> owner = nullptr)
+      : owner_(std::move(owner)), text_(text) {}
+
+  SourceBuffer(const SourceBuffer&) = delete;
+  SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+  static std::shared_ptr<const SourceBuffer> Own(std::string text) {
+    return std::make_shared<const SourceBuffer>(std::move(text));
+  }
+
+  // Does not copy `text`, which must outlive the buffer.
+  static std::shared_ptr<const SourceBuffer> Borrow(std::string_view text) {
+    return std::make_shared<const SourceBuffer>(BorrowTag{}, text);
+  }
+
+  // Keeps `owner`, which has to keep `text` valid, alive with the buffer.
+  static std::shared_ptr<const SourceBuffer> Share(
+      std::string_view text, std::shared_ptr<const void> owner) {
+    return std::make_shared<const SourceBuffer>(BorrowTag{}, text,
+                                                std::move(owner));
+  }
+
+  std::string_view Text() const noexcept { return text_; }
+  // Whether the text is not owned by the buffer itself, including shared
+  // texts.
+  bool IsBorrowed() const noexcept {
+    return text_.data() != owned_text_.data();
+  }
+
+  const LineIndex& Lines() const;
+  LineInfo LocateLine(size_t offset) const { return Lines().Locate(offset); }
+};
+
+}  // namespace lualike::source
+
+#endif  // LUALIKE_SOURCE_H_
@@ -0,0 +1,197 @@
+#include "lualike/source_file.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LUALIKE_SOURCE_FILE_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace lualike::source {
+
+namespace {
+
+using ReadResult =
+    std::expected<std::shared_ptr<const SourceBuffer>, error::Error>;
+
+error::Error MakeReadError(const std::filesystem::path& path,
+                           std::error_code error_code) {
+  return error::Error::Message(error_code.message())
+      .Wrap(std::format("Failed to read '{}'", path.string()));
+}
+
+#ifdef LUALIKE_SOURCE_FILE_POSIX
+
+constexpr size_t kChunkSize = size_t{64} << 10U;
+
+std::error_code LastError() noexcept {
+  return {errno, std::system_category()};
+}
+
+class FileDescriptor {
+  int fd_;
+
+ public:
+  explicit FileDescriptor(int fd) noexcept : fd_(fd) {}
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+  ~FileDescriptor() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  int Get() const noexcept { return fd_; }
+};
+
+// Reads up to `size` bytes, fewer only at the end of the file.
+std::expected<size_t, std::error_code> ReadFully(int fd, char* data,
+                                                 size_t size) noexcept {
+  size_t total = 0;
+  while (total < size) {
+    const auto count = ::read(fd, data + total, size - total);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return std::unexpected(LastError());
+    }
+    if (count == 0) {
+      break;
+    }
+    total += static_cast<size_t>(count);
+  }
+
+  return total;
+}
+
+std::shared_ptr<const SourceBuffer> TryMap(int fd, size_t size) {
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+
+  // Only a hint, the lexer reads the text front to back.
+  ::madvise(mapping, size, MADV_SEQUENTIAL);
+  std::shared_ptr<const void> owner(mapping, [size](const void* address) {
+    ::munmap(const_cast<void*>(address), size);
+  });
+  return SourceBuffer::Share({static_cast<const char*>(mapping), size},
+                             std::move(owner));
+}
+
+ReadResult ReadRegularFile(const std::filesystem::path& path, int fd,
+                           size_t size, ReadFileOptions options) {
+  if (options.use_mmap) {
+    if (auto mapped = TryMap(fd, size)) {
+      return mapped;
+    }
+  }
+
+  std::string text(size, '\0');
+  const auto read = ReadFully(fd, text.data(), size);
+  if (!read) {
+    return std::unexpected(MakeReadError(path, read.error()));
+  }
+
+  // The file may have shrunk since it was inspected.
+  text.resize(read.value());
+  return SourceBuffer::Own(std::move(text));
+}
+
+ReadResult ReadUntilEnd(const std::filesystem::path& path, int fd) {
+  std::string text;
+  while (true) {
+    const size_t used = text.size();
+    text.resize(used + kChunkSize);
+    const auto read = ReadFully(fd, text.data() + used, kChunkSize);
+    if (!read) {
+      return std::unexpected(MakeReadError(path, read.error()));
+    }
+
+    text.resize(used + read.value());
+    if (read.value() < kChunkSize) {
+      return SourceBuffer::Own(std::move(text));
+    }
+  }
+}
+
+ReadResult ReadFileImpl(const std::filesystem::path& path,
+                        ReadFileOptions options) {
+  const FileDescriptor file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (file.Get() < 0) {
+    return std::unexpected(MakeReadError(path, LastError()));
+  }
+
+  struct stat status {};
+  if (::fstat(file.Get(), &status) != 0) {
+    return std::unexpected(MakeReadError(path, LastError()));
+  }
+
+  if (S_ISDIR(status.st_mode)) {
+    return std::unexpected(MakeReadError(
+        path, std::make_error_code(std::errc::is_a_directory)));
+  }
+
+  // Files of procfs and the like report a size of 0 however much they hold,
+  // so only a nonzero size is trusted.
+  if (S_ISREG(status.st_mode) && status.st_size > 0) {
+    return ReadRegularFile(path, file.Get(),
+                           static_cast<size_t>(status.st_size), options);
+  }
+
+  return ReadUntilEnd(path, file.Get());
+}
+
+#else
+
+ReadResult ReadFileImpl(const std::filesystem::path& path, ReadFileOptions) {
+  std::error_code error_code;
+  const auto size = std::filesystem::file_size(path, error_code);
+  if (error_code) {
+    return std::unexpected(MakeReadError(path, error_code));
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::unexpected(MakeReadError(
+        path, std::make_error_code(std::errc::no_such_file_or_directory)));
+  }
+
+  std::string text(static_cast<size_t>(size), '\0');
+  file.read(text.data(), static_cast<std::streamsize>(text.size()));
+  if (file.bad()) {
+    return std::unexpected(
+        MakeReadError(path, std::make_error_code(std::errc::io_error)));
+  }
+
+  text.resize(static_cast<size_t>(file.gcount()));
+  return SourceBuffer::Own(std::move(text));
+}
+
+#endif  // LUALIKE_SOURCE_FILE_POSIX
+
+}  // namespace
+
+std::expected<std::shared_ptr<const SourceBuffer>, error::Error> ReadFile(
+    const std::filesystem::path& path, ReadFileOptions options) noexcept {
+  try {
+    return ReadFileImpl(path, options);
+  } catch (const std::exception&) {
+    return std::unexpected(error::Error::FromCurrentException(
+        std::format("Failed to read '{}'", path.string())));
+  }
+}
+
+}  // namespace lualike::source
@@ -0,0 +1,29 @@
+#ifndef LUALIKE_SOURCE_FILE_H_
+#define LUALIKE_SOURCE_FILE_H_
+
+#include <expected>
+#include <filesystem>
+#include <memory>
+
+#include "lualike/error.h"
+#include "lualike/source.h"
+
+namespace lualike::source {
+
+struct ReadFileOptions {
+  // Maps regular files read-only instead of reading them, where supported.
+  // The file must not be truncated while the returned buffer is alive.
+  bool use_mmap = true;
+};
+
+// Loads a script into a SourceBuffer that the lexer can work on directly.
+//
+// Regular files are mapped into memory, or otherwise read with a single read
+// into a buffer of the file's size. Other files, such as pipes, are read in
+// chunks until their end.
+std::expected<std::shared_ptr<const SourceBuffer>, error::Error> ReadFile(
+    const std::filesystem::path& path, ReadFileOptions options = {}) noexcept;
+
+}  // namespace lualike::source
+
+#endif  // LUALIKE_SOURCE_FILE_H_
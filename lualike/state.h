@@ -0,0 +1,95 @@
+#ifndef LUALIKE_STATE_H_
+#define LUALIKE_STATE_H_
+
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "lualike/error.h"
+#include "lualike/interpreter.h"
+#include "lualike/runtime.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+// A long-lived interpreter whose globals persist across runs, for hosts that
+// evaluate many scripts against the same setup.
+//
+// A prelude is run once, after which Snapshot marks its globals as the state
+// to return to. Reset then discards whatever later runs changed in time
+// proportional to the number of globals they set, without running the prelude
+// again:
+//
+//   State state;
+//   state.Run(prelude);
+//   state.Snapshot();
+//   for (const auto& request : requests) {
+//     state.Globals().Set("request", request);
+//     state.Run(handler);
+//     state.Reset();
+//   }
+//
+// Fork makes a lightweight copy of a state, for example one per request
+// after running the prelude, that shares the unchanged globals with the state
+// copy-on-write. A fork only stores the globals it sets itself.
+//
+// Not thread-safe; use one state per thread. Forks may go to other threads,
+// and Fork may be called from several threads at once while the state is not
+// modified. See isolate.h for running one program on many threads.
+class State {
+  std::shared_ptr<Scope> globals_;
+  Engine engine_;
+
+  State(std::shared_ptr<Scope> globals, Engine engine)
+      : globals_(std::move(globals)), engine_(engine) {
+    globals_->TakeSnapshot();
+  }
+
+ public:
+  explicit State(Engine engine = Engine::kTreeWalker)
+      : State(std::make_shared<Scope>(), engine) {}
+
+  State(const State&) = delete;
+  State& operator=(const State&) = delete;
+  State(State&&) noexcept = default;
+  State& operator=(State&&) noexcept = default;
+
+  Scope& Globals() noexcept { return *globals_; }
+  Engine GetEngine() const noexcept { return engine_; }
+
+  // Compiles `source` with the engine of the state and runs it. Functions it
+  // declares keep the compiled program alive.
+  std::expected<std::optional<value::LualikeValue>, error::Error> Run(
+      std::string_view source) noexcept {
+    auto program = Compile(source, engine_);
+    if (!program) {
+      return std::unexpected(std::move(program).error());
+    }
+
+    return program->Run(globals_);
+  }
+
+  // Runs a program compiled by the caller.
+  std::expected<std::optional<value::LualikeValue>, error::Error> Run(
+      const CompiledProgram& program) noexcept {
+    return program.Run(globals_);
+  }
+
+  // A state with the current globals, which Reset of the fork returns to.
+  // Costs a copy of the globals the first time after they change, and O(1)
+  // after that.
+  State Fork() const { return {globals_->Fork(), engine_}; }
+
+  // Makes the current globals the ones Reset returns to.
+  void Snapshot() { globals_->TakeSnapshot(); }
+
+  // Restores the globals of the last snapshot, or of a fresh state if none
+  // was taken.
+  void Reset() { globals_->RestoreSnapshot(); }
+};
+
+}  // namespace lualike::interpreter
+
+#endif  // LUALIKE_STATE_H_
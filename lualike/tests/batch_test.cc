@@ -0,0 +1,89 @@
+#include "lualike/batch.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "lualike/interpreter.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+TEST(BatchTest, RunsProgramForEveryRow) {
+  const std::vector<int64_t> quantities = {1, 2, 3, 4};
+  const std::vector<double> prices = {1.5, 2.0, 0.5, 10.0};
+  const std::vector<value::InternedString> countries = {"DE", "FR", "DE",
+                                                        "US"};
+  const std::array<InputColumn, 3> columns = {
+      InputColumn{"quantity", quantities}, InputColumn{"price", prices},
+      InputColumn{"country", countries}};
+
+  for (const auto engine : {Engine::kTreeWalker, Engine::kBytecode,
+                            Engine::kFlatTreeWalker}) {
+    const auto program = Compile(
+        "if seen then return -1 end\n"
+        "seen = true\n"
+        "if country == 'DE' then return 0 end\n"
+        "return price * quantity",
+        engine);
+    ASSERT_TRUE(program.has_value());
+
+    Scope globals;
+    globals.Set("seen", value::LualikeValue{false});
+    const auto results = RunBatch(*program, columns, globals);
+    ASSERT_TRUE(results.has_value()) << results.error().RenderPlain();
+    EXPECT_THAT(*results,
+                testing::ElementsAre(value::LualikeValue{0},
+                                     value::LualikeValue{4.0},
+                                     value::LualikeValue{0},
+                                     value::LualikeValue{40.0}));
+    EXPECT_EQ(globals.Get("seen"), value::LualikeValue{false});
+    EXPECT_FALSE(globals.Get("price").has_value());
+  }
+}
+
+TEST(BatchTest, ReturnsNulloptForRowsWithoutResult) {
+  const std::vector<int64_t> values = {1, 5};
+  const std::array<InputColumn, 1> columns = {InputColumn{"x", values}};
+  const auto program = Compile("if x > 2 then return x end");
+  ASSERT_TRUE(program.has_value());
+
+  const auto results = RunBatch(*program, columns);
+  ASSERT_TRUE(results.has_value()) << results.error().RenderPlain();
+  EXPECT_THAT(*results, testing::ElementsAre(std::nullopt,
+                                             value::LualikeValue{5}));
+}
+
+TEST(BatchTest, ReportsFailingRow) {
+  const std::vector<int64_t> numbers = {1, 2};
+  const std::vector<value::InternedString> names = {"a", "b"};
+  const std::array<InputColumn, 2> columns = {InputColumn{"x", numbers},
+                                              InputColumn{"name", names}};
+  const auto program = Compile("if x > 1 then return x + name end");
+  ASSERT_TRUE(program.has_value());
+
+  const auto results = RunBatch(*program, columns);
+  ASSERT_FALSE(results.has_value());
+  EXPECT_EQ(results.error().Messages().front(), "Failed to evaluate row 1");
+  EXPECT_TRUE(results.error().HasSourceText());
+}
+
+TEST(BatchTest, RejectsColumnsOfDifferentLengths) {
+  const std::vector<int64_t> numbers = {1, 2};
+  const std::vector<double> ratios = {0.5};
+  const std::array<InputColumn, 2> columns = {InputColumn{"x", numbers},
+                                              InputColumn{"ratio", ratios}};
+  const auto program = Compile("return x * ratio");
+  ASSERT_TRUE(program.has_value());
+
+  const auto results = RunBatch(*program, columns);
+  ASSERT_FALSE(results.has_value());
+  EXPECT_EQ(results.error().Messages().front(),
+            "Input column 'ratio' has 1 rows instead of 2");
+}
+
+}  // namespace lualike::interpreter
@@ -0,0 +1,88 @@
+#include "lualike/bytecode.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "lualike/parser.h"
+#include "lualike/resolver.h"
+
+namespace lualike::bytecode {
+
+namespace {
+
+std::string CompileToDump(std::string_view input) {
+  auto program = parser::Parse(input);
+  if (!program) {
+    return program.error().RenderPlain();
+  }
+
+  resolver::Resolve(program.value());
+  return ToString(Compile(program.value()));
+}
+
+}  // namespace
+
+TEST(BytecodeTest, CompilesArithmeticInEvaluationOrder) {
+  EXPECT_EQ(CompileToDump("return 1 + 2 * 3"),
+            "0000 Constant Number <1>\n"
+            "0001 Constant Number <2>\n"
+            "0002 Constant Number <3>\n"
+            "0003 Multiply\n"
+            "0004 Add\n"
+            "0005 Return\n"
+            "0006 Halt\n");
+}
+
+TEST(BytecodeTest, CompilesTopLevelDeclarationsAsGlobals) {
+  EXPECT_EQ(CompileToDump("local a\nb = a"),
+            "0000 Constant Nil\n"
+            "0001 SetGlobal a\n"
+            "0002 GetGlobal a\n"
+            "0003 SetGlobal b\n"
+            "0004 Halt\n");
+}
+
+TEST(BytecodeTest, CompilesNestedDeclarationsToFrameSlots) {
+  EXPECT_EQ(CompileToDump("if c then\n"
+                          "  local a = 1\n"
+                          "  if a then local b = a return b end\n"
+                          "end"),
+            "0000 GetGlobal c\n"
+            "0001 JumpIfFalse -> 0010\n"
+            "0002 Constant Number <1>\n"
+            "0003 SetLocal 0\n"
+            "0004 GetLocal 0\n"
+            "0005 JumpIfFalse -> 0010\n"
+            "0006 GetLocal 0\n"
+            "0007 SetLocal 1\n"
+            "0008 GetLocal 1\n"
+            "0009 Return\n"
+            "0010 Halt\n");
+}
+
+TEST(BytecodeTest, CompilesShortCircuitOperatorsToJumps) {
+  EXPECT_EQ(CompileToDump("return a and b or c"),
+            "0000 GetGlobal a\n"
+            "0001 JumpIfFalseOrPop -> 0003\n"
+            "0002 GetGlobal b\n"
+            "0003 JumpIfTrueOrPop -> 0005\n"
+            "0004 GetGlobal c\n"
+            "0005 Return\n"
+            "0006 Halt\n");
+}
+
+TEST(BytecodeTest, CompilesIfStatementBranches) {
+  EXPECT_EQ(CompileToDump("if c then return 1 else return 2 end"),
+            "0000 GetGlobal c\n"
+            "0001 JumpIfFalse -> 0005\n"
+            "0002 Constant Number <1>\n"
+            "0003 Return\n"
+            "0004 Jump -> 0007\n"
+            "0005 Constant Number <2>\n"
+            "0006 Return\n"
+            "0007 Halt\n");
+}
+
+}  // namespace lualike::bytecode
@@ -0,0 +1,154 @@
+#include "lualike/compact_value.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lualike/value.h"
+
+namespace lualike::value {
+
+namespace {
+
+using CV = CompactValue;
+using LLV = LualikeValue;
+
+const std::array<LLV, 8> kSamples = {
+    LLV{}, LLV{true}, LLV{false}, LLV{2}, LLV{-3}, LLV{2.5}, LLV{"a"},
+    LLV{"b"},
+};
+
+// Evaluates the operation on both representations and compares either the
+// printed results, so that NaNs compare equal, or the kinds of the thrown
+// errors.
+template <typename OperatorT>
+void ExpectSameAsVariant(const LLV& lhs, const LLV& rhs,
+                         const OperatorT& operator_lambda) {
+  std::optional<LLV> expected;
+  std::optional<LualikeValueOpErrKind> expected_error;
+  try {
+    expected = operator_lambda(lhs, rhs);
+  } catch (const LualikeValueOpErr& err) {
+    expected_error = err.error_kind;
+  }
+
+  try {
+    const auto actual =
+        operator_lambda(CV::FromValue(lhs), CV::FromValue(rhs)).ToValue();
+    EXPECT_EQ(testing::PrintToString(std::optional{actual}),
+              testing::PrintToString(expected))
+        << lhs.ToString() << ", " << rhs.ToString();
+  } catch (const LualikeValueOpErr& err) {
+    EXPECT_EQ(std::optional{err.error_kind}, expected_error)
+        << lhs.ToString() << ", " << rhs.ToString();
+  }
+}
+
+}  // namespace
+
+TEST(CompactValueTest, RoundTripsEveryKind) {
+  for (const auto& sample : kSamples) {
+    EXPECT_EQ(CV::FromValue(sample).ToValue(), sample);
+  }
+
+  struct Function : LualikeFunction {
+    std::optional<LLV> Call(std::span<const LLV>) override { return {}; }
+  };
+  const LLV function{std::make_shared<Function>()};
+  EXPECT_EQ(CV::FromValue(function).ToValue(), function);
+}
+
+TEST(CompactValueTest, SharesHeapCellsBetweenCopies) {
+  const CV original{std::string(64, 'x')};
+  CV copy = original;
+  EXPECT_EQ(&copy.AsString(), &original.AsString());
+
+  CV moved = std::move(copy);
+  EXPECT_EQ(moved.AsString(), std::string(64, 'x'));
+  EXPECT_EQ(copy.GetKind(), CV::Kind::kNil);  // NOLINT(bugprone-use-after-move)
+
+  moved = CV{LLV::IntT{1}};
+  EXPECT_EQ(original.AsString(), std::string(64, 'x'));
+}
+
+TEST(CompactValueTest, ArithmeticMatchesVariant) {
+  const std::array<std::function<CV(const CV&, const CV&)>, 7> compact_ops = {
+      std::plus<>{},       std::minus<>{},
+      std::multiplies<>{}, std::divides<>{},
+      std::modulus<>{},    [](const CV& l, const CV& r) {
+        return Exponentiate(l, r);
+      },
+      [](const CV& l, const CV& r) { return FloorDivide(l, r); },
+  };
+  const std::array<std::function<LLV(const LLV&, const LLV&)>, 7>
+      variant_ops = {
+          std::plus<>{},       std::minus<>{},
+          std::multiplies<>{}, std::divides<>{},
+          std::modulus<>{},    [](const LLV& l, const LLV& r) {
+            return Exponentiate(l, r);
+          },
+          [](const LLV& l, const LLV& r) { return FloorDivide(l, r); },
+      };
+
+  for (size_t op = 0; op < compact_ops.size(); ++op) {
+    for (const auto& lhs : kSamples) {
+      for (const auto& rhs : kSamples) {
+        ExpectSameAsVariant(lhs, rhs, [&](const auto& l, const auto& r) {
+          if constexpr (std::is_same_v<std::decay_t<decltype(l)>, CV>) {
+            return compact_ops[op](l, r);
+          } else {
+            return variant_ops[op](l, r);
+          }
+        });
+      }
+    }
+  }
+}
+
+TEST(CompactValueTest, LogicalAndUnaryOpsMatchVariant) {
+  for (const auto& lhs : kSamples) {
+    for (const auto& rhs : kSamples) {
+      ExpectSameAsVariant(lhs, rhs,
+                          [](const auto& l, const auto& r) { return l || r; });
+      ExpectSameAsVariant(lhs, rhs,
+                          [](const auto& l, const auto& r) { return l && r; });
+    }
+
+    ExpectSameAsVariant(lhs, lhs,
+                        [](const auto& l, const auto&) { return -l; });
+    ExpectSameAsVariant(lhs, lhs,
+                        [](const auto& l, const auto&) { return !l; });
+  }
+}
+
+TEST(CompactValueTest, ComparisonsMatchVariant) {
+  for (const auto& lhs : kSamples) {
+    for (const auto& rhs : kSamples) {
+      const auto compact_lhs = CV::FromValue(lhs);
+      const auto compact_rhs = CV::FromValue(rhs);
+
+      EXPECT_EQ(compact_lhs == compact_rhs, lhs == rhs);
+      EXPECT_EQ(compact_lhs < compact_rhs, lhs < rhs);
+      EXPECT_EQ(compact_lhs >= compact_rhs, lhs >= rhs);
+    }
+  }
+}
+
+TEST(CompactValueTest, PrintsLikeVariant) {
+  for (const auto& sample : kSamples) {
+    EXPECT_EQ(testing::PrintToString(CV::FromValue(sample)),
+              testing::PrintToString(sample));
+  }
+}
+
+}  // namespace lualike::value
@@ -2,7 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <stdexcept>
+#include <string>
+
+#include "lualike/source.h"
 
 namespace lualike::error {
 
@@ -20,7 +24,7 @@ TEST(ErrorTest, ChainsMessagesAndKeepsPrettySourceRendering) {
   EXPECT_NE(pretty.find("invalid number"), std::string::npos);
 }
 
-TEST(ErrorTest, DeepCopiesErrorChains) {
+TEST(ErrorTest, CopiesShareErrorChains) {
   const auto original = Error::Context("failed to evaluate addition",
                                        token::SourceSpan{7, 15})
                             .Wrap("while interpreting return")
@@ -30,6 +34,32 @@ TEST(ErrorTest, DeepCopiesErrorChains) {
 
   EXPECT_STREQ(copy.what(), original.what());
   EXPECT_EQ(copy.RenderPretty(), original.RenderPretty());
+  EXPECT_EQ(copy.Root(), original.Root());
+  EXPECT_EQ(copy.GetSource(), original.GetSource());
+
+  // Wrapping a copy leaves the original untouched.
+  auto wrapped = Error(copy).Wrap("while running script");
+  EXPECT_EQ(wrapped.Messages().size(), 3);
+  EXPECT_EQ(original.Messages().size(), 2);
+  EXPECT_EQ(wrapped.Root()->Source(), original.Root());
+}
+
+TEST(ErrorTest, SharesAttachedSources) {
+  const auto source =
+      std::make_shared<const source::SourceBuffer>("x = 1\nreturn x + y");
+  const auto first =
+      Error::Context("unknown variable", token::SourceSpan{17, 18})
+          .AttachSource(source);
+  const auto second =
+      Error::Context("invalid addition", token::SourceSpan{13, 18})
+          .AttachSource(source)
+          .AttachSourceText("ignored");
+
+  EXPECT_EQ(first.GetSource(), source);
+  EXPECT_EQ(second.GetSource(), source);
+  EXPECT_EQ(Error(first).GetSource(), source);
+  EXPECT_NE(first.RenderPretty().find("2 | return x + y"), std::string::npos);
+  EXPECT_NE(second.RenderPretty().find("^^^^^"), std::string::npos);
 }
 
 TEST(ErrorTest, PreservesForeignExceptions) {
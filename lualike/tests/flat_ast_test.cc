@@ -0,0 +1,102 @@
+#include "lualike/flat_ast.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lualike/ast.h"
+#include "lualike/parser.h"
+#include "lualike/resolver.h"
+#include "lualike/value.h"
+
+namespace lualike::ast {
+
+namespace {
+
+using Kind = FlatProgram::StatementKind;
+
+}  // namespace
+
+MATCHER(LualikeFlattensToSameDump, "") {
+  auto program = parser::Parse(std::string_view{arg});
+  if (!program) {
+    *result_listener << program.error().RenderPlain();
+    return false;
+  }
+
+  return ExplainMatchResult(testing::Eq(ToString(program.value())),
+                            ToString(Flatten(program.value())),
+                            result_listener);
+}
+
+TEST(FlatAstTest, PrintsLikeTheTree) {
+  EXPECT_THAT("local a = 1", LualikeFlattensToSameDump());
+  EXPECT_THAT("return", LualikeFlattensToSameDump());
+  EXPECT_THAT("return -(1 + 2) * not x // 'str'", LualikeFlattensToSameDump());
+  EXPECT_THAT(
+      "if a then\n"
+      "  local b = 1\n"
+      "  if b then return b else x = 2 end\n"
+      "else\n"
+      "  return a and nil\n"
+      "end\n"
+      "return 3.5",
+      LualikeFlattensToSameDump());
+}
+
+TEST(FlatAstTest, PrintsNodesTheParserDoesNotProduce) {
+  std::vector<Expression> args;
+  args.push_back(Expression{LiteralExpression{value::LualikeValue{1}}});
+  args.push_back(Expression{VariableExpression{"msg"}});
+
+  auto body = std::make_unique<Block>();
+  body->statements.push_back(Statement{ExpressionStatement{Expression{
+      FunctionCallExpression{
+          std::make_unique<Expression>(VariableExpression{"print"}),
+          std::move(args)}}}});
+  body->statements.push_back(
+      Statement{Assignment{VariableExpression{"x"},
+                           Expression{VariableExpression{"msg"}}}});
+
+  Program program;
+  program.statements.push_back(Statement{
+      FunctionDeclaration{"log", {"msg", "level"}, std::move(body)}});
+
+  EXPECT_EQ(ToString(Flatten(program)), ToString(program));
+}
+
+TEST(FlatAstTest, StoresBlockStatementsContiguously) {
+  auto program = parser::Parse(
+      "local a = 1\n"
+      "if a then local b = 2 local c = 3 end\n"
+      "return a");
+  ASSERT_TRUE(program.has_value());
+  resolver::Resolve(program.value());
+
+  const auto flat = Flatten(program.value());
+  ASSERT_EQ(flat.blocks.statements.size(), 2);
+
+  const auto root = flat.blocks.statements[0];
+  EXPECT_EQ(root.begin, 0);
+  EXPECT_EQ(root.count, 3);
+  EXPECT_EQ(flat.statements.kinds[0], Kind::kVariableDeclaration);
+  EXPECT_EQ(flat.statements.kinds[1], Kind::kIf);
+  EXPECT_EQ(flat.statements.kinds[2], Kind::kReturn);
+
+  const auto then_block = flat.statements.b[1];
+  EXPECT_EQ(flat.blocks.statements[then_block].begin, 3);
+  EXPECT_EQ(flat.blocks.statements[then_block].count, 2);
+  EXPECT_EQ(flat.blocks.slot_counts[then_block], 2);
+  EXPECT_EQ(flat.statements.c[1], FlatProgram::kNone);
+
+  const auto second_local = flat.statements.c[4];
+  ASSERT_NE(second_local, FlatProgram::kNone);
+  EXPECT_EQ(flat.slots[second_local], (LocalSlot{0, 1}));
+}
+
+}  // namespace lualike::ast
@@ -0,0 +1,84 @@
+#include "lualike/interned_string.h"
+
+#include <gtest/gtest.h>
+
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lualike::value {
+
+TEST(InternedStringTest, SharesStorageBetweenEqualContents) {
+  const InternedString first{"name"};
+  const InternedString second{std::string("na") + "me"};
+  const InternedString other{"other"};
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first.View().data(), second.View().data());
+  EXPECT_NE(first, other);
+  EXPECT_EQ(first.size(), 4);
+}
+
+TEST(InternedStringTest, DefaultsToEmpty) {
+  const InternedString empty;
+
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty, InternedString{""});
+  EXPECT_EQ(empty.View(), "");
+  EXPECT_EQ(empty.Hash(), std::hash<std::string_view>{}(""));
+}
+
+TEST(InternedStringTest, OrdersAndHashesByContents) {
+  EXPECT_LT(InternedString{"abc"}, InternedString{"abd"});
+  EXPECT_LT(InternedString{""}, InternedString{"a"});
+  EXPECT_GT(InternedString{"b"}, InternedString{"abc"});
+
+  EXPECT_EQ(InternedString{"key"}.Hash(),
+            std::hash<std::string_view>{}("key"));
+
+  std::unordered_map<InternedString, int> map;
+  map["key"] = 1;
+  EXPECT_EQ(map.at(InternedString{std::string("key")}), 1);
+}
+
+TEST(InternedStringTest, FormatsAsItsContents) {
+  EXPECT_EQ(std::format("<{}>", InternedString{"text"}), "<text>");
+}
+
+TEST(InternedStringTest, ReinternsReleasedStrings) {
+  const std::string text = "only referenced in this test";
+  {
+    const InternedString temporary{text};
+    EXPECT_EQ(temporary.View(), text);
+  }
+
+  const InternedString again{text};
+  EXPECT_EQ(again.View(), text);
+}
+
+TEST(InternedStringTest, SupportsConcurrentInterning) {
+  constexpr int kThreads = 8;
+  constexpr int kIterations = 2000;
+
+  std::vector<std::thread> threads;
+  threads.reserve(kThreads);
+  for (int thread = 0; thread < kThreads; ++thread) {
+    threads.emplace_back([] {
+      for (int i = 0; i < kIterations; ++i) {
+        const InternedString shared{std::to_string(i % 16)};
+        const InternedString copy = shared;
+        EXPECT_EQ(copy.View(), std::to_string(i % 16));
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace lualike::value
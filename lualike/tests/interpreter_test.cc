@@ -3,9 +3,21 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <variant>
 
+#include "lualike/source.h"
 #include "lualike/value.h"
 
 namespace lualike::interpreter {
@@ -16,6 +28,13 @@ std::string RenderErrorForTest(const error::Error& err) {
   return err.HasSourceText() ? err.RenderPretty() : err.RenderPlain();
 }
 
+// Calls a function value the way a host does, outside any run.
+std::optional<value::LualikeValue> CallFromHost(
+    const value::LualikeValue& function,
+    std::span<const value::LualikeValue> args) {
+  return std::get<value::LualikeValue::FuncT>(function.inner_value)->Call(args);
+}
+
 }  // namespace
 
 MATCHER_P(LualikeEvaluatesTo, expected_value, "") {
@@ -62,7 +81,7 @@ TEST(InterpreterTest, InterpretValidStatementsTest) {
   EXPECT_THAT("local pi = 3.14", LualikeRunsSuccessfully());
   EXPECT_THAT("pi = 3.14", LualikeRunsSuccessfully());
   EXPECT_THAT(";;;", LualikeRunsSuccessfully());
-  EXPECT_THAT("return;", LualikeRunsSuccessfully());
+  EXPECT_THAT("return;", LualikeEvaluatesTo(value::LualikeValue{}));
   EXPECT_THAT("return 1 + 2 + 3", LualikeEvaluatesTo(6));
 }
 
@@ -96,6 +115,31 @@ TEST(InterpreterTest, ReadsFromInputStream) {
   EXPECT_EQ(eval_result->value(), lualike::value::LualikeValue{7});
 }
 
+TEST(InterpreterTest, InterpretsStreamsInChunks) {
+  std::istringstream input("local x = 20\nlocal y = x + 22\nreturn y");
+  const auto eval_result = interpreter::InterpretStream(input, 3);
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  ASSERT_TRUE(eval_result->has_value());
+  EXPECT_EQ(eval_result->value(), lualike::value::LualikeValue{42});
+}
+
+TEST(InterpreterTest, ReadsFromFile) {
+  const auto path =
+      std::filesystem::temp_directory_path() / "lualike_reads_from_file.lua";
+  std::ofstream(path) << "local x = 2\nreturn x * 5\n";
+  const auto eval_result = interpreter::InterpretFile(path);
+  std::filesystem::remove(path);
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  ASSERT_TRUE(eval_result->has_value());
+  EXPECT_EQ(eval_result->value(), lualike::value::LualikeValue{10});
+
+  const auto missing = interpreter::InterpretFile(path);
+  ASSERT_FALSE(missing.has_value());
+  EXPECT_THAT(missing.error().what(), testing::HasSubstr("Failed to read"));
+}
+
 TEST(InterpreterTest, RejectsTrailingTokensAfterReturn) {
   const auto eval_result = interpreter::Interpret("return 2 whatever");
   ASSERT_FALSE(eval_result.has_value());
@@ -113,4 +157,318 @@ TEST(InterpreterTest, PrettyErrorHighlightsUnknownVariable) {
   EXPECT_THAT(pretty, testing::HasSubstr("^^^^^^^^"));
 }
 
+TEST(InterpreterTest, CompiledProgramRunsRepeatedly) {
+  const auto program = interpreter::Compile("local x = 2\nreturn x * 21");
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  for (int run = 0; run < 3; ++run) {
+    const auto eval_result = program->Run();
+    ASSERT_TRUE(eval_result.has_value())
+        << RenderErrorForTest(eval_result.error());
+    ASSERT_TRUE(eval_result->has_value());
+    EXPECT_EQ(eval_result->value(), lualike::value::LualikeValue{42});
+  }
+}
+
+TEST(InterpreterTest, CompiledProgramReusesProvidedGlobals) {
+  const auto program = interpreter::Compile("return base + 1");
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  const auto globals = std::make_shared<Scope>();
+  globals->Set("base", lualike::value::LualikeValue{1});
+
+  const auto first = program->Run(globals);
+  ASSERT_TRUE(first.has_value()) << RenderErrorForTest(first.error());
+  EXPECT_EQ(first->value(), lualike::value::LualikeValue{2});
+
+  globals->Set("base", lualike::value::LualikeValue{10});
+  const auto second = program->Run(globals);
+  ASSERT_TRUE(second.has_value()) << RenderErrorForTest(second.error());
+  EXPECT_EQ(second->value(), lualike::value::LualikeValue{11});
+}
+
+TEST(InterpreterTest, ReturnedFunctionsOutliveTheInterpretCall) {
+  const auto eval_result =
+      interpreter::Interpret("function f(a) return a + 1 end\nreturn f");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  ASSERT_TRUE(eval_result->has_value());
+
+  const std::array args{value::LualikeValue{41}};
+  EXPECT_EQ(CallFromHost(eval_result->value(), args),
+            value::LualikeValue{42});
+}
+
+TEST(InterpreterTest, CompiledProgramRendersRuntimeErrorsWithSource) {
+  const auto program = interpreter::Compile("return 2 + whatever");
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  const auto eval_result = program->Run();
+  ASSERT_FALSE(eval_result.has_value());
+  EXPECT_THAT(eval_result.error().RenderPretty(),
+              testing::HasSubstr("return 2 + whatever"));
+}
+
+TEST(InterpreterTest, ReportsOperandTypeErrorsWithCause) {
+  const auto eval_result = interpreter::Interpret("local s = 'a'\nreturn -s");
+  ASSERT_FALSE(eval_result.has_value());
+
+  EXPECT_THAT(eval_result.error().Messages(),
+              testing::ElementsAre("Failed to evaluate unary negation",
+                                   "operand is not numeric"));
+  EXPECT_THAT(eval_result.error().RenderPretty(), testing::HasSubstr("^^"));
+}
+
+TEST(InterpreterTest, CompiledProgramSharesSourceAcrossRuntimeErrors) {
+  const auto program = interpreter::Compile("x = 1\nreturn x + missing");
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  const auto first = program->Run();
+  const auto second = program->Run();
+  ASSERT_FALSE(first.has_value());
+  ASSERT_FALSE(second.has_value());
+  EXPECT_EQ(first.error().GetSource(), second.error().GetSource());
+  EXPECT_EQ(first.error().SourceText(), program->SourceText());
+  EXPECT_THAT(second.error().RenderPretty(),
+              testing::HasSubstr("2 | return x + missing"));
+}
+
+TEST(InterpreterTest, ErrorsShareCallerProvidedSource) {
+  const std::string script = "x = 1\nreturn x + missing";
+  const auto source = source::SourceBuffer::Borrow(script);
+
+  const auto eval_result = interpreter::Interpret(source);
+  ASSERT_FALSE(eval_result.has_value());
+  EXPECT_EQ(eval_result.error().GetSource(), source);
+  EXPECT_EQ(eval_result.error().SourceText().data(), script.data());
+  EXPECT_THAT(eval_result.error().RenderPretty(),
+              testing::HasSubstr("2 | return x + missing"));
+
+  const auto compile_result =
+      interpreter::Compile(source::SourceBuffer::Borrow("return 2 whatever"));
+  ASSERT_FALSE(compile_result.has_value());
+  EXPECT_TRUE(compile_result.error().GetSource()->IsBorrowed());
+
+  const auto program = interpreter::Compile(source);
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+  EXPECT_EQ(program->GetSource(), source);
+}
+
+TEST(InterpreterTest, CompileReportsParseErrors) {
+  const auto program = interpreter::Compile("return 2 whatever");
+  ASSERT_FALSE(program.has_value());
+  EXPECT_TRUE(program.error().HasSourceText());
+  EXPECT_THAT(program.error().what(),
+              testing::HasSubstr("Unexpected token after return statement"));
+}
+
+TEST(InterpreterTest, CallsScriptFunctions) {
+  EXPECT_THAT(
+      "function fib(n)\n"
+      "  if n < 2 then return n end\n"
+      "  return fib(n - 1) + fib(n - 2)\n"
+      "end\n"
+      "return fib(10)",
+      LualikeEvaluatesTo(55));
+  EXPECT_THAT(
+      "function second(a, b) return b end\n"
+      "return second(1)",
+      LualikeEvaluatesTo(value::LualikeValue{}));
+  EXPECT_THAT(
+      "function first(a) return a end\n"
+      "return first(1, 2, 3)",
+      LualikeEvaluatesTo(1));
+  EXPECT_THAT(
+      "function nothing() local x = 1 end\n"
+      "return nothing()",
+      LualikeEvaluatesTo(value::LualikeValue{}));
+
+  const auto eval_result = interpreter::Interpret(
+      "if true then\n"
+      "  local hidden = 1\n"
+      "  function peek() return hidden end\n"
+      "  return peek()\n"
+      "end");
+  ASSERT_FALSE(eval_result.has_value());
+  EXPECT_THAT(eval_result.error().what(),
+              testing::HasSubstr("Unknown variable: 'hidden'"));
+}
+
+TEST(InterpreterTest, CallsHostFunctions) {
+  const auto program = interpreter::Compile("return add(base, 2) * 2");
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  const auto globals = std::make_shared<Scope>();
+  globals->Set("base", value::LualikeValue{19});
+  globals->Set("add", value::MakeHostFunction(
+                          [](std::span<const value::LualikeValue> args) {
+                            return args[0] + args[1];
+                          }));
+
+  const auto eval_result = program->Run(globals);
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{42});
+}
+
+TEST(InterpreterTest, ReportsCallErrors) {
+  EXPECT_THAT(
+      interpreter::Interpret("x = 1\nreturn x(2)").error().what(),
+      testing::HasSubstr("Attempt to call a non-function value: Number <1>"));
+  EXPECT_THAT(
+      interpreter::Interpret("function f() return f() end\nreturn f()")
+          .error()
+          .what(),
+      testing::HasSubstr("Stack overflow"));
+
+  const auto program = interpreter::Compile("return fail()");
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+  const auto globals = std::make_shared<Scope>();
+  globals->Set("fail", value::MakeHostFunction(
+                           [](std::span<const value::LualikeValue>)
+                               -> std::optional<value::LualikeValue> {
+                             throw std::runtime_error("host failure");
+                           }));
+  const auto eval_result = program->Run(globals);
+  ASSERT_FALSE(eval_result.has_value());
+  EXPECT_THAT(eval_result.error().what(),
+              testing::HasSubstr("Failed to call function"));
+  EXPECT_THAT(eval_result.error().RenderPlain(),
+              testing::HasSubstr("host failure"));
+}
+
+class InterpreterEngineTest : public testing::TestWithParam<Engine> {
+ protected:
+  std::expected<std::optional<value::LualikeValue>, error::Error> Run(
+      std::string_view source, std::shared_ptr<Scope> globals) const {
+    auto program = Compile(source, GetParam());
+    if (!program) {
+      return std::unexpected(std::move(program).error());
+    }
+
+    return program->Run(std::move(globals));
+  }
+
+  std::expected<std::optional<value::LualikeValue>, error::Error> Run(
+      std::string_view source) const {
+    return Run(source, std::make_shared<Scope>());
+  }
+};
+
+TEST_P(InterpreterEngineTest, AssignsGlobalsFromNestedBlocks) {
+  const auto globals = std::make_shared<Scope>();
+  globals->Set("count", value::LualikeValue{0});
+  ASSERT_TRUE(Run("if true then count = count + 1 end", globals));
+  EXPECT_EQ(globals->Get("count"), value::LualikeValue{1});
+
+  const auto eval_result = Run("if true then n = 1 end\nreturn n");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{1});
+}
+
+TEST_P(InterpreterEngineTest, AssignsGlobalsFromFunctionBodies) {
+  const auto eval_result = Run(
+      "function inc() n = n + 1 end\n"
+      "n = 0\n"
+      "inc()\n"
+      "inc()\n"
+      "return n");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{2});
+
+  const auto globals = std::make_shared<Scope>();
+  globals->Set("total", value::LualikeValue{40});
+  ASSERT_TRUE(Run("function add(x) if x then total = total + x end end\n"
+                  "add(2)",
+                  globals));
+  EXPECT_EQ(globals->Get("total"), value::LualikeValue{42});
+}
+
+TEST_P(InterpreterEngineTest, AssignsEnclosingLocals) {
+  const auto eval_result = Run(
+      "if true then\n"
+      "  local a = 1\n"
+      "  if true then a = a + 1 end\n"
+      "  return a\n"
+      "end");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{2});
+}
+
+TEST_P(InterpreterEngineTest, LocalDeclarationsShadowOuterNames) {
+  const auto eval_result = Run(
+      "x = 1\n"
+      "function f() local x = 3 end\n"
+      "f()\n"
+      "if true then\n"
+      "  local x = 2\n"
+      "  if true then local x = 5 end\n"
+      "  x = x * 10\n"
+      "end\n"
+      "return x");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{1});
+}
+
+TEST_P(InterpreterEngineTest, ReturnsEarlyFromBareReturn) {
+  const auto eval_result = Run(
+      "function f(x)\n"
+      "  if x then return end\n"
+      "  calls = calls + 1\n"
+      "end\n"
+      "calls = 0\n"
+      "f(true)\n"
+      "f(false)\n"
+      "if f(true) == nil then return calls end");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{1});
+}
+
+TEST_P(InterpreterEngineTest, ReturnedFunctionsOutliveTheirProgram) {
+  // Run compiles a program of its own and destroys it before returning.
+  const auto globals = std::make_shared<Scope>();
+  const auto eval_result = Run(
+      "g = 1\n"
+      "function outer()\n"
+      "  function inner(a) return a * 2 + g end\n"
+      "  return inner\n"
+      "end\n"
+      "return outer",
+      globals);
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  ASSERT_TRUE(eval_result->has_value());
+
+  const auto inner = CallFromHost(eval_result->value(), {});
+  ASSERT_TRUE(inner.has_value());
+  const std::array args{value::LualikeValue{20}};
+  EXPECT_EQ(CallFromHost(*inner, args), value::LualikeValue{41});
+}
+
+TEST_P(InterpreterEngineTest, FunctionsOutlivingTheirGlobalsSeeNoGlobals) {
+  const auto program =
+      Compile("g = 1\nfunction f(a) return a + g end\nreturn f", GetParam());
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+  // Runs against globals that are destroyed before it returns.
+  const auto eval_result = program->Run();
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  ASSERT_TRUE(eval_result->has_value());
+
+  const std::array args{value::LualikeValue{1}};
+  EXPECT_THAT([&] { CallFromHost(eval_result->value(), args); },
+              testing::ThrowsMessage<error::Error>(
+                  testing::HasSubstr("Unknown variable: 'g'")));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllEngines, InterpreterEngineTest,
+                         testing::Values(Engine::kTreeWalker,
+                                         Engine::kBytecode,
+                                         Engine::kFlatTreeWalker));
+
 }  // namespace lualike::interpreter
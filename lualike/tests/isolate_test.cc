@@ -0,0 +1,124 @@
+#include "lualike/isolate.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "lualike/interpreter.h"
+#include "lualike/state.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+TEST(IsolateTest, RunsOneProgramOnManyThreads) {
+  constexpr int kThreads = 8;
+  constexpr int kRuns = 200;
+
+  for (const auto engine : {Engine::kTreeWalker, Engine::kBytecode,
+                            Engine::kFlatTreeWalker}) {
+    State prelude(engine);
+    ASSERT_TRUE(prelude.Run("runs = 0\nname = 'worker'\n"
+                            "function fib(n)\n"
+                            "  if n < 2 then return n end\n"
+                            "  return fib(n - 1) + fib(n - 2)\n"
+                            "end"));
+    auto program = Compile(
+        "runs = runs + 1\n"
+        "local label = name\n"
+        "function twice(x) return x * 2 end\n"
+        "return twice(fib(n)) + runs",
+        engine);
+    ASSERT_TRUE(program.has_value());
+    const auto shared_program =
+        std::make_shared<const CompiledProgram>(std::move(program).value());
+
+    std::vector<std::thread> threads;
+    threads.reserve(kThreads);
+    for (int thread = 0; thread < kThreads; ++thread) {
+      threads.emplace_back([&, thread] {
+        Isolate isolate(shared_program, prelude);
+        isolate.Globals().Set("n", value::LualikeValue{int64_t{thread}});
+        for (int run = 1; run <= kRuns; ++run) {
+          const auto eval_result = isolate.Run();
+          ASSERT_TRUE(eval_result.has_value());
+          // fib(0..7) = 0, 1, 1, 2, 3, 5, 8, 13.
+          constexpr int64_t kFib[] = {0, 1, 1, 2, 3, 5, 8, 13};
+          EXPECT_EQ(eval_result->value(),
+                    value::LualikeValue{2 * kFib[thread] + run});
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(prelude.Globals().Get("runs"), value::LualikeValue{0});
+    EXPECT_FALSE(prelude.Globals().Get("twice").has_value());
+  }
+}
+
+TEST(IsolateTest, KeepsGlobalsWrittenFromBlocksAndFunctions) {
+  constexpr int kThreads = 4;
+
+  State prelude(Engine::kBytecode);
+  ASSERT_TRUE(prelude.Run("hits = 0\n"
+                          "function hit(x) if x then hits = hits + 1 end end"));
+  auto program =
+      Compile("hit(true)\nif hits > 1 then seen = true end\nreturn hits",
+              Engine::kBytecode);
+  ASSERT_TRUE(program.has_value());
+  const auto shared_program =
+      std::make_shared<const CompiledProgram>(std::move(program).value());
+
+  std::vector<std::thread> threads;
+  threads.reserve(kThreads);
+  for (int thread = 0; thread < kThreads; ++thread) {
+    threads.emplace_back([&] {
+      Isolate isolate(shared_program, prelude);
+      EXPECT_EQ(isolate.Run()->value(), value::LualikeValue{1});
+      EXPECT_EQ(isolate.Run()->value(), value::LualikeValue{2});
+      EXPECT_EQ(isolate.Globals().Get("seen"), value::LualikeValue{true});
+
+      isolate.Reset();
+      EXPECT_EQ(isolate.Globals().Get("hits"), value::LualikeValue{0});
+      EXPECT_FALSE(isolate.Globals().Get("seen").has_value());
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(prelude.Globals().Get("hits"), value::LualikeValue{0});
+}
+
+TEST(IsolateTest, ResetsToPrelude) {
+  State prelude;
+  ASSERT_TRUE(prelude.Run("count = 10"));
+  auto program = Compile("count = count + 1\nreturn count");
+  ASSERT_TRUE(program.has_value());
+
+  Isolate isolate(
+      std::make_shared<const CompiledProgram>(std::move(program).value()),
+      prelude);
+  EXPECT_EQ(isolate.Run()->value(), value::LualikeValue{11});
+  EXPECT_EQ(isolate.Run()->value(), value::LualikeValue{12});
+  isolate.Reset();
+  EXPECT_EQ(isolate.Run()->value(), value::LualikeValue{11});
+}
+
+TEST(IsolateTest, StartsWithEmptyGlobalsWithoutPrelude) {
+  auto program = Compile("return x", Engine::kBytecode);
+  ASSERT_TRUE(program.has_value());
+
+  Isolate isolate(
+      std::make_shared<const CompiledProgram>(std::move(program).value()));
+  EXPECT_FALSE(isolate.Run().has_value());
+  isolate.Globals().Set("x", value::LualikeValue{3});
+  EXPECT_EQ(isolate.Run()->value(), value::LualikeValue{3});
+}
+
+}  // namespace lualike::interpreter
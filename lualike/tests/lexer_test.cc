@@ -3,7 +3,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <optional>
 #include <ranges>
+#include <sstream>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -89,4 +92,118 @@ TEST(LexerTest, ReadAndCompareWithValidSeqTest) {
               }));
 }
 
+static_assert(token::FindKeyword("elseif") == TokenKind::kKeywordElseif);
+static_assert(token::FindKeyword("function") == TokenKind::kKeywordFunction);
+static_assert(token::FindKeyword("functions") == TokenKind::kName);
+static_assert(token::FindPunctuation('~').single == TokenKind::kNone);
+static_assert(token::FindPunctuation('~').pair == TokenKind::kOtherTildeEqual);
+
+TEST(LexerTest, FindsEveryKeywordAndNothingElse) {
+  for (const auto& keyword : token::detail::kKeywords) {
+    EXPECT_EQ(token::FindKeyword(keyword.text), keyword.token_kind)
+        << keyword.text;
+
+    // Names that hash alike or share a prefix with the keyword.
+    std::string name(keyword.text);
+    EXPECT_EQ(token::FindKeyword(name + "_"), TokenKind::kName) << name;
+    EXPECT_EQ(token::FindKeyword(name.substr(0, name.size() - 1)),
+              TokenKind::kName)
+        << name;
+    name[name.size() / 2] = 'X';
+    EXPECT_EQ(token::FindKeyword(name), TokenKind::kName) << name;
+  }
+
+  EXPECT_EQ(token::FindKeyword("x"), TokenKind::kName);
+  EXPECT_EQ(token::FindKeyword("a_rather_long_name"), TokenKind::kName);
+}
+
+TEST(LexerTest, ReadsEveryPunctuationToken) {
+  EXPECT_THAT("+-*/%^< > =();, // == ~= <= >=",
+              LualikeSyntaticlyEqualsTo(std::initializer_list<Token>{
+                  {TokenKind::kOtherPlus},
+                  {TokenKind::kOtherMinus},
+                  {TokenKind::kOtherAsterisk},
+                  {TokenKind::kOtherSlash},
+                  {TokenKind::kOtherPercent},
+                  {TokenKind::kOtherCaret},
+                  {TokenKind::kOtherLessThan},
+                  {TokenKind::kOtherGreaterThan},
+                  {TokenKind::kOtherEqual},
+                  {TokenKind::kOtherLeftParenthesis},
+                  {TokenKind::kOtherRightParenthesis},
+                  {TokenKind::kOtherSemicolon},
+                  {TokenKind::kOtherComma},
+                  {TokenKind::kOtherDoubleSlash},
+                  {TokenKind::kOtherDoubleEqual},
+                  {TokenKind::kOtherTildeEqual},
+                  {TokenKind::kOtherLessThanEqual},
+                  {TokenKind::kOtherGreaterThanEqual},
+              }));
+
+  Lexer lexer("~");
+  EXPECT_THROW(lexer.NextToken(), error::Error);
+}
+
+TEST(LexerTest, StreamedTokensMatchAcrossChunkBoundaries) {
+  constexpr std::string_view kSource =
+      "-- leading comment\n"
+      "local greeting = 'hello, world' local x1 = 12.5 // 3\n"
+      "if x1 >= 2 then return x1 ~= 4 else return -x1 end -- trailing";
+
+  std::vector<Token> expected_tokens;
+  Lexer text_lexer(kSource);
+  while (auto token = text_lexer.NextToken()) {
+    expected_tokens.push_back(token.value());
+  }
+
+  for (size_t chunk_size = 1; chunk_size <= kSource.size() + 1; ++chunk_size) {
+    std::istringstream input{std::string(kSource)};
+    Lexer stream_lexer(input, chunk_size);
+    std::optional<Token> previous_token;
+    std::string previous_text;
+    size_t index = 0;
+    while (auto token = stream_lexer.NextToken()) {
+      ASSERT_LT(index, expected_tokens.size()) << "chunk size " << chunk_size;
+      EXPECT_EQ(token.value(), expected_tokens[index])
+          << "chunk size " << chunk_size << ", token " << index;
+      // The token before stays readable until the next one is requested.
+      if (previous_token) {
+        EXPECT_EQ(previous_token->source_span, previous_text);
+      }
+      previous_token = token;
+      previous_text = std::string(token->source_span);
+      ++index;
+    }
+    EXPECT_EQ(index, expected_tokens.size()) << "chunk size " << chunk_size;
+  }
+}
+
+TEST(LexerTest, StreamedTokenLongerThanTheChunk) {
+  const std::string name(100, 'n');
+  for (const size_t chunk_size : {1, 8, 64}) {
+    std::istringstream input(name + " = 1");
+    Lexer lexer(input, chunk_size);
+
+    const auto token = lexer.NextToken();
+    ASSERT_TRUE(token.has_value()) << "chunk size " << chunk_size;
+    EXPECT_EQ(token->token_kind, TokenKind::kName);
+    EXPECT_EQ(token->source_span, name) << "chunk size " << chunk_size;
+    EXPECT_EQ(lexer.NextToken()->token_kind, TokenKind::kOtherEqual);
+  }
+}
+
+TEST(LexerTest, StreamedUnterminatedStringIsReportedAtTheEnd) {
+  for (const size_t chunk_size : {1, 4, 64}) {
+    std::istringstream input("local s = 'never closed");
+    Lexer lexer(input, chunk_size);
+    EXPECT_THROW(
+        {
+          while (lexer.NextToken()) {
+          }
+        },
+        error::Error)
+        << "chunk size " << chunk_size;
+  }
+}
+
 }  // namespace lualike::lexer
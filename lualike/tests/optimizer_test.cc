@@ -0,0 +1,132 @@
+#include "lualike/optimizer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "lualike/ast.h"
+#include "lualike/interpreter.h"
+#include "lualike/parser.h"
+#include "lualike/value.h"
+
+namespace lualike::optimizer {
+
+MATCHER_P(LualikeFoldsToAstDump, expected_dump, "") {
+  auto program = parser::Parse(std::string_view{arg});
+  if (!program) {
+    *result_listener << program.error().RenderPlain();
+    return false;
+  }
+
+  FoldConstants(program.value());
+  return ExplainMatchResult(testing::StrEq(expected_dump),
+                            ast::ToString(program.value()), result_listener);
+}
+
+TEST(OptimizerTest, FoldsLiteralArithmetic) {
+  EXPECT_THAT("return 2 + 2 * 2", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    LiteralExpression: Number <6>
+)"));
+
+  EXPECT_THAT("return (60 * 60 * 24) / 2", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    LiteralExpression: Number <43200.000000>
+)"));
+
+  EXPECT_THAT("return -(1 < 2 == true)", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    UnaryExpression: -
+      LiteralExpression: True
+)"));
+}
+
+TEST(OptimizerTest, FoldsAroundVariables) {
+  EXPECT_THAT("return x * (3 - 1)", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    BinaryExpression: *
+      VariableExpression: x
+      LiteralExpression: Number <2>
+)"));
+
+  EXPECT_THAT("return nil and x", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    LiteralExpression: Nil
+)"));
+
+  EXPECT_THAT("return 1 and x or y", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    BinaryExpression: or
+      VariableExpression: x
+      VariableExpression: y
+)"));
+}
+
+TEST(OptimizerTest, KeepsOperationsThatWouldFail) {
+  EXPECT_THAT("return 1 + 'a' * 2", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    BinaryExpression: +
+      LiteralExpression: Number <1>
+      BinaryExpression: *
+        LiteralExpression: String <a>
+        LiteralExpression: Number <2>
+)"));
+
+  EXPECT_THAT("return not 1", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    UnaryExpression: not
+      LiteralExpression: Number <1>
+)"));
+}
+
+TEST(OptimizerTest, PrunesConstantIfStatements) {
+  EXPECT_THAT("if 1 > 2 then x = 1 end\nreturn x", LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    VariableExpression: x
+)"));
+
+  EXPECT_THAT("if nil then return 1 else return 2 * 3 end",
+              LualikeFoldsToAstDump(R"(Block
+  ReturnStatement
+    LiteralExpression: Number <6>
+)"));
+
+  // Keeps the block of the taken branch if it declares variables.
+  EXPECT_THAT("if true then local x = 1 else return 2 end",
+              LualikeFoldsToAstDump(R"(Block
+  IfStatement
+    Condition:
+      LiteralExpression: True
+    Then:
+      Block
+        VariableDeclaration: x
+          LiteralExpression: Number <1>
+)"));
+}
+
+TEST(OptimizerTest, DoesNotHoistRuntimeErrors) {
+  const auto unreachable =
+      interpreter::Compile("if false then return 1 + true end\nreturn 2");
+  ASSERT_TRUE(unreachable.has_value());
+  EXPECT_EQ(unreachable->Run(), value::LualikeValue{2});
+
+  const auto failing = interpreter::Compile("return 2 * 3 + true");
+  ASSERT_TRUE(failing.has_value());
+  const auto result = failing->Run();
+  ASSERT_FALSE(result.has_value());
+  EXPECT_THAT(result.error().RenderPretty(),
+              testing::HasSubstr("Failed to evaluate addition"));
+  EXPECT_THAT(result.error().RenderPretty(),
+              testing::HasSubstr("^^^^^^^^^^^^"));
+}
+
+TEST(OptimizerTest, PreservesBareReturnsInsidePrunedBranches) {
+  const auto program =
+      interpreter::Compile("if true then return; end\nreturn 3");
+  ASSERT_TRUE(program.has_value());
+  EXPECT_EQ(program->Run(), value::LualikeValue{});
+}
+
+}  // namespace lualike::optimizer
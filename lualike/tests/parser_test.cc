@@ -1,14 +1,18 @@
 #include "lualike/parser.h"
 
+#include <format>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <variant>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "lualike/ast.h"
 
 using lualike::parser::Parse;
+using lualike::parser::ParseStream;
 
 namespace {
 
@@ -73,6 +77,299 @@ TEST(ParserTest, IfStatement) {
 )"));
 }
 
+TEST(ParserTest, FunctionDeclarationAndCalls) {
+  ASSERT_THAT("function add(a, b) return a + b end\nadd(1, 2)(3)",
+              LualikeParsesToAstDump(R"(Block
+  FunctionDeclaration: add(a, b)
+    Block
+      ReturnStatement
+        BinaryExpression: +
+          VariableExpression: a
+          VariableExpression: b
+  ExpressionStatement
+    FunctionCallExpression
+      Callee:
+        FunctionCallExpression
+          Callee:
+            VariableExpression: add
+          Arguments:
+            LiteralExpression: Number <1>
+            LiteralExpression: Number <2>
+      Arguments:
+        LiteralExpression: Number <3>
+)"));
+
+  const auto duplicate = Parse("function f(a, a) end");
+  ASSERT_FALSE(duplicate.has_value());
+  EXPECT_THAT(duplicate.error().what(),
+              testing::HasSubstr("Duplicate parameter 'a'"));
+}
+
+TEST(ParserTest, AllocatesNodesInProgramArena) {
+  const auto heap_program = Parse("if a then return -b * 2 end");
+  ASSERT_TRUE(heap_program.has_value());
+  EXPECT_EQ(heap_program->arena, nullptr);
+
+  const auto arena_program =
+      Parse("if a then return -b * 2 end", {.use_arena = true});
+  ASSERT_TRUE(arena_program.has_value());
+  ASSERT_NE(arena_program->arena, nullptr);
+
+  const auto& if_statement =
+      std::get<lualike::ast::IfStatement>(arena_program->statements[0].node);
+  EXPECT_TRUE(if_statement.then_branch.get_deleter().in_arena);
+  const auto& returned = std::get<lualike::ast::ReturnStatement>(
+      if_statement.then_branch->statements[0].node);
+  const auto& product =
+      std::get<lualike::ast::BinaryExpression>(returned.expression->node);
+  EXPECT_TRUE(product.lhs.get_deleter().in_arena);
+  EXPECT_TRUE(product.rhs.get_deleter().in_arena);
+}
+
+namespace {
+
+using lualike::parser::FindBinaryOperator;
+using lualike::token::TokenKind;
+
+static_assert(FindBinaryOperator(TokenKind::kOtherAsterisk).precedence >
+              FindBinaryOperator(TokenKind::kOtherPlus).precedence);
+static_assert(FindBinaryOperator(TokenKind::kOtherPlus).precedence >
+              FindBinaryOperator(TokenKind::kOtherDoubleEqual).precedence);
+static_assert(FindBinaryOperator(TokenKind::kKeywordAnd).precedence >
+              FindBinaryOperator(TokenKind::kKeywordOr).precedence);
+static_assert(FindBinaryOperator(TokenKind::kOtherDoubleSlash).oper ==
+              lualike::ast::BinaryOperator::kFloorDivide);
+static_assert(FindBinaryOperator(TokenKind::kOtherCaret).is_right_associative);
+static_assert(
+    !FindBinaryOperator(TokenKind::kOtherMinus).is_right_associative);
+static_assert(FindBinaryOperator(TokenKind::kName).precedence < 0);
+static_assert(FindBinaryOperator(TokenKind::kOtherEqual).precedence < 0);
+static_assert(lualike::parser::kUnaryPrecedence >
+              FindBinaryOperator(TokenKind::kOtherCaret).precedence);
+
+}  // namespace
+
+TEST(ParserTest, GroupsOperatorsByPrecedenceAndAssociativity) {
+  const auto actual_ast =
+      Parse(std::string_view{"return 2 ^ 3 ^ 2 - 1 - 1 < 5 or false"});
+  ASSERT_TRUE(actual_ast.has_value()) << RenderErrorForTest(actual_ast.error());
+  EXPECT_EQ(lualike::ast::ToString(actual_ast.value()), R"(Block
+  ReturnStatement
+    BinaryExpression: or
+      BinaryExpression: <
+        BinaryExpression: -
+          BinaryExpression: -
+            BinaryExpression: ^
+              LiteralExpression: Number <2>
+              BinaryExpression: ^
+                LiteralExpression: Number <3>
+                LiteralExpression: Number <2>
+            LiteralExpression: Number <1>
+          LiteralExpression: Number <1>
+        LiteralExpression: Number <5>
+      LiteralExpression: False
+)");
+}
+
+namespace {
+
+// About 90 KiB of independent top-level statements, enough to be split into
+// several parts.
+std::string MakeBundle() {
+  std::string bundle;
+  for (int i = 0; i < 1'500; ++i) {
+    bundle += std::format(
+        "local v{0} = {0} * 2 + 1\n"
+        "if v{0} > 10 then\n"
+        "  if v{0} < 100 then v{0} = 0 end\n"
+        "else\n"
+        "  v{0} = -v{0}\n"
+        "end\n",
+        i);
+  }
+
+  return bundle;
+}
+
+}  // namespace
+
+TEST(ParserTest, ParsesInParallelLikeSequentially) {
+  const auto bundle = MakeBundle() + "return v1 + v2\n";
+  const auto sequential = Parse(std::string_view{bundle});
+  ASSERT_TRUE(sequential.has_value()) << RenderErrorForTest(sequential.error());
+
+  for (const bool use_arena : {false, true}) {
+    const auto parallel = Parse(
+        std::string_view{bundle},
+        lualike::parser::ParseOptions{.use_arena = use_arena,
+                                      .parse_threads = 4});
+    ASSERT_TRUE(parallel.has_value()) << RenderErrorForTest(parallel.error());
+    EXPECT_EQ(lualike::ast::ToString(parallel.value()),
+              lualike::ast::ToString(sequential.value()));
+    EXPECT_EQ(parallel->span, sequential->span);
+    ASSERT_EQ(parallel->statements.size(), sequential->statements.size());
+    EXPECT_EQ(parallel->statements.back().span,
+              sequential->statements.back().span);
+    EXPECT_EQ(parallel->part_arenas.empty(), !use_arena);
+  }
+}
+
+TEST(ParserTest, ReportsTheFirstErrorWhenParsingInParallel) {
+  const auto bundle = MakeBundle();
+  const std::string broken_sources[] = {
+      // Errors in two parts; the first one wins.
+      bundle + "local broken = \n" + bundle + "local = 1\n",
+      // A return before the last part.
+      bundle + "return 1\n" + bundle,
+      // A lexer error.
+      bundle + "local s = 'unterminated\n" + bundle,
+  };
+
+  for (const auto& source : broken_sources) {
+    const auto sequential = Parse(std::string_view{source});
+    const auto parallel =
+        Parse(std::string_view{source},
+              lualike::parser::ParseOptions{.parse_threads = 4});
+    ASSERT_FALSE(sequential.has_value());
+    ASSERT_FALSE(parallel.has_value());
+    EXPECT_EQ(parallel.error().RenderPlain(),
+              sequential.error().RenderPlain());
+  }
+}
+
+namespace {
+
+struct EditCase {
+  std::string_view description;
+  size_t begin;
+  size_t end;
+  std::string replacement;
+};
+
+void ExpectSameSpans(const lualike::ast::Block& actual,
+                     const lualike::ast::Block& expected) {
+  EXPECT_EQ(actual.span, expected.span);
+  ASSERT_EQ(actual.statements.size(), expected.statements.size());
+  for (size_t i = 0; i < actual.statements.size(); ++i) {
+    const auto& actual_statement = actual.statements[i];
+    const auto& expected_statement = expected.statements[i];
+    EXPECT_EQ(actual_statement.span, expected_statement.span) << i;
+    if (const auto* actual_if =
+            std::get_if<lualike::ast::IfStatement>(&actual_statement.node)) {
+      const auto& expected_if =
+          std::get<lualike::ast::IfStatement>(expected_statement.node);
+      EXPECT_EQ(actual_if->condition.span, expected_if.condition.span) << i;
+      ExpectSameSpans(*actual_if->then_branch, *expected_if.then_branch);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ParserTest, ReparsesEditsLikeAFullParse) {
+  std::string source;
+  for (int i = 0; i < 20; ++i) {
+    source += std::format(
+        "local v{0} = {0} + 1 -- note {0}\n"
+        "if v{0} > 3 then v{0} = v{0} * 2 end\n",
+        i);
+  }
+  const size_t middle = source.find("local v10");
+  const size_t line_end = source.find('\n', middle);
+
+  const EditCase edits[] = {
+      {"changes a literal", middle + 12, middle + 14, "12345"},
+      {"extends a statement", line_end - 11, line_end - 11, " * 7"},
+      {"inserts a statement", middle, middle, "x = 1 y = 2\n"},
+      {"deletes a statement", middle, line_end + 1, ""},
+      {"uncomments a note", line_end - 9, line_end - 7, "+ "},
+      {"comments out code", middle, middle, "-- "},
+      {"edits the first statement", 6, 8, "first"},
+      {"appends a return", source.size(), source.size(), "return v1\n"},
+      {"breaks a statement", middle + 10, middle + 14, "= ="},
+      {"opens a string", middle + 12, middle + 12, "'"},
+      {"adds code after a return", source.size(), source.size(),
+       "return 1 x = 2"},
+  };
+
+  for (const bool use_arena : {false, true}) {
+    const lualike::parser::ParseOptions options{.use_arena = use_arena};
+    for (const auto& edit : edits) {
+      SCOPED_TRACE(edit.description);
+      auto edited = source;
+      edited.replace(edit.begin, edit.end - edit.begin, edit.replacement);
+
+      auto previous = Parse(std::string_view{source}, options);
+      ASSERT_TRUE(previous.has_value());
+      const auto reparsed = lualike::parser::Reparse(
+          std::move(previous).value(), std::string_view{edited},
+          {{edit.begin, edit.end}, edit.replacement}, options);
+      const auto expected = Parse(std::string_view{edited}, options);
+
+      ASSERT_EQ(reparsed.has_value(), expected.has_value());
+      if (!expected) {
+        EXPECT_EQ(reparsed.error().RenderPretty(),
+                  expected.error().RenderPretty());
+        continue;
+      }
+      EXPECT_EQ(lualike::ast::ToString(reparsed.value()),
+                lualike::ast::ToString(expected.value()));
+      ExpectSameSpans(reparsed.value(), expected.value());
+    }
+  }
+}
+
+TEST(ParserTest, ReparsesChainedEdits) {
+  std::string source = "local a = 1\nlocal b = 2\nlocal c = a + b\n";
+  auto program = Parse(std::string_view{source});
+  ASSERT_TRUE(program.has_value());
+
+  const auto apply = [&](size_t begin, size_t end, std::string replacement) {
+    source.replace(begin, end - begin, replacement);
+    program = lualike::parser::Reparse(std::move(program).value(),
+                                       std::string_view{source},
+                                       {{begin, end}, replacement});
+    ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+    const auto expected = Parse(std::string_view{source});
+    EXPECT_EQ(lualike::ast::ToString(program.value()),
+              lualike::ast::ToString(expected.value()));
+    ExpectSameSpans(program.value(), expected.value());
+  };
+
+  // Types digits after "b = 2", adds a statement and removes it again.
+  const size_t b_end = source.find('\n', source.find("local b"));
+  apply(b_end, b_end, "5");
+  apply(b_end + 1, b_end + 1, "5");
+  apply(0, 0, "local z = 0\n");
+  apply(0, 12, "");
+  EXPECT_EQ(source, "local a = 1\nlocal b = 255\nlocal c = a + b\n");
+}
+
+TEST(ParserTest, RejectsEditsThatDoNotMatchTheSource) {
+  auto program = Parse(std::string_view{"local a = 1"});
+  ASSERT_TRUE(program.has_value());
+  const auto reparsed = lualike::parser::Reparse(
+      std::move(program).value(), std::string_view{"local a = 2"},
+      {{10, 11}, "3"});
+  ASSERT_FALSE(reparsed.has_value());
+  EXPECT_THAT(reparsed.error().what(),
+              testing::HasSubstr("Edit does not match the edited source"));
+}
+
+TEST(ParserTest, ArenaModeParsesToTheSameTree) {
+  for (const std::string_view script :
+       {"local a = 1\nreturn a", "return -(1 + 2) * 3 ^ 2 // 4",
+        "if a then local b = 2 else return not c or d end",
+        "function f(x, y) if x then return end return f(y) end\nf(1, 2)"}) {
+    const auto heap_program = Parse(script);
+    const auto arena_program = Parse(script, {.use_arena = true});
+    ASSERT_TRUE(heap_program.has_value()) << script;
+    ASSERT_TRUE(arena_program.has_value()) << script;
+    EXPECT_EQ(lualike::ast::ToString(arena_program.value()),
+              lualike::ast::ToString(heap_program.value()));
+  }
+}
+
 TEST(ParserTest, ReadsFromInputStream) {
   std::istringstream input("return 1 + 2");
   const auto actual_ast = Parse(input);
@@ -85,9 +382,138 @@ TEST(ParserTest, ReadsFromInputStream) {
 )");
 }
 
+TEST(ParserTest, ParsesStreamsInChunks) {
+  const std::string source =
+      "local total = 1 + 2 * 3 -- comment\n"
+      "local name = 'streamed'\n"
+      "if total >= 7 then\n"
+      "  total = total // 2\n"
+      "else\n"
+      "  total = -total\n"
+      "end\n"
+      "return total ~= 3\n";
+  const auto expected_ast = Parse(std::string_view{source});
+  ASSERT_TRUE(expected_ast.has_value())
+      << RenderErrorForTest(expected_ast.error());
+
+  for (const size_t chunk_size : {1, 2, 7, 64, 4096}) {
+    std::istringstream input(source);
+    const auto actual_ast = ParseStream(input, chunk_size);
+    ASSERT_TRUE(actual_ast.has_value())
+        << RenderErrorForTest(actual_ast.error());
+    EXPECT_EQ(lualike::ast::ToString(actual_ast.value()),
+              lualike::ast::ToString(expected_ast.value()))
+        << "chunk size " << chunk_size;
+    EXPECT_EQ(actual_ast->span, expected_ast->span);
+  }
+}
+
+TEST(ParserTest, ReportsStreamOffsetsInChunkedErrors) {
+  std::istringstream input("local x = 1\nlocal y = = 2");
+  const auto actual_ast = ParseStream(input, 4);
+  ASSERT_FALSE(actual_ast.has_value());
+  EXPECT_EQ(actual_ast.error().Root()->GetContextSpan(),
+            (lualike::token::SourceSpan{22, 23}));
+}
+
 TEST(ParserTest, RejectsTrailingTokensAfterReturn) {
   const auto actual_ast = Parse(std::string_view{"return 1 whatever"});
   ASSERT_FALSE(actual_ast.has_value());
   EXPECT_THAT(actual_ast.error().what(),
               testing::HasSubstr("Unexpected token after return statement"));
 }
+
+TEST(ParserTest, ReportsEveryErrorWhenRecovering) {
+  constexpr std::string_view kSource =
+      "local a = 1\n"
+      "local b = = 2\n"
+      "local c = 3 $\n"
+      "if a then\n"
+      "  local d = )\n"
+      "  local e = 5\n"
+      "end\n"
+      "if b == then\n"
+      "  local f = 6\n"
+      "end\n"
+      "local g = 7\n";
+
+  const auto recovered = lualike::parser::ParseRecovering(kSource);
+
+  std::vector<lualike::token::SourceSpan> error_spans;
+  for (const auto& err : recovered.errors) {
+    EXPECT_EQ(err.SourceText(), kSource);
+    error_spans.push_back(*err.Root()->GetContextSpan());
+  }
+  const auto span_of = [&](std::string_view text, size_t from = 0) {
+    const size_t begin = kSource.find(text, from);
+    return lualike::token::SourceSpan{begin, begin + text.size()};
+  };
+  EXPECT_THAT(error_spans,
+              testing::ElementsAre(span_of("=", 22), span_of("$"),
+                                   span_of(")"), span_of("then", 80)));
+  EXPECT_EQ(lualike::ast::ToString(recovered.program), R"(Block
+  VariableDeclaration: a
+    LiteralExpression: Number <1>
+  VariableDeclaration: c
+    LiteralExpression: Number <3>
+  IfStatement
+    Condition:
+      VariableExpression: a
+    Then:
+      Block
+        VariableDeclaration: e
+          LiteralExpression: Number <5>
+  VariableDeclaration: g
+    LiteralExpression: Number <7>
+)");
+
+  const auto first_error = Parse(kSource);
+  ASSERT_FALSE(first_error.has_value());
+  EXPECT_EQ(recovered.errors.front().RenderPretty(),
+            first_error.error().RenderPretty());
+}
+
+TEST(ParserTest, DropsStatementsAfterReturnWhenRecovering) {
+  constexpr std::string_view kSource =
+      "if a then\n"
+      "  return 1\n"
+      "  local b = 2\n"
+      "  local c = )\n"
+      "end\n"
+      "local d = 4\n"
+      "return d\n"
+      "local e = 5\n";
+
+  const auto recovered = lualike::parser::ParseRecovering(kSource);
+
+  ASSERT_EQ(recovered.errors.size(), 3);
+  EXPECT_THAT(recovered.errors[0].what(),
+              testing::HasSubstr("Unexpected token after return statement"));
+  EXPECT_THAT(recovered.errors[2].what(),
+              testing::HasSubstr("Unexpected token after return statement"));
+  EXPECT_EQ(lualike::ast::ToString(recovered.program), R"(Block
+  IfStatement
+    Condition:
+      VariableExpression: a
+    Then:
+      Block
+        ReturnStatement
+          LiteralExpression: Number <1>
+  VariableDeclaration: d
+    LiteralExpression: Number <4>
+  ReturnStatement
+    VariableExpression: d
+)");
+}
+
+TEST(ParserTest, RecoversNothingFromValidSources) {
+  const auto bundle = MakeBundle();
+  const auto recovered =
+      lualike::parser::ParseRecovering(bundle, {.use_arena = true});
+  const auto expected = Parse(std::string_view{bundle});
+  ASSERT_TRUE(expected.has_value());
+  EXPECT_THAT(recovered.errors, testing::IsEmpty());
+  EXPECT_EQ(lualike::ast::ToString(recovered.program),
+            lualike::ast::ToString(expected.value()));
+  EXPECT_EQ(recovered.program.span, expected->span);
+}
@@ -0,0 +1,135 @@
+#include "lualike/resolver.h"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string_view>
+#include <variant>
+
+#include "lualike/parser.h"
+
+namespace lualike::resolver {
+
+namespace {
+
+ast::Program ParseAndResolve(std::string_view input) {
+  auto program = parser::Parse(input);
+  EXPECT_TRUE(program.has_value()) << program.error().RenderPlain();
+  Resolve(program.value());
+  return std::move(program).value();
+}
+
+const ast::IfStatement& AsIf(const ast::Statement& statement) {
+  return std::get<ast::IfStatement>(statement.node);
+}
+
+const ast::VariableDeclaration& AsDeclaration(const ast::Statement& statement) {
+  return std::get<ast::VariableDeclaration>(statement.node);
+}
+
+const ast::VariableExpression& ReturnedVariable(
+    const ast::Statement& statement) {
+  return std::get<ast::VariableExpression>(
+      std::get<ast::ReturnStatement>(statement.node).expression->node);
+}
+
+}  // namespace
+
+TEST(ResolverTest, TopLevelDeclarationsStayGlobal) {
+  const auto program = ParseAndResolve("local a = 1\nreturn a");
+
+  EXPECT_EQ(AsDeclaration(program.statements[0]).slot, std::nullopt);
+  EXPECT_EQ(ReturnedVariable(program.statements[1]).slot, std::nullopt);
+  EXPECT_EQ(program.slot_count, 0);
+}
+
+TEST(ResolverTest, AssignsSlotsToNestedBlockLocals) {
+  const auto program = ParseAndResolve(
+      "if c then\n"
+      "  local a = 1\n"
+      "  local b = 2\n"
+      "  return b\n"
+      "end");
+  const auto& then_branch = *AsIf(program.statements[0]).then_branch;
+
+  EXPECT_EQ(then_branch.slot_count, 2);
+  EXPECT_EQ(AsDeclaration(then_branch.statements[0]).slot,
+            (ast::LocalSlot{0, 0}));
+  EXPECT_EQ(AsDeclaration(then_branch.statements[1]).slot,
+            (ast::LocalSlot{0, 1}));
+  EXPECT_EQ(ReturnedVariable(then_branch.statements[2]).slot,
+            (ast::LocalSlot{0, 1}));
+}
+
+TEST(ResolverTest, ResolvesEnclosingBlocksByDepth) {
+  const auto program = ParseAndResolve(
+      "if c then\n"
+      "  local a = 1\n"
+      "  if d then\n"
+      "    a = 2\n"
+      "    return a\n"
+      "  end\n"
+      "end");
+  const auto& outer = *AsIf(program.statements[0]).then_branch;
+  const auto& inner = *AsIf(outer.statements[1]).then_branch;
+
+  EXPECT_EQ(inner.slot_count, 0);
+  EXPECT_EQ(AsDeclaration(inner.statements[0]).slot, (ast::LocalSlot{1, 0}));
+  EXPECT_EQ(ReturnedVariable(inner.statements[1]).slot,
+            (ast::LocalSlot{1, 0}));
+}
+
+TEST(ResolverTest, NestedDeclarationsUpdateEarlierGlobals) {
+  const auto program = ParseAndResolve(
+      "x = 1\n"
+      "if c then x = 2 end");
+  const auto& then_branch = *AsIf(program.statements[1]).then_branch;
+
+  EXPECT_EQ(then_branch.slot_count, 0);
+  EXPECT_EQ(AsDeclaration(then_branch.statements[0]).slot, std::nullopt);
+}
+
+TEST(ResolverTest, DeclarationsWithoutLocalBindGlobals) {
+  const auto program = ParseAndResolve(
+      "if c then x = 2 end\n"
+      "function f() n = n + 1 end");
+  const auto& then_branch = *AsIf(program.statements[0]).then_branch;
+  const auto& body =
+      *std::get<ast::FunctionDeclaration>(program.statements[1].node).body;
+
+  EXPECT_EQ(then_branch.slot_count, 0);
+  EXPECT_EQ(AsDeclaration(then_branch.statements[0]).slot, std::nullopt);
+  EXPECT_EQ(body.slot_count, 0);
+  EXPECT_EQ(AsDeclaration(body.statements[0]).slot, std::nullopt);
+}
+
+TEST(ResolverTest, LocalDeclarationsShadowEnclosingLocals) {
+  const auto program = ParseAndResolve(
+      "if c then\n"
+      "  local a = 1\n"
+      "  if d then\n"
+      "    local a = 2\n"
+      "    return a\n"
+      "  end\n"
+      "end");
+  const auto& outer = *AsIf(program.statements[0]).then_branch;
+  const auto& inner = *AsIf(outer.statements[1]).then_branch;
+
+  EXPECT_EQ(inner.slot_count, 1);
+  EXPECT_EQ(AsDeclaration(inner.statements[0]).slot, (ast::LocalSlot{0, 0}));
+  EXPECT_EQ(ReturnedVariable(inner.statements[1]).slot,
+            (ast::LocalSlot{0, 0}));
+}
+
+TEST(ResolverTest, InitializerIsResolvedBeforeTheDeclaration) {
+  const auto program = ParseAndResolve("if c then local a = a end");
+  const auto& declaration =
+      AsDeclaration(AsIf(program.statements[0]).then_branch->statements[0]);
+
+  EXPECT_EQ(declaration.slot, (ast::LocalSlot{0, 0}));
+  EXPECT_EQ(std::get<ast::VariableExpression>(declaration.initializer->node)
+                .slot,
+            std::nullopt);
+}
+
+}  // namespace lualike::resolver
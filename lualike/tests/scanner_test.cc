@@ -0,0 +1,112 @@
+#include "lualike/scanner.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lualike/lexer.h"
+
+namespace lualike::scanner {
+
+namespace {
+
+// Restores the detected implementation after each test.
+class ScannerTest : public testing::Test {
+ protected:
+  void TearDown() override { SetIsa(DetectIsa()); }
+
+  static std::vector<Isa> SupportedIsas() {
+    std::vector<Isa> isas;
+    for (const auto isa : {Isa::kScalar, Isa::kSse2, Isa::kAvx2}) {
+      if (isa <= DetectIsa()) {
+        isas.push_back(isa);
+      }
+    }
+
+    return isas;
+  }
+};
+
+// Every byte value, each followed by runs of whitespace, name characters and
+// digits of lengths around the vector widths.
+std::string MakeText() {
+  std::string text;
+  for (int byte = 0; byte < 256; ++byte) {
+    const auto run_length = static_cast<size_t>(byte % 40);
+    text += static_cast<char>(byte);
+    text += std::string(run_length, " \t\n\r\v\f"[byte % 6]);
+    text += std::string(run_length, "aZ_09x"[byte % 6]);
+    text += std::string(run_length, "0123456789"[byte % 10]);
+  }
+
+  return text;
+}
+
+}  // namespace
+
+TEST_F(ScannerTest, AllInstructionSetsAgreeWithScalar) {
+  const auto text = MakeText();
+
+  for (const auto isa : SupportedIsas()) {
+    ASSERT_EQ(SetIsa(isa), isa);
+    for (size_t pos = 0; pos <= text.size(); ++pos) {
+      SetIsa(Isa::kScalar);
+      const auto whitespace = SkipWhitespace(text, pos);
+      const auto name = SkipNameChars(text, pos);
+      const auto digits = SkipDigits(text, pos);
+      const auto newline = FindByte(text, pos, '\n');
+
+      SetIsa(isa);
+      EXPECT_EQ(SkipWhitespace(text, pos), whitespace) << pos;
+      EXPECT_EQ(SkipNameChars(text, pos), name) << pos;
+      EXPECT_EQ(SkipDigits(text, pos), digits) << pos;
+      EXPECT_EQ(FindByte(text, pos, '\n'), newline) << pos;
+    }
+  }
+}
+
+TEST_F(ScannerTest, StopsAtTheEndOfTheText) {
+  for (const auto isa : SupportedIsas()) {
+    SetIsa(isa);
+    const std::string text(37, '\t');
+    EXPECT_EQ(SkipWhitespace(text, 0), text.size());
+    EXPECT_EQ(SkipWhitespace(text + "x", 3), text.size());
+    EXPECT_EQ(FindByte(text, 0, 'x'), text.size());
+    EXPECT_EQ(SkipNameChars("", 0), 0);
+  }
+}
+
+TEST_F(ScannerTest, LexerProducesSameTokensWithEveryInstructionSet) {
+  const std::string script =
+      "local a_rather_long_identifier_name = 12345678901234567890.5\n"
+      "-- a comment that is longer than one vector register\n"
+      "if a_rather_long_identifier_name then\n"
+      "                                        return 'a string literal "
+      "spanning more than 32 bytes'\n"
+      "end";
+
+  std::vector<std::vector<token::Token>> tokens_per_isa;
+  for (const auto isa : SupportedIsas()) {
+    SetIsa(isa);
+    auto& tokens = tokens_per_isa.emplace_back();
+    lexer::Lexer lexer(script);
+    while (auto next_token = lexer.NextToken()) {
+      tokens.push_back(next_token.value());
+    }
+  }
+
+  ASSERT_EQ(tokens_per_isa.front().size(), 10);
+  for (const auto& tokens : tokens_per_isa) {
+    ASSERT_EQ(tokens.size(), tokens_per_isa.front().size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      EXPECT_EQ(tokens[i].token_kind, tokens_per_isa.front()[i].token_kind);
+      EXPECT_EQ(tokens[i].source_span, tokens_per_isa.front()[i].source_span);
+    }
+  }
+}
+
+}  // namespace lualike::scanner
@@ -0,0 +1,76 @@
+#include "lualike/source_file.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace lualike::source {
+
+namespace {
+
+// A file in the temporary directory, removed with the test.
+class SourceFileTest : public testing::Test {
+ protected:
+  std::filesystem::path path_ =
+      std::filesystem::temp_directory_path() /
+      (std::string("lualike_") +
+       testing::UnitTest::GetInstance()->current_test_info()->name() +
+       ".lua");
+
+  void Write(std::string_view text) const {
+    std::ofstream(path_, std::ios::binary) << text;
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+};
+
+}  // namespace
+
+TEST_F(SourceFileTest, MapsOrReadsRegularFiles) {
+  const std::string script = "local x = 1\n" + std::string(100'000, ' ') +
+                             "\nreturn x\n";
+  Write(script);
+
+  for (const bool use_mmap : {true, false}) {
+    const auto source = ReadFile(path_, {.use_mmap = use_mmap});
+    ASSERT_TRUE(source.has_value()) << source.error().what();
+    EXPECT_EQ(source.value()->Text(), script);
+    EXPECT_EQ(source.value()->IsBorrowed(), use_mmap);
+    EXPECT_EQ(source.value()->LocateLine(script.size() - 2).line_number, 3);
+  }
+}
+
+TEST_F(SourceFileTest, ReadsEmptyFiles) {
+  Write("");
+
+  const auto source = ReadFile(path_);
+  ASSERT_TRUE(source.has_value()) << source.error().what();
+  EXPECT_TRUE(source.value()->Text().empty());
+}
+
+#ifdef __linux__
+TEST_F(SourceFileTest, ReadsFilesThatReportNoSize) {
+  // Regular files in procfs report a size of 0.
+  const auto source = ReadFile("/proc/self/status");
+  ASSERT_TRUE(source.has_value()) << source.error().what();
+  EXPECT_THAT(source.value()->Text(), testing::HasSubstr("Name:"));
+}
+#endif
+
+TEST_F(SourceFileTest, ReportsUnreadablePaths) {
+  const auto missing = ReadFile(path_);
+  ASSERT_FALSE(missing.has_value());
+  EXPECT_THAT(missing.error().what(),
+              testing::StartsWith("Failed to read '" + path_.string() + "'"));
+
+  const auto directory =
+      ReadFile(std::filesystem::temp_directory_path());
+  ASSERT_FALSE(directory.has_value());
+  EXPECT_THAT(directory.error().what(), testing::HasSubstr("Failed to read"));
+}
+
+}  // namespace lualike::source
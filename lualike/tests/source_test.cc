@@ -0,0 +1,59 @@
+#include "lualike/source.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace lualike::source {
+
+MATCHER_P3(IsLine, line_number, line_begin, line_end, "") {
+  return arg.line_number == line_number && arg.line_begin == line_begin &&
+         arg.line_end == line_end;
+}
+
+TEST(SourceTest, LocatesLinesOfOffsets) {
+  const LineIndex lines("local x = 1\n\nreturn x\n");
+  EXPECT_EQ(lines.LineCount(), 4);
+
+  EXPECT_THAT(lines.Locate(0), IsLine(1, 0, 11));
+  EXPECT_THAT(lines.Locate(6), IsLine(1, 0, 11));
+  // A newline belongs to the line it terminates.
+  EXPECT_THAT(lines.Locate(11), IsLine(1, 0, 11));
+  EXPECT_THAT(lines.Locate(12), IsLine(2, 12, 12));
+  EXPECT_THAT(lines.Locate(13), IsLine(3, 13, 21));
+  EXPECT_THAT(lines.Locate(22), IsLine(4, 22, 22));
+  EXPECT_THAT(lines.Locate(1000), IsLine(4, 22, 22));
+}
+
+TEST(SourceTest, LocatesInTextsWithoutNewlines) {
+  EXPECT_THAT(LineIndex("return 1").Locate(3), IsLine(1, 0, 8));
+  EXPECT_THAT(LineIndex("").Locate(0), IsLine(1, 0, 0));
+  EXPECT_THAT(LineIndex().Locate(5), IsLine(1, 0, 0));
+}
+
+TEST(SourceTest, BuildsTheLineIndexOfABufferOnce) {
+  const SourceBuffer buffer(std::string("a\nb\nc"));
+  const auto* lines = &buffer.Lines();
+
+  EXPECT_EQ(buffer.Text(), "a\nb\nc");
+  EXPECT_THAT(buffer.LocateLine(4), IsLine(3, 4, 5));
+  EXPECT_EQ(&buffer.Lines(), lines);
+  EXPECT_EQ(lines->LineCount(), 3);
+}
+
+TEST(SourceTest, BorrowsOrOwnsText) {
+  const std::string text = "return 1";
+
+  const auto borrowed = SourceBuffer::Borrow(text);
+  EXPECT_TRUE(borrowed->IsBorrowed());
+  EXPECT_EQ(borrowed->Text().data(), text.data());
+
+  const auto owned = SourceBuffer::Own(text);
+  EXPECT_FALSE(owned->IsBorrowed());
+  EXPECT_NE(owned->Text().data(), text.data());
+  EXPECT_EQ(owned->Text(), text);
+  EXPECT_FALSE(SourceBuffer::Own("")->IsBorrowed());
+}
+
+}  // namespace lualike::source
@@ -0,0 +1,164 @@
+#include "lualike/state.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "lualike/interpreter.h"
+#include "lualike/value.h"
+
+namespace lualike::interpreter {
+
+namespace {
+
+std::string RenderErrorForTest(const error::Error& err) {
+  return err.HasSourceText() ? err.RenderPretty() : err.RenderPlain();
+}
+
+}  // namespace
+
+TEST(StateTest, KeepsGlobalsAcrossRuns) {
+  State state;
+  ASSERT_TRUE(state.Run("base = 40\nfunction add(a, b) return a + b end"));
+
+  const auto eval_result = state.Run("return add(base, 2)");
+  ASSERT_TRUE(eval_result.has_value())
+      << RenderErrorForTest(eval_result.error());
+  EXPECT_EQ(eval_result->value(), value::LualikeValue{42});
+}
+
+TEST(StateTest, ResetsToSnapshot) {
+  State state;
+  ASSERT_TRUE(state.Run("limit = 10\nfunction clamp(x)\n"
+                        "  if x > limit then return limit end\n"
+                        "  return x\n"
+                        "end"));
+  state.Snapshot();
+
+  for (int request = 0; request < 3; ++request) {
+    ASSERT_TRUE(state.Run("limit = 5\nseen = 1\nfunction clamp(x) end"));
+    state.Reset();
+
+    const auto eval_result = state.Run("return clamp(20)");
+    ASSERT_TRUE(eval_result.has_value())
+        << RenderErrorForTest(eval_result.error());
+    EXPECT_EQ(eval_result->value(), value::LualikeValue{10});
+    EXPECT_FALSE(state.Globals().Get("seen").has_value());
+    state.Reset();
+  }
+}
+
+TEST(StateTest, ResetsToEmptyGlobalsWithoutSnapshot) {
+  State state(Engine::kBytecode);
+  ASSERT_TRUE(state.Run("x = 1"));
+  state.Reset();
+
+  EXPECT_FALSE(state.Globals().Get("x").has_value());
+  EXPECT_FALSE(state.Run("return x").has_value());
+}
+
+TEST(StateTest, RunsCallerCompiledPrograms) {
+  const auto handler = Compile("count = count + 1\nreturn count");
+  ASSERT_TRUE(handler.has_value()) << RenderErrorForTest(handler.error());
+
+  State state;
+  state.Globals().Set("count", value::LualikeValue{0});
+  state.Snapshot();
+  for (int request = 0; request < 3; ++request) {
+    const auto eval_result = state.Run(*handler);
+    ASSERT_TRUE(eval_result.has_value())
+        << RenderErrorForTest(eval_result.error());
+    EXPECT_EQ(eval_result->value(), value::LualikeValue{1});
+    state.Reset();
+  }
+}
+
+TEST(StateTest, KeepsGlobalsWrittenFromBlocksAndFunctions) {
+  for (const auto engine : {Engine::kTreeWalker, Engine::kBytecode,
+                            Engine::kFlatTreeWalker}) {
+    State state(engine);
+    state.Globals().Set("count", value::LualikeValue{0});
+    ASSERT_TRUE(state.Run("total = 0\n"
+                          "function record(x)\n"
+                          "  if x > 0 then total = total + x end\n"
+                          "end"));
+    state.Snapshot();
+
+    for (int request = 0; request < 2; ++request) {
+      state.Globals().Set("req", value::LualikeValue{true});
+      ASSERT_TRUE(state.Run("if req then count = count + 1 end\n"
+                            "record(5)\n"
+                            "record(-1)"));
+      EXPECT_EQ(state.Globals().Get("count"), value::LualikeValue{1});
+      EXPECT_EQ(state.Globals().Get("total"), value::LualikeValue{5});
+
+      state.Reset();
+      EXPECT_EQ(state.Globals().Get("count"), value::LualikeValue{0});
+      EXPECT_EQ(state.Globals().Get("total"), value::LualikeValue{0});
+    }
+  }
+}
+
+TEST(StateTest, ForksShareGlobalsCopyOnWrite) {
+  State state(Engine::kBytecode);
+  ASSERT_TRUE(state.Run("limit = 10\nfunction clamp(x)\n"
+                        "  if x > limit then return limit end\n"
+                        "  return x\n"
+                        "end"));
+
+  auto first = state.Fork();
+  auto second = state.Fork();
+  ASSERT_TRUE(first.Run("limit = 5"));
+  state.Globals().Set("limit", value::LualikeValue{7});
+
+  // Functions of the prelude read the globals of the fork they are called
+  // from.
+  EXPECT_EQ(first.Run("return clamp(20)")->value(), value::LualikeValue{5});
+  EXPECT_EQ(second.Run("return clamp(20)")->value(), value::LualikeValue{10});
+  EXPECT_EQ(state.Run("return clamp(20)")->value(), value::LualikeValue{7});
+
+  first.Reset();
+  EXPECT_EQ(first.Run("return clamp(20)")->value(), value::LualikeValue{10});
+}
+
+TEST(StateTest, ForksKeepGlobalsWrittenFromBlocksAndFunctions) {
+  State state(Engine::kFlatTreeWalker);
+  state.Globals().Set("count", value::LualikeValue{0});
+  ASSERT_TRUE(
+      state.Run("function bump() if true then count = count + 1 end end"));
+
+  auto first = state.Fork();
+  auto second = state.Fork();
+  ASSERT_TRUE(first.Run("bump()\nbump()"));
+  ASSERT_TRUE(second.Run("if count == 0 then count = 10 end"));
+
+  EXPECT_EQ(first.Globals().Get("count"), value::LualikeValue{2});
+  EXPECT_EQ(second.Globals().Get("count"), value::LualikeValue{10});
+  EXPECT_EQ(state.Globals().Get("count"), value::LualikeValue{0});
+
+  first.Reset();
+  EXPECT_EQ(first.Globals().Get("count"), value::LualikeValue{0});
+}
+
+TEST(StateTest, ForksOfForksKeepTheirOwnChanges) {
+  State state;
+  state.Globals().Set("a", value::LualikeValue{1});
+  auto fork = state.Fork();
+  fork.Globals().Set("b", value::LualikeValue{2});
+  auto nested = fork.Fork();
+  nested.Globals().Set("a", value::LualikeValue{3});
+
+  EXPECT_EQ(nested.Run("return a + b")->value(), value::LualikeValue{5});
+  EXPECT_EQ(fork.Run("return a + b")->value(), value::LualikeValue{3});
+  EXPECT_FALSE(state.Globals().Get("b").has_value());
+}
+
+TEST(StateTest, ReportsCompileErrors) {
+  State state;
+  const auto eval_result = state.Run("return 2 whatever");
+  ASSERT_FALSE(eval_result.has_value());
+  EXPECT_TRUE(eval_result.error().HasSourceText());
+}
+
+}  // namespace lualike::interpreter
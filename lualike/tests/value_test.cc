@@ -113,4 +113,34 @@ TEST(OperatorsValidityTest, BinaryLogicalOpsTest) {
   EXPECT_THROW({ !LLV{""}; }, LualikeValueOpErr);
 }
 
+TEST(OperatorsValidityTest, NonThrowingOpsReportErrorKinds) {
+  EXPECT_EQ(TryAdd(LLV{2}, LLV{3}), LLV{5});
+  EXPECT_EQ(TryFloorDivide(LLV{7}, LLV{2}), LLV{3.0});
+  EXPECT_EQ(TryNot(LLV{false}), LLV{true});
+
+  EXPECT_EQ(TryAdd(LLV{""}, LLV{1}).error(),
+            LualikeValueOpErrKind::kLhsNotNumeric);
+  EXPECT_EQ(TryModulo(LLV{1}, LLV{}).error(),
+            LualikeValueOpErrKind::kRhsNotNumeric);
+  EXPECT_EQ(TryDivide(LLV{true}, LLV{""}).error(),
+            LualikeValueOpErrKind::kLhsNotNumeric);
+  EXPECT_EQ(TryNegate(LLV{""}).error(),
+            LualikeValueOpErrKind::kNotNumericOperand);
+  EXPECT_EQ(TryAnd(LLV{true}, LLV{1}).error(),
+            LualikeValueOpErrKind::kRhsNotBool);
+  EXPECT_EQ(TryOr(LLV{1}, LLV{2}).error(), LualikeValueOpErrKind::kLhsNotBool);
+  EXPECT_EQ(TryNot(LLV{0}).error(), LualikeValueOpErrKind::kNotBoolOperand);
+}
+
+TEST(OperatorsValidityTest, ThrowingOpsKeepOperandOnError) {
+  LLV lhs{"text"};
+  try {
+    lhs += LLV{1};
+    FAIL() << "Expected LualikeValueOpErr";
+  } catch (const LLVOpErr& err) {
+    EXPECT_EQ(err.error_kind, LualikeValueOpErrKind::kLhsNotNumeric);
+  }
+  EXPECT_EQ(lhs, LLV{"text"});
+}
+
 }  // namespace lualike::value
@@ -0,0 +1,186 @@
+#include "lualike/vm.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "lualike/interpreter.h"
+#include "lualike/value.h"
+
+namespace lualike::vm {
+
+namespace {
+
+std::string RenderErrorForTest(const error::Error& err) {
+  return err.HasSourceText() ? err.RenderPretty() : err.RenderPlain();
+}
+
+}  // namespace
+
+// Runs the script on every engine and expects the same outcome as the tree
+// walker.
+MATCHER(LualikeEnginesAgree, "") {
+  const auto source = std::string_view{arg};
+  const auto walker = interpreter::Compile(source);
+  if (!walker) {
+    *result_listener << "failed to compile";
+    return false;
+  }
+  const auto expected = walker->Run();
+
+  for (const auto engine :
+       {interpreter::Engine::kBytecode, interpreter::Engine::kFlatTreeWalker}) {
+    const auto program = interpreter::Compile(source, engine);
+    if (!program) {
+      *result_listener << "failed to compile";
+      return false;
+    }
+
+    const auto actual = program->Run();
+    *result_listener << "engine " << static_cast<int>(engine) << ": ";
+    if (expected.has_value() != actual.has_value()) {
+      *result_listener << "only one engine failed: "
+                       << RenderErrorForTest(expected ? actual.error()
+                                                      : expected.error());
+      return false;
+    }
+    if (!expected) {
+      if (!ExplainMatchResult(testing::StrEq(expected.error().what()),
+                              actual.error().what(), result_listener)) {
+        return false;
+      }
+    } else if (!ExplainMatchResult(testing::Eq(expected.value()),
+                                   actual.value(), result_listener)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+TEST(VmTest, MatchesTreeWalkerOnExpressions) {
+  EXPECT_THAT("return 1", LualikeEnginesAgree());
+  EXPECT_THAT("return 3.14 * 2", LualikeEnginesAgree());
+  EXPECT_THAT("return 2 + 2 * 2 + -4.0", LualikeEnginesAgree());
+  EXPECT_THAT("return (2 + 2) * 2 + -4.0", LualikeEnginesAgree());
+  EXPECT_THAT("return 7 // 2 + 7 % 3 - 2 ^ 3 / 4", LualikeEnginesAgree());
+  EXPECT_THAT("return 1 < 2 == (3 >= 3)", LualikeEnginesAgree());
+  EXPECT_THAT("return not false", LualikeEnginesAgree());
+}
+
+TEST(VmTest, MatchesTreeWalkerOnShortCircuitOperators) {
+  EXPECT_THAT("return nil and undefined", LualikeEnginesAgree());
+  EXPECT_THAT("return 1 or undefined", LualikeEnginesAgree());
+  EXPECT_THAT("return false or nil", LualikeEnginesAgree());
+  EXPECT_THAT("return 0 and 'zero is truthy'", LualikeEnginesAgree());
+}
+
+TEST(VmTest, MatchesTreeWalkerOnStatements) {
+  EXPECT_THAT("local pi = 3.14", LualikeEnginesAgree());
+  EXPECT_THAT(";;;", LualikeEnginesAgree());
+  EXPECT_THAT("return;", LualikeEnginesAgree());
+  EXPECT_THAT("local x = 1\nif true then x = 2 end\nreturn x",
+              LualikeEnginesAgree());
+  EXPECT_THAT("if true then local y = 2 end\nreturn y", LualikeEnginesAgree());
+  EXPECT_THAT("if false then return 1 end\nreturn 2", LualikeEnginesAgree());
+  EXPECT_THAT("if nil then return 1 else return; end\nreturn 3",
+              LualikeEnginesAgree());
+  EXPECT_THAT(
+      "cond = true\n"
+      "if cond then\n"
+      "  return 3.14\n"
+      "else\n"
+      "  return -1\n"
+      "end\n",
+      LualikeEnginesAgree());
+}
+
+TEST(VmTest, MatchesTreeWalkerOnNestedLocals) {
+  EXPECT_THAT(
+      "if true then\n"
+      "  local a = 1\n"
+      "  if true then\n"
+      "    local b = a + 1\n"
+      "    a = b * 10\n"
+      "  end\n"
+      "  return a\n"
+      "end",
+      LualikeEnginesAgree());
+  EXPECT_THAT(
+      "x = 1\n"
+      "if true then local x = 2 end\n"
+      "return x",
+      LualikeEnginesAgree());
+  EXPECT_THAT(
+      "if true then local a = 1 end\n"
+      "if true then return a end",
+      LualikeEnginesAgree());
+}
+
+TEST(VmTest, MatchesTreeWalkerOnErrors) {
+  EXPECT_THAT("return 2 + 5 + whatever", LualikeEnginesAgree());
+  EXPECT_THAT("return true + 1", LualikeEnginesAgree());
+  EXPECT_THAT("return -'text'", LualikeEnginesAgree());
+}
+
+TEST(VmTest, MatchesTreeWalkerOnFunctions) {
+  EXPECT_THAT(
+      "function fib(n)\n"
+      "  if n < 2 then return n end\n"
+      "  return fib(n - 1) + fib(n - 2)\n"
+      "end\n"
+      "return fib(15)",
+      LualikeEnginesAgree());
+  EXPECT_THAT(
+      "function pick(a, b, c)\n"
+      "  local sum = a + b\n"
+      "  if c then return sum * c end\n"
+      "  return sum\n"
+      "end\n"
+      "return pick(1, 2) + pick(1, 2, 3, 4)",
+      LualikeEnginesAgree());
+  EXPECT_THAT(
+      "if true then\n"
+      "  local twice = 0\n"
+      "  function twice(x) function inner(y) return y * 2 end\n"
+      "    return inner(x) end\n"
+      "  return twice(4) + inner(1)\n"
+      "end",
+      LualikeEnginesAgree());
+  EXPECT_THAT("function f() end\nreturn f()", LualikeEnginesAgree());
+  EXPECT_THAT("x = 1\nreturn x()", LualikeEnginesAgree());
+  EXPECT_THAT("function f(n) return f(n + 1) end\nreturn f(1)",
+              LualikeEnginesAgree());
+}
+
+TEST(VmTest, ReportsErrorsWithSourceSpans) {
+  const auto program = interpreter::Compile("return 2 + 5 + whatever",
+                                            interpreter::Engine::kBytecode);
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  const auto eval_result = program->Run();
+  ASSERT_FALSE(eval_result.has_value());
+  const auto pretty = eval_result.error().RenderPretty();
+  EXPECT_THAT(pretty, testing::HasSubstr("Unknown variable: 'whatever'"));
+  EXPECT_THAT(pretty, testing::HasSubstr("^^^^^^^^"));
+}
+
+TEST(VmTest, ReadsProvidedGlobals) {
+  const auto program =
+      interpreter::Compile("return base * 2", interpreter::Engine::kBytecode);
+  ASSERT_TRUE(program.has_value()) << RenderErrorForTest(program.error());
+
+  const auto globals = std::make_shared<interpreter::Scope>();
+  globals->Set("base", value::LualikeValue{21});
+  const auto eval_result = Execute(
+      std::make_shared<const bytecode::Chunk>(
+          bytecode::Compile(program->Program())),
+      globals);
+  ASSERT_TRUE(eval_result.has_value());
+  EXPECT_EQ(eval_result.value(), value::LualikeValue{42});
+}
+
+}  // namespace lualike::vm
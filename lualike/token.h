@@ -2,11 +2,11 @@
 #define LUALIKE_TOKEN_H_
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string_view>
-#include <unordered_map>
 
 namespace lualike::token {
 
@@ -91,6 +91,9 @@ enum class TokenKind : uint8_t {
   kOtherDot,
 };
 
+inline constexpr size_t kTokenKindCount =
+    static_cast<size_t>(TokenKind::kOtherDot) + 1;
+
 struct Token {
   TokenKind token_kind;
   std::string_view source_span;
@@ -99,7 +102,23 @@ struct Token {
   bool operator==(const Token& rhs) const = default;
 };
 
-inline const std::unordered_map<std::string_view, TokenKind> kKeywordsMap = {
+struct KeywordEntry {
+  std::string_view text;
+  TokenKind token_kind = TokenKind::kName;
+};
+
+struct PunctuationEntry {
+  // kNone if the character is no token on its own.
+  TokenKind single = TokenKind::kNone;
+  // The two-character token starting with the character, if any, and the
+  // character that completes it.
+  TokenKind pair = TokenKind::kNone;
+  char pair_second = '\0';
+};
+
+namespace detail {
+
+inline constexpr std::array<KeywordEntry, 22> kKeywords = {{
     {"and", TokenKind::kKeywordAnd},
     {"break", TokenKind::kKeywordBreak},
     {"do", TokenKind::kKeywordDo},
@@ -122,32 +141,91 @@ inline const std::unordered_map<std::string_view, TokenKind> kKeywordsMap = {
     {"true", TokenKind::kKeywordTrue},
     {"until", TokenKind::kKeywordUntil},
     {"while", TokenKind::kKeywordWhile},
-};
+}};
 
-inline const std::unordered_map<char, TokenKind> kOtherSingleCharTokensMap = {
-    {'+', TokenKind::kOtherPlus},
-    {'-', TokenKind::kOtherMinus},
-    {'*', TokenKind::kOtherAsterisk},
-    {'/', TokenKind::kOtherSlash},
-    {'%', TokenKind::kOtherPercent},
-    {'^', TokenKind::kOtherCaret},
-    {'<', TokenKind::kOtherLessThan},
-    {'>', TokenKind::kOtherGreaterThan},
-    {'=', TokenKind::kOtherEqual},
-    {'(', TokenKind::kOtherLeftParenthesis},
-    {')', TokenKind::kOtherRightParenthesis},
-    {';', TokenKind::kOtherSemicolon},
-    {',', TokenKind::kOtherComma},
-};
+inline constexpr size_t kKeywordTableSize = 64;
+inline constexpr size_t kMinKeywordLength = 2;
+inline constexpr size_t kMaxKeywordLength = 8;
 
-inline const std::unordered_map<std::string_view, TokenKind>
-    kOtherTwoCharTokensMap = {
-        {"//", TokenKind::kOtherDoubleSlash},
-        {"==", TokenKind::kOtherDoubleEqual},
-        {"~=", TokenKind::kOtherTildeEqual},
-        {"<=", TokenKind::kOtherLessThanEqual},
-        {">=", TokenKind::kOtherGreaterThanEqual},
-};
+// Perfect on kKeywords, which BuildKeywordTable checks at compile time.
+constexpr size_t HashKeyword(std::string_view text) noexcept {
+  return (static_cast<unsigned char>(text.front()) * 3U +
+          static_cast<unsigned char>(text.back()) * 13U + text.size()) %
+         kKeywordTableSize;
+}
+
+consteval std::array<KeywordEntry, kKeywordTableSize> BuildKeywordTable() {
+  std::array<KeywordEntry, kKeywordTableSize> table{};
+  for (const auto& keyword : kKeywords) {
+    if (keyword.text.size() < kMinKeywordLength ||
+        keyword.text.size() > kMaxKeywordLength) {
+      throw "keyword length out of range";
+    }
+
+    auto& slot = table[HashKeyword(keyword.text)];
+    if (!slot.text.empty()) {
+      throw "keyword hash collision";
+    }
+    slot = keyword;
+  }
+
+  return table;
+}
+
+consteval std::array<PunctuationEntry, 256> BuildPunctuationTable() {
+  std::array<PunctuationEntry, 256> table{};
+  const auto set_single = [&table](char symbol, TokenKind token_kind) {
+    table[static_cast<unsigned char>(symbol)].single = token_kind;
+  };
+  const auto set_pair = [&table](std::string_view symbols,
+                                 TokenKind token_kind) {
+    auto& entry = table[static_cast<unsigned char>(symbols[0])];
+    entry.pair = token_kind;
+    entry.pair_second = symbols[1];
+  };
+
+  set_single('+', TokenKind::kOtherPlus);
+  set_single('-', TokenKind::kOtherMinus);
+  set_single('*', TokenKind::kOtherAsterisk);
+  set_single('/', TokenKind::kOtherSlash);
+  set_single('%', TokenKind::kOtherPercent);
+  set_single('^', TokenKind::kOtherCaret);
+  set_single('<', TokenKind::kOtherLessThan);
+  set_single('>', TokenKind::kOtherGreaterThan);
+  set_single('=', TokenKind::kOtherEqual);
+  set_single('(', TokenKind::kOtherLeftParenthesis);
+  set_single(')', TokenKind::kOtherRightParenthesis);
+  set_single(';', TokenKind::kOtherSemicolon);
+  set_single(',', TokenKind::kOtherComma);
+
+  set_pair("//", TokenKind::kOtherDoubleSlash);
+  set_pair("==", TokenKind::kOtherDoubleEqual);
+  set_pair("~=", TokenKind::kOtherTildeEqual);
+  set_pair("<=", TokenKind::kOtherLessThanEqual);
+  set_pair(">=", TokenKind::kOtherGreaterThanEqual);
+
+  return table;
+}
+
+inline constexpr auto kKeywordTable = BuildKeywordTable();
+inline constexpr auto kPunctuationTable = BuildPunctuationTable();
+
+}  // namespace detail
+
+// Returns kName for names that are not keywords.
+constexpr TokenKind FindKeyword(std::string_view name) noexcept {
+  if (name.size() < detail::kMinKeywordLength ||
+      name.size() > detail::kMaxKeywordLength) {
+    return TokenKind::kName;
+  }
+
+  const auto& entry = detail::kKeywordTable[detail::HashKeyword(name)];
+  return entry.text == name ? entry.token_kind : TokenKind::kName;
+}
+
+constexpr const PunctuationEntry& FindPunctuation(char symbol) noexcept {
+  return detail::kPunctuationTable[static_cast<unsigned char>(symbol)];
+}
 
 }  // namespace lualike::token
 
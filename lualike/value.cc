@@ -1,8 +1,10 @@
 #include "lualike/value.h"
 
 #include <cmath>
-#include <stdexcept>
+#include <expected>
+#include <memory>
 #include <type_traits>
+#include <utility>
 
 namespace lualike::value {
 
@@ -31,70 +33,89 @@ std::optional<LualikeValue::FloatT> CastToFloat(const T& value) {
   }
 }
 
-LualikeValue::BoolT TryAsBool(const LualikeValue& value,
-                              LualikeValueOpErrKind error_kind) {
-  try {
-    return std::get<LualikeValue::BoolT>(value.inner_value);
-  } catch (const std::bad_variant_access&) {
-    throw LualikeValueOpErr(error_kind);
+std::expected<LualikeValue::BoolT, LualikeValueOpErrKind> TryAsBool(
+    const LualikeValue& value, LualikeValueOpErrKind error_kind) noexcept {
+  if (const auto* bool_value =
+          std::get_if<LualikeValue::BoolT>(&value.inner_value)) {
+    return *bool_value;
   }
+
+  return std::unexpected(error_kind);
 }
 
 template <typename OperatorT>
-LualikeValue& PerformArithmeticBinOp(LualikeValue& lhs, const LualikeValue& rhs,
-                                     const OperatorT& operator_lambda) {
+LualikeValueOpResult PerformArithmeticBinOp(const LualikeValue& lhs,
+                                            const LualikeValue& rhs,
+                                            const OperatorT& operator_lambda) {
   const auto visitor = [&operator_lambda,
-                        &rhs](const auto& lhs_value) -> LualikeValue {
+                        &rhs](const auto& lhs_value) -> LualikeValueOpResult {
     using T = std::decay_t<decltype(lhs_value)>;
 
     if constexpr (std::is_same_v<T, LualikeValue::IntT>) {
-      if (std::holds_alternative<LualikeValue::IntT>(rhs.inner_value)) {
-        return {operator_lambda(lhs_value,
-                                std::get<LualikeValue::IntT>(rhs.inner_value))};
+      if (const auto* rhs_as_int =
+              std::get_if<LualikeValue::IntT>(&rhs.inner_value)) {
+        return LualikeValue{operator_lambda(lhs_value, *rhs_as_int)};
       }
 
       const auto lhs_as_float = CastToFloat(lhs_value);
       const auto rhs_as_float = CastToFloat(rhs);
       if (!rhs_as_float) {
-        throw LualikeValueOpErr(LualikeValueOpErrKind::kRhsNotNumeric);
+        return std::unexpected(LualikeValueOpErrKind::kRhsNotNumeric);
       }
 
-      return {operator_lambda(*lhs_as_float, *rhs_as_float)};
+      return LualikeValue{operator_lambda(*lhs_as_float, *rhs_as_float)};
     }
 
     if constexpr (std::is_same_v<T, LualikeValue::FloatT>) {
       const auto rhs_as_float = CastToFloat(rhs);
       if (!rhs_as_float) {
-        throw LualikeValueOpErr(LualikeValueOpErrKind::kRhsNotNumeric);
+        return std::unexpected(LualikeValueOpErrKind::kRhsNotNumeric);
       }
 
-      return {operator_lambda(lhs_value, *rhs_as_float)};
+      return LualikeValue{operator_lambda(lhs_value, *rhs_as_float)};
     }
 
-    throw LualikeValueOpErr(LualikeValueOpErrKind::kLhsNotNumeric);
+    return std::unexpected(LualikeValueOpErrKind::kLhsNotNumeric);
   };
 
-  lhs = std::visit(visitor, lhs.inner_value);
-  return lhs;
+  return std::visit(visitor, lhs.inner_value);
 }
 
 template <typename OperatorT>
-LualikeValue& PerformFloatBinOp(LualikeValue& lhs, const LualikeValue& rhs,
-                                const OperatorT& operator_lambda) {
+LualikeValueOpResult PerformFloatBinOp(const LualikeValue& lhs,
+                                       const LualikeValue& rhs,
+                                       const OperatorT& operator_lambda) {
   const auto lhs_as_float = CastToFloat(lhs);
   if (!lhs_as_float) {
-    throw LualikeValueOpErr(LualikeValueOpErrKind::kLhsNotNumeric);
+    return std::unexpected(LualikeValueOpErrKind::kLhsNotNumeric);
   }
 
   const auto rhs_as_float = CastToFloat(rhs);
   if (!rhs_as_float) {
-    throw LualikeValueOpErr(LualikeValueOpErrKind::kRhsNotNumeric);
+    return std::unexpected(LualikeValueOpErrKind::kRhsNotNumeric);
+  }
+
+  return LualikeValue{operator_lambda(*lhs_as_float, *rhs_as_float)};
+}
+
+// Assigns the result of a non-throwing operation to `lhs`, or throws its error.
+LualikeValue& AssignOrThrow(LualikeValue& lhs, LualikeValueOpResult result) {
+  if (!result) {
+    throw LualikeValueOpErr(result.error());
   }
 
-  lhs.inner_value = operator_lambda(*lhs_as_float, *rhs_as_float);
+  lhs = *std::move(result);
   return lhs;
 }
 
+LualikeValue ValueOrThrow(LualikeValueOpResult result) {
+  if (!result) {
+    throw LualikeValueOpErr(result.error());
+  }
+
+  return *std::move(result);
+}
+
 }  // namespace
 
 std::string LualikeValue::ToString() const {
@@ -115,7 +136,7 @@ std::string LualikeValue::ToString() const {
     }
 
     else if constexpr (std::is_same_v<T, LualikeValue::StringT>) {
-      return "String <" + std::string{value} + ">";
+      return "String <" + std::string{value.View()} + ">";
     }
 
     else if constexpr (std::is_same_v<T, LualikeValue::FuncT>) {
@@ -130,10 +151,17 @@ std::string LualikeValue::ToString() const {
   return std::visit(visitor, inner_value);
 }
 
-LualikeValue& LualikeValue::operator+=(const LualikeValue& rhs) {
+LualikeValueOpResult TryAdd(const LualikeValue& lhs,
+                            const LualikeValue& rhs) noexcept {
   return PerformArithmeticBinOp(
-      *this, rhs,
-      [](const auto lhs, const auto rhs_value) { return lhs + rhs_value; });
+      lhs, rhs,
+      [](const auto lhs_value, const auto rhs_value) {
+        return lhs_value + rhs_value;
+      });
+}
+
+LualikeValue& LualikeValue::operator+=(const LualikeValue& rhs) {
+  return AssignOrThrow(*this, TryAdd(*this, rhs));
 }
 
 LualikeValue operator+(LualikeValue lhs, const LualikeValue& rhs) {
@@ -141,10 +169,17 @@ LualikeValue operator+(LualikeValue lhs, const LualikeValue& rhs) {
   return lhs;
 }
 
-LualikeValue& LualikeValue::operator-=(const LualikeValue& rhs) {
+LualikeValueOpResult TrySubtract(const LualikeValue& lhs,
+                                 const LualikeValue& rhs) noexcept {
   return PerformArithmeticBinOp(
-      *this, rhs,
-      [](const auto lhs, const auto rhs_value) { return lhs - rhs_value; });
+      lhs, rhs,
+      [](const auto lhs_value, const auto rhs_value) {
+        return lhs_value - rhs_value;
+      });
+}
+
+LualikeValue& LualikeValue::operator-=(const LualikeValue& rhs) {
+  return AssignOrThrow(*this, TrySubtract(*this, rhs));
 }
 
 LualikeValue operator-(LualikeValue lhs, const LualikeValue& rhs) {
@@ -152,10 +187,17 @@ LualikeValue operator-(LualikeValue lhs, const LualikeValue& rhs) {
   return lhs;
 }
 
-LualikeValue& LualikeValue::operator*=(const LualikeValue& rhs) {
+LualikeValueOpResult TryMultiply(const LualikeValue& lhs,
+                                 const LualikeValue& rhs) noexcept {
   return PerformArithmeticBinOp(
-      *this, rhs,
-      [](const auto lhs, const auto rhs_value) { return lhs * rhs_value; });
+      lhs, rhs,
+      [](const auto lhs_value, const auto rhs_value) {
+        return lhs_value * rhs_value;
+      });
+}
+
+LualikeValue& LualikeValue::operator*=(const LualikeValue& rhs) {
+  return AssignOrThrow(*this, TryMultiply(*this, rhs));
 }
 
 LualikeValue operator*(LualikeValue lhs, const LualikeValue& rhs) {
@@ -163,10 +205,16 @@ LualikeValue operator*(LualikeValue lhs, const LualikeValue& rhs) {
   return lhs;
 }
 
+LualikeValueOpResult TryDivide(const LualikeValue& lhs,
+                               const LualikeValue& rhs) noexcept {
+  return PerformFloatBinOp(lhs, rhs,
+                           [](const auto lhs_value, const auto rhs_value) {
+                             return lhs_value / rhs_value;
+                           });
+}
+
 LualikeValue& LualikeValue::operator/=(const LualikeValue& rhs) {
-  return PerformFloatBinOp(
-      *this, rhs,
-      [](const auto lhs, const auto rhs_value) { return lhs / rhs_value; });
+  return AssignOrThrow(*this, TryDivide(*this, rhs));
 }
 
 LualikeValue operator/(LualikeValue lhs, const LualikeValue& rhs) {
@@ -174,11 +222,17 @@ LualikeValue operator/(LualikeValue lhs, const LualikeValue& rhs) {
   return lhs;
 }
 
+LualikeValueOpResult TryModulo(const LualikeValue& lhs,
+                               const LualikeValue& rhs) noexcept {
+  return PerformArithmeticBinOp(
+      lhs, rhs, [](const auto lhs_value, const auto rhs_value) {
+        return static_cast<LualikeValue::IntT>(
+            std::floor(std::fmod(lhs_value, rhs_value)));
+      });
+}
+
 LualikeValue& LualikeValue::operator%=(const LualikeValue& rhs) {
-  return PerformArithmeticBinOp(*this, rhs, [](auto lhs, const auto rhs_value) {
-    return static_cast<LualikeValue::IntT>(
-        std::floor(std::fmod(lhs, rhs_value)));
-  });
+  return AssignOrThrow(*this, TryModulo(*this, rhs));
 }
 
 LualikeValue operator%(LualikeValue lhs, const LualikeValue& rhs) {
@@ -186,64 +240,113 @@ LualikeValue operator%(LualikeValue lhs, const LualikeValue& rhs) {
   return lhs;
 }
 
-LualikeValue& LualikeValue::ExponentiateAndAssign(const LualikeValue& rhs) {
-  return PerformFloatBinOp(*this, rhs,
-                           [](const auto lhs, const auto rhs_value) {
-                             return std::pow(lhs, rhs_value);
+LualikeValueOpResult TryExponentiate(const LualikeValue& lhs,
+                                     const LualikeValue& rhs) noexcept {
+  return PerformFloatBinOp(lhs, rhs,
+                           [](const auto lhs_value, const auto rhs_value) {
+                             return std::pow(lhs_value, rhs_value);
                            });
 }
 
+LualikeValue& LualikeValue::ExponentiateAndAssign(const LualikeValue& rhs) {
+  return AssignOrThrow(*this, TryExponentiate(*this, rhs));
+}
+
 LualikeValue Exponentiate(LualikeValue lhs, const LualikeValue& rhs) {
   lhs.ExponentiateAndAssign(rhs);
   return lhs;
 }
 
-LualikeValue& LualikeValue::FloorDivideAndAssign(const LualikeValue& rhs) {
-  return PerformFloatBinOp(*this, rhs,
-                           [](const auto lhs, const auto rhs_value) {
-                             return std::floor(lhs / rhs_value);
+LualikeValueOpResult TryFloorDivide(const LualikeValue& lhs,
+                                    const LualikeValue& rhs) noexcept {
+  return PerformFloatBinOp(lhs, rhs,
+                           [](const auto lhs_value, const auto rhs_value) {
+                             return std::floor(lhs_value / rhs_value);
                            });
 }
 
+LualikeValue& LualikeValue::FloorDivideAndAssign(const LualikeValue& rhs) {
+  return AssignOrThrow(*this, TryFloorDivide(*this, rhs));
+}
+
 LualikeValue FloorDivide(LualikeValue lhs, const LualikeValue& rhs) {
   lhs.FloorDivideAndAssign(rhs);
   return lhs;
 }
 
-LualikeValue operator-(const LualikeValue& operand) {
-  const auto visitor = [](const auto& value) -> LualikeValue {
+LualikeValueOpResult TryNegate(const LualikeValue& operand) noexcept {
+  const auto visitor = [](const auto& value) -> LualikeValueOpResult {
     using T = std::decay_t<decltype(value)>;
 
     if constexpr (std::is_same_v<T, LualikeValue::IntT> ||
                   std::is_same_v<T, LualikeValue::FloatT>) {
-      return {-value};
+      return LualikeValue{-value};
     }
 
-    throw LualikeValueOpErr(LualikeValueOpErrKind::kNotNumericOperand);
+    return std::unexpected(LualikeValueOpErrKind::kNotNumericOperand);
   };
 
   return std::visit(visitor, operand.inner_value);
 }
 
-LualikeValue operator||(const LualikeValue& lhs, const LualikeValue& rhs) {
+LualikeValue operator-(const LualikeValue& operand) {
+  return ValueOrThrow(TryNegate(operand));
+}
+
+LualikeValueOpResult TryOr(const LualikeValue& lhs,
+                           const LualikeValue& rhs) noexcept {
   const auto lhs_as_bool = TryAsBool(lhs, LualikeValueOpErrKind::kLhsNotBool);
+  if (!lhs_as_bool) {
+    return std::unexpected(lhs_as_bool.error());
+  }
+
   const auto rhs_as_bool = TryAsBool(rhs, LualikeValueOpErrKind::kRhsNotBool);
+  if (!rhs_as_bool) {
+    return std::unexpected(rhs_as_bool.error());
+  }
 
-  return {lhs_as_bool || rhs_as_bool};
+  return LualikeValue{*lhs_as_bool || *rhs_as_bool};
 }
 
-LualikeValue operator&&(const LualikeValue& lhs, const LualikeValue& rhs) {
+LualikeValue operator||(const LualikeValue& lhs, const LualikeValue& rhs) {
+  return ValueOrThrow(TryOr(lhs, rhs));
+}
+
+LualikeValueOpResult TryAnd(const LualikeValue& lhs,
+                            const LualikeValue& rhs) noexcept {
   const auto lhs_as_bool = TryAsBool(lhs, LualikeValueOpErrKind::kLhsNotBool);
+  if (!lhs_as_bool) {
+    return std::unexpected(lhs_as_bool.error());
+  }
+
   const auto rhs_as_bool = TryAsBool(rhs, LualikeValueOpErrKind::kRhsNotBool);
+  if (!rhs_as_bool) {
+    return std::unexpected(rhs_as_bool.error());
+  }
 
-  return {lhs_as_bool && rhs_as_bool};
+  return LualikeValue{*lhs_as_bool && *rhs_as_bool};
 }
 
-LualikeValue operator!(const LualikeValue& operand) {
+LualikeValue operator&&(const LualikeValue& lhs, const LualikeValue& rhs) {
+  return ValueOrThrow(TryAnd(lhs, rhs));
+}
+
+LualikeValueOpResult TryNot(const LualikeValue& operand) noexcept {
   const auto operand_as_bool =
       TryAsBool(operand, LualikeValueOpErrKind::kNotBoolOperand);
+  if (!operand_as_bool) {
+    return std::unexpected(operand_as_bool.error());
+  }
+
+  return LualikeValue{!*operand_as_bool};
+}
+
+LualikeValue operator!(const LualikeValue& operand) {
+  return ValueOrThrow(TryNot(operand));
+}
 
-  return {!operand_as_bool};
+LualikeValue MakeHostFunction(HostFunction::CallbackT callback) {
+  return {std::make_shared<HostFunction>(std::move(callback))};
 }
 
 void PrintTo(const LualikeValue& value, std::ostream* out) {
@@ -4,13 +4,18 @@
 #include <compare>
 #include <cstdint>
 #include <exception>
+#include <expected>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <ostream>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
 
+#include "lualike/interned_string.h"
+
 namespace lualike::value {
 
 enum class LualikeValueOpErrKind : uint8_t {
@@ -58,15 +63,15 @@ struct LualikeValueOpErr : std::exception {
 
 struct LualikeValue;
 
+// A callable value. The arguments are a view of the caller's evaluation
+// stack, which must not be referenced after the call returns. Missing
+// arguments are nil, and extra ones are ignored. Functions that return no
+// value yield nil to the caller.
 struct LualikeFunction {
-  std::vector<std::string> args;
-
-  explicit LualikeFunction(std::vector<std::string>&& func_args) noexcept
-      : args(std::move(func_args)) {}
-
   virtual ~LualikeFunction() = default;
 
-  virtual std::optional<LualikeValue> Call(std::vector<LualikeValue> args) = 0;
+  virtual std::optional<LualikeValue> Call(
+      std::span<const LualikeValue> args) = 0;
 };
 
 struct LualikeValue {
@@ -74,7 +79,7 @@ struct LualikeValue {
   using BoolT = bool;
   using IntT = int64_t;
   using FloatT = double;
-  using StringT = std::string;
+  using StringT = InternedString;
   using FuncT = std::shared_ptr<LualikeFunction>;
 
   std::variant<NilT, BoolT, IntT, FloatT, StringT, FuncT> inner_value{NilT{}};
@@ -108,6 +113,55 @@ struct LualikeValue {
   friend LualikeValue operator!(const LualikeValue& operand);
 };
 
+// A function implemented by the host application, see MakeHostFunction.
+struct HostFunction final : LualikeFunction {
+  using CallbackT =
+      std::function<std::optional<LualikeValue>(std::span<const LualikeValue>)>;
+
+  CallbackT callback;
+
+  explicit HostFunction(CallbackT callback) noexcept
+      : callback(std::move(callback)) {}
+
+  std::optional<LualikeValue> Call(
+      std::span<const LualikeValue> args) override {
+    return callback(args);
+  }
+};
+
+// Wraps `callback` into a value that scripts can call, for example once it is
+// set as a global. Exceptions other than error::Error that it throws are
+// reported as errors of the call.
+LualikeValue MakeHostFunction(HostFunction::CallbackT callback);
+
+// The result of an operation that reports operands of the wrong type by value
+// instead of throwing a LualikeValueOpErr.
+using LualikeValueOpResult = std::expected<LualikeValue, LualikeValueOpErrKind>;
+
+// Non-throwing counterparts of the operators above, with the same semantics and
+// error kinds. The results of these operations never own heap memory.
+LualikeValueOpResult TryAdd(const LualikeValue& lhs,
+                            const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TrySubtract(const LualikeValue& lhs,
+                                 const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryMultiply(const LualikeValue& lhs,
+                                 const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryDivide(const LualikeValue& lhs,
+                               const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryModulo(const LualikeValue& lhs,
+                               const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryExponentiate(const LualikeValue& lhs,
+                                     const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryFloorDivide(const LualikeValue& lhs,
+                                    const LualikeValue& rhs) noexcept;
+
+LualikeValueOpResult TryNegate(const LualikeValue& operand) noexcept;
+LualikeValueOpResult TryOr(const LualikeValue& lhs,
+                           const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryAnd(const LualikeValue& lhs,
+                            const LualikeValue& rhs) noexcept;
+LualikeValueOpResult TryNot(const LualikeValue& operand) noexcept;
+
 void PrintTo(const LualikeValue& value, std::ostream* os);
 
 }  // namespace lualike::value
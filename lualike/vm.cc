@@ -0,0 +1,411 @@
+#include "lualike/vm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace lualike::vm {
+
+namespace {
+
+using bytecode::OpCode;
+using interpreter::Scope;
+using IntT = value::LualikeValue::IntT;
+using FloatT = value::LualikeValue::FloatT;
+
+constexpr size_t kInitialStackCapacity = 64;
+
+// Numeric operands are by far the most common, so they are handled here
+// without going through the visitor-based operators of LualikeValue. The
+// promotion rules mirror value.cc: integer operands stay integers for
+// "integer-preserving" operators and everything else is computed on floats.
+// Returns false when the generic path has to be taken instead.
+template <typename OperatorT>
+bool TryArithmeticFastPath(value::LualikeValue& lhs,
+                           const value::LualikeValue& rhs,
+                           bool preserves_integers,
+                           const OperatorT& operator_lambda) {
+  const auto* lhs_int = std::get_if<IntT>(&lhs.inner_value);
+  const auto* rhs_int = std::get_if<IntT>(&rhs.inner_value);
+  if (preserves_integers && lhs_int != nullptr && rhs_int != nullptr) {
+    lhs.inner_value = operator_lambda(*lhs_int, *rhs_int);
+    return true;
+  }
+
+  const auto* lhs_float = std::get_if<FloatT>(&lhs.inner_value);
+  const auto* rhs_float = std::get_if<FloatT>(&rhs.inner_value);
+  if ((lhs_int == nullptr && lhs_float == nullptr) ||
+      (rhs_int == nullptr && rhs_float == nullptr)) {
+    return false;
+  }
+
+  const FloatT lhs_value =
+      lhs_float != nullptr ? *lhs_float : static_cast<FloatT>(*lhs_int);
+  const FloatT rhs_value =
+      rhs_float != nullptr ? *rhs_float : static_cast<FloatT>(*rhs_int);
+  lhs.inner_value = operator_lambda(lhs_value, rhs_value);
+  return true;
+}
+
+// Same-typed numeric comparisons; mixed types are ordered by the variant
+// index, so they are left to the generic path.
+template <typename OperatorT>
+bool TryComparisonFastPath(value::LualikeValue& lhs,
+                           const value::LualikeValue& rhs,
+                           const OperatorT& operator_lambda) {
+  if (const auto* lhs_int = std::get_if<IntT>(&lhs.inner_value)) {
+    if (const auto* rhs_int = std::get_if<IntT>(&rhs.inner_value)) {
+      lhs.inner_value = static_cast<bool>(operator_lambda(*lhs_int, *rhs_int));
+      return true;
+    }
+  } else if (const auto* lhs_float = std::get_if<FloatT>(&lhs.inner_value)) {
+    if (const auto* rhs_float = std::get_if<FloatT>(&rhs.inner_value)) {
+      lhs.inner_value =
+          static_cast<bool>(operator_lambda(*lhs_float, *rhs_float));
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool TryFastPath(OpCode op, value::LualikeValue& lhs,
+                 const value::LualikeValue& rhs) {
+  switch (op) {
+    case OpCode::kAdd:
+      return TryArithmeticFastPath(
+          lhs, rhs, true, [](auto lhs_value, auto rhs_value) {
+            return lhs_value + rhs_value;
+          });
+    case OpCode::kSubtract:
+      return TryArithmeticFastPath(
+          lhs, rhs, true, [](auto lhs_value, auto rhs_value) {
+            return lhs_value - rhs_value;
+          });
+    case OpCode::kMultiply:
+      return TryArithmeticFastPath(
+          lhs, rhs, true, [](auto lhs_value, auto rhs_value) {
+            return lhs_value * rhs_value;
+          });
+    case OpCode::kDivide:
+      return TryArithmeticFastPath(
+          lhs, rhs, false, [](auto lhs_value, auto rhs_value) {
+            return lhs_value / rhs_value;
+          });
+    case OpCode::kFloorDivide:
+      return TryArithmeticFastPath(
+          lhs, rhs, false, [](auto lhs_value, auto rhs_value) {
+            return std::floor(lhs_value / rhs_value);
+          });
+    case OpCode::kModulo:
+      return TryArithmeticFastPath(
+          lhs, rhs, false, [](auto lhs_value, auto rhs_value) {
+            return static_cast<IntT>(
+                std::floor(std::fmod(lhs_value, rhs_value)));
+          });
+    case OpCode::kPower:
+      return TryArithmeticFastPath(
+          lhs, rhs, false, [](auto lhs_value, auto rhs_value) {
+            return std::pow(lhs_value, rhs_value);
+          });
+    case OpCode::kEqual:
+      return TryComparisonFastPath(lhs, rhs, std::equal_to{});
+    case OpCode::kNotEqual:
+      return TryComparisonFastPath(lhs, rhs, std::not_equal_to{});
+    case OpCode::kLessThan:
+      return TryComparisonFastPath(lhs, rhs, std::less{});
+    case OpCode::kLessThanEqual:
+      return TryComparisonFastPath(lhs, rhs, std::less_equal{});
+    case OpCode::kGreaterThan:
+      return TryComparisonFastPath(lhs, rhs, std::greater{});
+    case OpCode::kGreaterThanEqual:
+      return TryComparisonFastPath(lhs, rhs, std::greater_equal{});
+
+    default:
+      return false;
+  }
+}
+
+std::optional<value::LualikeValue> Run(
+    const std::shared_ptr<const bytecode::Chunk>& shared_chunk, Scope& globals,
+    std::vector<value::LualikeValue>& stack, size_t base);
+
+// A function declared by a script. Shares ownership of the chunk its own
+// chunk is part of, so it can be called after the program is gone. See
+// interpreter::FunctionGlobals for the globals it runs against.
+class BytecodeFunction final : public value::LualikeFunction {
+  std::shared_ptr<const bytecode::Chunk> chunk_;
+  interpreter::FunctionGlobals globals_;
+
+ public:
+  BytecodeFunction(std::shared_ptr<const bytecode::Chunk> chunk,
+                   Scope& globals) noexcept
+      : chunk_(std::move(chunk)), globals_(globals) {}
+
+  const std::shared_ptr<const bytecode::Chunk>& GetChunk() const noexcept {
+    return chunk_;
+  }
+
+  // Only used for calls from outside the VM, which run on a stack of their
+  // own.
+  std::optional<value::LualikeValue> Call(
+      std::span<const value::LualikeValue> args) override {
+    std::vector<value::LualikeValue> stack;
+    stack.reserve(kInitialStackCapacity);
+    stack.assign(args.begin(),
+                 args.begin() + std::min<size_t>(args.size(),
+                                                 chunk_->param_count));
+    std::shared_ptr<Scope> declared_globals;
+    return Run(chunk_, globals_.ForCall(declared_globals), stack, 0);
+  }
+};
+
+// Runs `chunk` with its frame at stack[base, base + frame_size), above which
+// it evaluates its expressions. The arguments of a function body are expected
+// at the start of the frame, the rest of which is filled with nil.
+//
+// Calls of BytecodeFunctions are run on the same stack: their arguments,
+// which were pushed right above the callee, become the start of their frame,
+// so neither the arguments nor the frame are copied or allocated separately.
+std::optional<value::LualikeValue> Run(
+    const std::shared_ptr<const bytecode::Chunk>& shared_chunk, Scope& globals,
+    std::vector<value::LualikeValue>& stack, size_t base) {
+  const auto& chunk = *shared_chunk;
+  stack.resize(base + chunk.frame_size);
+
+  const auto binary_op = [&stack, &chunk](ast::BinaryOperator op,
+                                          size_t ip) {
+    auto rhs = std::move(stack.back());
+    stack.pop_back();
+    if (TryFastPath(chunk.code[ip].op, stack.back(), rhs)) {
+      return;
+    }
+
+    stack.back() = interpreter::EvaluateBinaryOperator(
+        op, std::move(stack.back()), rhs, chunk.spans[ip]);
+  };
+
+  size_t ip = 0;
+  for (;;) {
+    const auto& instruction = chunk.code[ip];
+
+    switch (instruction.op) {
+      case OpCode::kConstant:
+        stack.push_back(chunk.constants[instruction.operand]);
+        break;
+
+      case OpCode::kGetLocal:
+        stack.push_back(stack[base + instruction.operand]);
+        break;
+
+      case OpCode::kSetLocal:
+        stack[base + instruction.operand] = std::move(stack.back());
+        stack.pop_back();
+        break;
+
+      case OpCode::kGetGlobal: {
+        const auto& name = chunk.names[instruction.operand];
+        auto variable = globals.Get(name);
+        if (!variable) {
+          throw interpreter::MakeInterpreterError(
+              std::format("Unknown variable: '{}'", name), chunk.spans[ip]);
+        }
+
+        stack.push_back(std::move(variable).value());
+        break;
+      }
+
+      case OpCode::kSetGlobal:
+        globals.Set(chunk.names[instruction.operand], stack.back());
+        stack.pop_back();
+        break;
+
+      case OpCode::kAssignGlobal: {
+        const auto& name = chunk.names[instruction.operand];
+        if (!globals.Get(name)) {
+          throw interpreter::MakeInterpreterError(
+              std::format("Unknown variable: '{}'", name), chunk.spans[ip]);
+        }
+
+        globals.Set(name, stack.back());
+        stack.pop_back();
+        break;
+      }
+
+      case OpCode::kPop:
+        stack.pop_back();
+        break;
+
+      case OpCode::kNegate:
+        stack.back() = interpreter::EvaluateUnaryOperator(
+            ast::UnaryOperator::kNegate, stack.back(), chunk.spans[ip]);
+        break;
+      case OpCode::kNot:
+        stack.back() = interpreter::EvaluateUnaryOperator(
+            ast::UnaryOperator::kNot, stack.back(), chunk.spans[ip]);
+        break;
+
+      case OpCode::kAdd:
+        binary_op(ast::BinaryOperator::kAdd, ip);
+        break;
+      case OpCode::kSubtract:
+        binary_op(ast::BinaryOperator::kSubtract, ip);
+        break;
+      case OpCode::kMultiply:
+        binary_op(ast::BinaryOperator::kMultiply, ip);
+        break;
+      case OpCode::kDivide:
+        binary_op(ast::BinaryOperator::kDivide, ip);
+        break;
+      case OpCode::kFloorDivide:
+        binary_op(ast::BinaryOperator::kFloorDivide, ip);
+        break;
+      case OpCode::kModulo:
+        binary_op(ast::BinaryOperator::kModulo, ip);
+        break;
+      case OpCode::kPower:
+        binary_op(ast::BinaryOperator::kPower, ip);
+        break;
+      case OpCode::kEqual:
+        binary_op(ast::BinaryOperator::kEqual, ip);
+        break;
+      case OpCode::kNotEqual:
+        binary_op(ast::BinaryOperator::kNotEqual, ip);
+        break;
+      case OpCode::kLessThan:
+        binary_op(ast::BinaryOperator::kLessThan, ip);
+        break;
+      case OpCode::kLessThanEqual:
+        binary_op(ast::BinaryOperator::kLessThanEqual, ip);
+        break;
+      case OpCode::kGreaterThan:
+        binary_op(ast::BinaryOperator::kGreaterThan, ip);
+        break;
+      case OpCode::kGreaterThanEqual:
+        binary_op(ast::BinaryOperator::kGreaterThanEqual, ip);
+        break;
+
+      case OpCode::kJump:
+        ip = instruction.operand;
+        continue;
+
+      case OpCode::kJumpIfFalse: {
+        const bool condition = interpreter::IsTruthy(stack.back());
+        stack.pop_back();
+        if (!condition) {
+          ip = instruction.operand;
+          continue;
+        }
+        break;
+      }
+
+      case OpCode::kJumpIfFalseOrPop:
+        if (!interpreter::IsTruthy(stack.back())) {
+          ip = instruction.operand;
+          continue;
+        }
+        stack.pop_back();
+        break;
+
+      case OpCode::kJumpIfTrueOrPop:
+        if (interpreter::IsTruthy(stack.back())) {
+          ip = instruction.operand;
+          continue;
+        }
+        stack.pop_back();
+        break;
+
+      case OpCode::kFunction:
+        stack.push_back({std::make_shared<BytecodeFunction>(
+            std::shared_ptr<const bytecode::Chunk>(
+                shared_chunk, &chunk.functions[instruction.operand]),
+            globals)});
+        break;
+
+      case OpCode::kCall: {
+        const size_t argument_count = instruction.operand;
+        const size_t callee_index = stack.size() - argument_count - 1;
+        const auto* function = std::get_if<value::LualikeValue::FuncT>(
+            &stack[callee_index].inner_value);
+        // The callee stays on the stack, which keeps it alive during the call.
+        const auto* script_function =
+            function != nullptr
+                ? dynamic_cast<const BytecodeFunction*>(function->get())
+                : nullptr;
+
+        value::LualikeValue result;
+        if (script_function != nullptr) {
+          const auto& callee_chunk = script_function->GetChunk();
+          const interpreter::detail::CallDepthGuard guard(chunk.spans[ip]);
+          if (argument_count > callee_chunk->param_count) {
+            stack.resize(callee_index + 1 + callee_chunk->param_count);
+          }
+          result = Run(callee_chunk, globals, stack, callee_index + 1)
+                       .value_or(value::LualikeValue{});
+        } else {
+          result = interpreter::CallFunction(
+              stack[callee_index],
+              std::span(stack).subspan(callee_index + 1, argument_count),
+              chunk.spans[ip]);
+        }
+
+        stack.resize(callee_index);
+        stack.push_back(std::move(result));
+        break;
+      }
+
+      case OpCode::kReturn:
+        return std::move(stack.back());
+
+      case OpCode::kUnimplemented:
+        throw interpreter::MakeInterpreterError("Unimplemented expression type",
+                                                chunk.spans[ip]);
+
+      case OpCode::kHalt:
+        return std::nullopt;
+    }
+
+    ++ip;
+  }
+}
+
+}  // namespace
+
+std::optional<value::LualikeValue> Execute(
+    const std::shared_ptr<const bytecode::Chunk>& chunk,
+    std::shared_ptr<Scope> globals) {
+  // The stack of the outermost run on the thread is kept for the next one,
+  // so that running a program many times doesn't allocate a stack per run.
+  // Runs started from host functions get a stack of their own, since the
+  // arguments of the host function still refer to the kept one.
+  thread_local std::vector<value::LualikeValue> kept_stack;
+  thread_local bool is_kept_stack_in_use = false;
+
+  const interpreter::RunningGlobals running(*globals);
+  if (is_kept_stack_in_use) {
+    std::vector<value::LualikeValue> stack;
+    stack.reserve(kInitialStackCapacity);
+    return Run(chunk, *globals, stack, 0);
+  }
+
+  struct KeptStackLease {
+    KeptStackLease() noexcept { is_kept_stack_in_use = true; }
+    KeptStackLease(const KeptStackLease&) = delete;
+    KeptStackLease& operator=(const KeptStackLease&) = delete;
+    ~KeptStackLease() {
+      kept_stack.clear();
+      is_kept_stack_in_use = false;
+    }
+  } lease;
+  return Run(chunk, *globals, kept_stack, 0);
+}
+
+}  // namespace lualike::vm
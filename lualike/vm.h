@@ -0,0 +1,22 @@
+#ifndef LUALIKE_VM_H_
+#define LUALIKE_VM_H_
+
+#include <memory>
+#include <optional>
+
+#include "lualike/bytecode.h"
+#include "lualike/runtime.h"
+#include "lualike/value.h"
+
+namespace lualike::vm {
+
+// Runs a chunk produced by bytecode::Compile with the same semantics as the
+// tree-walking interpreter. Like interpreter::VisitBlock, script errors are
+// reported by throwing error::Error. Functions declared by the chunk share it.
+std::optional<value::LualikeValue> Execute(
+    const std::shared_ptr<const bytecode::Chunk>& chunk,
+    std::shared_ptr<interpreter::Scope> globals);
+
+}  // namespace lualike::vm
+
+#endif  // LUALIKE_VM_H_